@@ -9,12 +9,26 @@
 
 #include "camera.h"
 #include "system.h"
+#include "uniform_block.h"
+#include <string.h>
 
 /**********************************************************************
-                            LITERAL CONSTANTS
+                               TYPES
 **********************************************************************/
 
-#define VIEW_PROJECTION_UNIFORM "projection_view_matrix"
+/* std140 layout of camera_block */
+typedef struct camera_block_data_struct
+{
+    mat4_type   projection_view_matrix;
+    vec3_type   position;
+    GLfloat     padding;
+} camera_block_data_type;
+
+/**********************************************************************
+                             VARIABLES
+**********************************************************************/
+
+static uniform_block_type * camera_block;
 
 /**********************************************************************
                                FUNCTIONS
@@ -28,13 +42,90 @@ void camera_init
     system_set_camera( camera );
 }
 
+void camera_block_init
+    (
+        void
+    )
+{
+    camera_block = uniform_block_create( UNIFORM_BLOCK_BINDING_CAMERA, sizeof( camera_block_data_type ) );
+}
+
+void camera_block_deinit
+    (
+        void
+    )
+{
+    uniform_block_free( camera_block );
+}
+
 void camera_set_active
+    (
+        camera_type const * camera
+    )
+{
+    camera_block_data_type data;
+
+    /* Padding is compared too, so it must be cleared */
+    memset( &data, 0, sizeof( data ) );
+    data.projection_view_matrix = camera->projection_view_matrix;
+    data.position               = camera->position;
+
+    uniform_block_update( camera_block, &data );
+}
+
+void camera_get_frustum
     (
         camera_type const * camera,
-        shader_type const * shader
+        frustum_type      * frustum
+    )
+{
+    mat4_type const   * m;
+    vec4_type         * plane;
+    GLfloat             length;
+    uint8_t             i;
+
+    m = &camera->projection_view_matrix;
+
+    /* Clip space is inside where -w <= x, y, z <= w, so each plane is the w row plus or minus another row */
+    vec4_set( &frustum->planes[FRUSTUM_PLANE_LEFT],   m->x.w + m->x.x, m->y.w + m->y.x, m->z.w + m->z.x, m->w.w + m->w.x );
+    vec4_set( &frustum->planes[FRUSTUM_PLANE_RIGHT],  m->x.w - m->x.x, m->y.w - m->y.x, m->z.w - m->z.x, m->w.w - m->w.x );
+    vec4_set( &frustum->planes[FRUSTUM_PLANE_BOTTOM], m->x.w + m->x.y, m->y.w + m->y.y, m->z.w + m->z.y, m->w.w + m->w.y );
+    vec4_set( &frustum->planes[FRUSTUM_PLANE_TOP],    m->x.w - m->x.y, m->y.w - m->y.y, m->z.w - m->z.y, m->w.w - m->w.y );
+    vec4_set( &frustum->planes[FRUSTUM_PLANE_NEAR],   m->x.w + m->x.z, m->y.w + m->y.z, m->z.w + m->z.z, m->w.w + m->w.z );
+    vec4_set( &frustum->planes[FRUSTUM_PLANE_FAR],    m->x.w - m->x.z, m->y.w - m->y.z, m->z.w - m->z.z, m->w.w - m->w.z );
+
+    /* Unit normals make the plane equation a distance, so spheres can be tested against it */
+    for( i = 0; i < FRUSTUM_PLANE_COUNT; ++i )
+    {
+        plane = &frustum->planes[i];
+        length = (GLfloat)sqrt( plane->x * plane->x + plane->y * plane->y + plane->z * plane->z );
+        if( length > 0.0f )
+        {
+            vec4_set( plane, plane->x / length, plane->y / length, plane->z / length, plane->w / length );
+        }
+    }
+}
+
+boolean frustum_test_sphere
+    (
+        frustum_type const  * frustum,
+        vec3_type const     * centre,
+        GLfloat               radius
     )
 {
-    shader_set_uniform_mat4( shader, VIEW_PROJECTION_UNIFORM, &( camera->projection_view_matrix ) );
+    vec4_type const   * plane;
+    uint8_t             i;
+
+    for( i = 0; i < FRUSTUM_PLANE_COUNT; ++i )
+    {
+        plane = &frustum->planes[i];
+        if( plane->x * centre->x + plane->y * centre->y + plane->z * centre->z + plane->w < -radius )
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
 }
 
 void camera_set_view
@@ -40,12 +40,58 @@ void camera_init
     );
 
 /**
- * @brief Sets a camera as the one to use on a particular shader
+ * @brief Create the camera uniform block, needs a current openGL context
+ */
+void camera_block_init
+    (
+        void
+    );
+
+/**
+ * @brief Delete the camera uniform block
+ */
+void camera_block_deinit
+    (
+        void
+    );
+
+/**
+ * @brief Sets a camera as the one to draw with, shaders read it from the
+ *        camera_block uniform block:
+ *
+ *        layout(std140) uniform camera_block
+ *        {
+ *            mat4 projection_view_matrix;
+ *            vec3 camera_position;
+ *        };
+ *
+ *        Nothing is uploaded if the camera hasn't changed since it was
+ *        last set
  */
 void camera_set_active
+    (
+        camera_type const * camera
+    );
+
+/**
+ * @brief Get the planes of the volume a camera sees
+ */
+void camera_get_frustum
     (
         camera_type const * camera,
-        shader_type const * shader
+        frustum_type      * frustum
+    );
+
+/**
+ * @brief Test whether any part of a sphere is inside a frustum
+ *
+ * @return FALSE only if the sphere is fully outside one of the planes
+ */
+boolean frustum_test_sphere
+    (
+        frustum_type const  * frustum,
+        vec3_type const     * centre,
+        GLfloat               radius
     );
 
 /**
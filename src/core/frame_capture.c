@@ -0,0 +1,462 @@
+/**
+ * @file frame_capture.c
+ *
+ * @brief Implementation of the offscreen frame capture
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+/* Needed for popen and snprintf, must come before any system header */
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "frame_capture.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define BYTES_PER_PIXEL     ( 3 )           /* RGB */
+#define FILE_NAME_LENGTH    ( 256 )
+#define FENCE_TIMEOUT       ( 1000000 )     /* ns, between checks while waiting on the GPU */
+
+#ifdef _WIN32
+    #define popen           _popen
+    #define pclose          _pclose
+    #define PIPE_MODE       "wb"
+#else
+    #define PIPE_MODE       "w"
+#endif
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+struct frame_capture_struct
+{
+    GLuint              framebuffer_object;
+    GLuint              colour_renderbuffer;
+    GLuint              depth_renderbuffer;
+    GLuint              pixel_buffers[FRAME_CAPTURE_BUFFER_COUNT];  /* Frame n is read into pixel_buffers[n % FRAME_CAPTURE_BUFFER_COUNT] */
+    GLsync              fences[FRAME_CAPTURE_BUFFER_COUNT];         /* Signalled when the frame's copy into the pixel buffer is done */
+    uint32_t            width;
+    uint32_t            height;
+    uint32_t            frame_size;                                 /* Bytes */
+    uint32_t            read_count;                                 /* Frames read into pixel buffers */
+    uint32_t            collect_count;                              /* Frames copied out of pixel buffers into the queue */
+    sint8_t const     * output_pattern;
+    FILE              * encoder;                                    /* NULL when writing files */
+
+    /* Writer thread */
+    pthread_t           writer;
+    pthread_mutex_t     lock;                                       /* Protects everything below */
+    pthread_cond_t      frame_queued;
+    pthread_cond_t      frame_written;
+    uint8_t           * queue[FRAME_CAPTURE_QUEUE_LENGTH];          /* Frame n waits in queue[n % FRAME_CAPTURE_QUEUE_LENGTH] */
+    uint32_t            write_count;                                /* Frames written out */
+    boolean             stop;
+};
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Check a file name pattern is safe to format with the frame number,
+ *        exactly one integer conversion and no other % but %%
+ */
+static boolean pattern_valid
+    (
+        sint8_t const * pattern
+    );
+
+/**
+ * @brief Copy the oldest frame out of its pixel buffer into the writer's
+ *        queue, if its copy has finished or wait is set
+ *
+ * @return TRUE if a frame was collected
+ */
+static boolean collect_frame
+    (
+        frame_capture_type    * capture,
+        boolean                 wait
+    );
+
+/**
+ * @brief Entry point of the writer thread
+ */
+static void * writer_main
+    (
+        void * argument
+    );
+
+/**
+ * @brief Write one frame to its file or the encoder
+ */
+static void write_frame
+    (
+        frame_capture_type    * capture,
+        uint32_t                frame,
+        uint8_t const         * pixels  /* Top down */
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+frame_capture_type * frame_capture_create
+    (
+        uint32_t          width,
+        uint32_t          height,
+        sint8_t const   * output_pattern,
+        sint8_t const   * encoder_command
+    )
+{
+    frame_capture_type    * capture;
+    GLenum                  status;
+    uint32_t                i;
+
+    /* The pattern becomes the format of the writer's snprintf, anything but one integer conversion is undefined there */
+    if( ( NULL == encoder_command ) && !pattern_valid( output_pattern ) )
+    {
+        printf( "Frame pattern %s needs exactly one integer conversion for the frame number, and %%%% for a literal %%\n", output_pattern );
+        return NULL;
+    }
+
+    capture = calloc( 1, sizeof( frame_capture_type ) );
+
+    capture->width          = width;
+    capture->height         = height;
+    capture->frame_size     = width * height * BYTES_PER_PIXEL;
+    capture->output_pattern = output_pattern;
+
+    glGenRenderbuffers( 1, &capture->colour_renderbuffer );
+    glBindRenderbuffer( GL_RENDERBUFFER, capture->colour_renderbuffer );
+    glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, width, height );
+
+    glGenRenderbuffers( 1, &capture->depth_renderbuffer );
+    glBindRenderbuffer( GL_RENDERBUFFER, capture->depth_renderbuffer );
+    glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height );
+    glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+    glGenFramebuffers( 1, &capture->framebuffer_object );
+    glBindFramebuffer( GL_FRAMEBUFFER, capture->framebuffer_object );
+    glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, capture->colour_renderbuffer );
+    glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, capture->depth_renderbuffer );
+    status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+    glGenBuffers( FRAME_CAPTURE_BUFFER_COUNT, capture->pixel_buffers );
+    for( i = 0; i < FRAME_CAPTURE_BUFFER_COUNT; ++i )
+    {
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, capture->pixel_buffers[i] );
+        glBufferData( GL_PIXEL_PACK_BUFFER, capture->frame_size, NULL, GL_STREAM_READ );
+    }
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+    for( i = 0; i < FRAME_CAPTURE_QUEUE_LENGTH; ++i )
+    {
+        capture->queue[i] = malloc( capture->frame_size );
+    }
+
+    if( NULL != encoder_command )
+    {
+        capture->encoder = popen( encoder_command, PIPE_MODE );
+    }
+
+    pthread_mutex_init( &capture->lock, NULL );
+    pthread_cond_init( &capture->frame_queued, NULL );
+    pthread_cond_init( &capture->frame_written, NULL );
+    pthread_create( &capture->writer, NULL, writer_main, capture );
+
+    if( ( GL_FRAMEBUFFER_COMPLETE != status ) || ( ( NULL != encoder_command ) && ( NULL == capture->encoder ) ) )
+    {
+        frame_capture_free( capture );
+        return NULL;
+    }
+
+    return capture;
+}
+
+void frame_capture_free
+    (
+        frame_capture_type * capture
+    )
+{
+    uint32_t i;
+
+    while( capture->collect_count < capture->read_count )
+    {
+        collect_frame( capture, TRUE );
+    }
+
+    /* The writer finishes the queue before it stops */
+    pthread_mutex_lock( &capture->lock );
+    capture->stop = TRUE;
+    pthread_cond_signal( &capture->frame_queued );
+    pthread_mutex_unlock( &capture->lock );
+    pthread_join( capture->writer, NULL );
+
+    pthread_cond_destroy( &capture->frame_written );
+    pthread_cond_destroy( &capture->frame_queued );
+    pthread_mutex_destroy( &capture->lock );
+
+    if( NULL != capture->encoder )
+    {
+        pclose( capture->encoder );
+    }
+
+    for( i = 0; i < FRAME_CAPTURE_QUEUE_LENGTH; ++i )
+    {
+        free( capture->queue[i] );
+    }
+
+    glDeleteBuffers( FRAME_CAPTURE_BUFFER_COUNT, capture->pixel_buffers );
+    glDeleteFramebuffers( 1, &capture->framebuffer_object );
+    glDeleteRenderbuffers( 1, &capture->colour_renderbuffer );
+    glDeleteRenderbuffers( 1, &capture->depth_renderbuffer );
+    free( capture );
+}
+
+void frame_capture_begin
+    (
+        frame_capture_type * capture
+    )
+{
+    glBindFramebuffer( GL_FRAMEBUFFER, capture->framebuffer_object );
+}
+
+void frame_capture_end
+    (
+        frame_capture_type * capture
+    )
+{
+    uint32_t buffer;
+
+    /* Only wait on the GPU when every pixel buffer still holds a frame */
+    if( capture->read_count - capture->collect_count == FRAME_CAPTURE_BUFFER_COUNT )
+    {
+        collect_frame( capture, TRUE );
+    }
+
+    /* Rows are packed with no padding, the read returns straight away and the copy finishes on the GPU */
+    buffer = capture->read_count % FRAME_CAPTURE_BUFFER_COUNT;
+    glBindFramebuffer( GL_READ_FRAMEBUFFER, capture->framebuffer_object );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, capture->pixel_buffers[buffer] );
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    glReadPixels( 0, 0, capture->width, capture->height, GL_RGB, GL_UNSIGNED_BYTE, NULL );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+    capture->fences[buffer] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    capture->read_count += 1;
+
+    /* Pass on whatever the GPU has finished without waiting for the rest */
+    while( ( capture->collect_count < capture->read_count ) && collect_frame( capture, FALSE ) )
+    {
+    }
+}
+
+static boolean collect_frame
+    (
+        frame_capture_type    * capture,
+        boolean                 wait
+    )
+{
+    uint32_t            buffer;
+    GLenum              status;
+    uint8_t const     * pixels;
+    uint8_t           * frame;
+    uint32_t            row_size;
+    uint32_t            row;
+
+    buffer = capture->collect_count % FRAME_CAPTURE_BUFFER_COUNT;
+
+    /* Flush on the first check so the fence is sure to be reached */
+    status = glClientWaitSync( capture->fences[buffer], GL_SYNC_FLUSH_COMMANDS_BIT, wait ? FENCE_TIMEOUT : 0 );
+    while( wait && ( GL_TIMEOUT_EXPIRED == status ) )
+    {
+        status = glClientWaitSync( capture->fences[buffer], 0, FENCE_TIMEOUT );
+    }
+
+    if( GL_TIMEOUT_EXPIRED == status )
+    {
+        return FALSE;
+    }
+
+    glDeleteSync( capture->fences[buffer] );
+    capture->fences[buffer] = NULL;
+
+    /* Wait for a free queue slot, only if the writer is a whole queue behind */
+    pthread_mutex_lock( &capture->lock );
+    while( capture->collect_count - capture->write_count == FRAME_CAPTURE_QUEUE_LENGTH )
+    {
+        pthread_cond_wait( &capture->frame_written, &capture->lock );
+    }
+    pthread_mutex_unlock( &capture->lock );
+
+    frame = capture->queue[capture->collect_count % FRAME_CAPTURE_QUEUE_LENGTH];
+
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, capture->pixel_buffers[buffer] );
+    pixels = glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY );
+
+    if( NULL != pixels )
+    {
+        /* openGL rows go bottom up, images top down */
+        row_size = capture->width * BYTES_PER_PIXEL;
+        for( row = 0; row < capture->height; ++row )
+        {
+            memcpy( &frame[row * row_size], &pixels[( capture->height - 1 - row ) * row_size], row_size );
+        }
+
+        glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+    }
+
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+    pthread_mutex_lock( &capture->lock );
+    capture->collect_count += 1;
+    pthread_cond_signal( &capture->frame_queued );
+    pthread_mutex_unlock( &capture->lock );
+
+    return TRUE;
+}
+
+static void * writer_main
+    (
+        void * argument
+    )
+{
+    frame_capture_type    * capture;
+    uint32_t                frame;
+
+    capture = (frame_capture_type *)argument;
+
+    pthread_mutex_lock( &capture->lock );
+
+    while( TRUE )
+    {
+        while( ( capture->write_count == capture->collect_count ) && !capture->stop )
+        {
+            pthread_cond_wait( &capture->frame_queued, &capture->lock );
+        }
+
+        if( capture->write_count == capture->collect_count )
+        {
+            break;
+        }
+
+        /* The slot is only reused after write_count moves past it, so it can be written unlocked */
+        frame = capture->write_count;
+        pthread_mutex_unlock( &capture->lock );
+
+        write_frame( capture, frame, capture->queue[frame % FRAME_CAPTURE_QUEUE_LENGTH] );
+
+        pthread_mutex_lock( &capture->lock );
+        capture->write_count += 1;
+        pthread_cond_signal( &capture->frame_written );
+    }
+
+    pthread_mutex_unlock( &capture->lock );
+
+    return NULL;
+}
+
+static void write_frame
+    (
+        frame_capture_type    * capture,
+        uint32_t                frame,
+        uint8_t const         * pixels
+    )
+{
+    sint8_t             file_name[FILE_NAME_LENGTH];
+    FILE              * file;
+    int                 length;
+
+    if( NULL != capture->encoder )
+    {
+        fwrite( pixels, 1, capture->frame_size, capture->encoder );
+        return;
+    }
+
+    /* The pattern comes from the user, a name it makes that doesn't fit is dropped rather than cut short */
+    length = snprintf( file_name, sizeof( file_name ), capture->output_pattern, frame );
+    if( ( length < 0 ) || ( (size_t)length >= sizeof( file_name ) ) )
+    {
+        printf( "Can't write frame %u, the file name is longer than %d characters\n", frame, FILE_NAME_LENGTH - 1 );
+        return;
+    }
+
+    file = fopen( file_name, "wb" );
+    if( NULL == file )
+    {
+        printf( "Can't write frame %s\n", file_name );
+        return;
+    }
+
+    fprintf( file, "P6\n%d %d\n255\n", capture->width, capture->height );
+    fwrite( pixels, 1, capture->frame_size, file );
+    fclose( file );
+}
+
+static boolean pattern_valid
+    (
+        sint8_t const * pattern
+    )
+{
+    sint8_t const * c;
+    uint32_t        conversion_count;
+
+    conversion_count = 0;
+
+    for( c = pattern; '\0' != *c; ++c )
+    {
+        if( '%' != *c )
+        {
+            continue;
+        }
+
+        c += 1;
+        if( '%' == *c )
+        {
+            continue;
+        }
+
+        /* Flags, width and precision, but no * or length modifier since the one argument is a uint32_t */
+        while( ( '\0' != *c ) && ( NULL != strchr( "-+ #0", *c ) ) )
+        {
+            c += 1;
+        }
+
+        while( isdigit( (unsigned char)*c ) )
+        {
+            c += 1;
+        }
+
+        if( '.' == *c )
+        {
+            c += 1;
+            while( isdigit( (unsigned char)*c ) )
+            {
+                c += 1;
+            }
+        }
+
+        if( ( '\0' == *c ) || ( NULL == strchr( "diouxX", *c ) ) )
+        {
+            return FALSE;
+        }
+
+        conversion_count += 1;
+    }
+
+    return ( 1 == conversion_count );
+}
@@ -0,0 +1,75 @@
+/**
+ * @file frame_capture.h
+ *
+ * @brief Offscreen render target that records every frame drawn into it
+ *
+ * Frames are drawn into a framebuffer object and read back into a ring
+ * of pixel buffer objects, each fenced so a frame is only mapped once
+ * its copy has finished on the GPU. Finished frames are handed to a
+ * writer thread, which writes them to image files or pipes them to an
+ * encoder process, so the render loop waits on neither the GPU copy nor
+ * the disk.
+ */
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "system_types.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define FRAME_CAPTURE_BUFFER_COUNT  ( 3 )   /* Frames being read back by the GPU at once */
+#define FRAME_CAPTURE_QUEUE_LENGTH  ( 8 )   /* Frames waiting on the writer thread, rendering waits when it falls this far behind */
+
+/* frame_capture_type is declared in system_types.h, it should only be accessed with interface functions below */
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Create a capture target, needs a current openGL context
+ *
+ * @return NULL if the framebuffer can't be made or the encoder can't be started
+ */
+frame_capture_type * frame_capture_create
+    (
+        uint32_t          width,
+        uint32_t          height,
+        sint8_t const   * output_pattern,  /* printf pattern of the frame file names with exactly one integer conversion for the frame number and %% for a literal %, e.g. "frames/%05u.ppm". Must outlive the capture */
+        sint8_t const   * encoder_command  /* (Optional) Shell command to pipe raw top down rgb24 frames to instead of writing files, e.g. an ffmpeg reading -f rawvideo from stdin */
+    );
+
+/**
+ * @brief Write every frame still being read back, wait for the writer
+ *        to finish and delete the capture target
+ */
+void frame_capture_free
+    (
+        frame_capture_type * capture
+    );
+
+/**
+ * @brief Draw into the capture target until frame_capture_end
+ */
+void frame_capture_begin
+    (
+        frame_capture_type * capture
+    );
+
+/**
+ * @brief Start reading back the frame drawn since frame_capture_begin and
+ *        pass any earlier frames that have finished to the writer. Files
+ *        are written as binary PPM.
+ */
+void frame_capture_end
+    (
+        frame_capture_type * capture
+    );
+
+#endif /* FRAME_CAPTURE_H */
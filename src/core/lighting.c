@@ -0,0 +1,106 @@
+/**
+ * @file lighting.c
+ *
+ * @brief Implementation of the shared light and material state
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "lighting.h"
+#include "uniform_block.h"
+#include <string.h>
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+/* std140 puts every vec3 on a 16 byte boundary */
+typedef struct light_block_data_struct
+{
+    vec3_type   position;
+    GLfloat     padding_0;
+    vec3_type   ambient;
+    GLfloat     padding_1;
+    vec3_type   diffuse;
+    GLfloat     padding_2;
+    vec3_type   specular;
+    GLfloat     padding_3;
+    vec3_type   attenuation;
+    GLfloat     padding_4;
+} light_block_data_type;
+
+/* A float packs into the end of the vec3 before it */
+typedef struct material_block_data_struct
+{
+    vec3_type   ambient;
+    GLfloat     padding_0;
+    vec3_type   diffuse;
+    GLfloat     padding_1;
+    vec3_type   specular;
+    GLfloat     shininess;
+} material_block_data_type;
+
+/**********************************************************************
+                             VARIABLES
+**********************************************************************/
+
+static uniform_block_type * light_block;
+static uniform_block_type * material_block;
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void lighting_init
+    (
+        void
+    )
+{
+    light_block     = uniform_block_create( UNIFORM_BLOCK_BINDING_LIGHT, sizeof( light_block_data_type ) );
+    material_block  = uniform_block_create( UNIFORM_BLOCK_BINDING_MATERIAL, sizeof( material_block_data_type ) );
+}
+
+void lighting_deinit
+    (
+        void
+    )
+{
+    uniform_block_free( light_block );
+    uniform_block_free( material_block );
+}
+
+void lighting_set_light
+    (
+        light_type const * light
+    )
+{
+    light_block_data_type data;
+
+    /* Padding is compared too, so it must be cleared */
+    memset( &data, 0, sizeof( data ) );
+    data.position       = light->position;
+    data.ambient        = light->ambient;
+    data.diffuse        = light->diffuse;
+    data.specular       = light->specular;
+    data.attenuation    = light->attenuation;
+
+    uniform_block_update( light_block, &data );
+}
+
+void lighting_set_material
+    (
+        material_type const * material
+    )
+{
+    material_block_data_type data;
+
+    memset( &data, 0, sizeof( data ) );
+    data.ambient    = material->ambient;
+    data.diffuse    = material->diffuse;
+    data.specular   = material->specular;
+    data.shininess  = material->shininess;
+
+    uniform_block_update( material_block, &data );
+}
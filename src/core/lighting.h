@@ -0,0 +1,97 @@
+/**
+ * @file lighting.h
+ *
+ * @brief Light and material state shared by every shader through
+ *        uniform blocks
+ *
+ * Shaders declare the blocks they use:
+ *
+ *        layout(std140) uniform light_block
+ *        {
+ *            vec3 light_position;
+ *            vec3 light_ambient;
+ *            vec3 light_diffuse;
+ *            vec3 light_specular;
+ *            vec3 light_attenuation;
+ *        };
+ *
+ *        layout(std140) uniform material_block
+ *        {
+ *            vec3  material_ambient;
+ *            vec3  material_diffuse;
+ *            vec3  material_specular;
+ *            float material_shininess;
+ *        };
+ */
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "system_types.h"
+
+/**********************************************************************
+                                 TYPES
+**********************************************************************/
+
+/* A point light */
+typedef struct light_struct
+{
+    vec3_type   position;
+    vec3_type   ambient;
+    vec3_type   diffuse;
+    vec3_type   specular;
+    vec3_type   attenuation;    /* Constant, linear and quadratic falloff with distance */
+} light_type;
+
+/* How a surface reflects light */
+typedef struct material_struct
+{
+    vec3_type   ambient;
+    vec3_type   diffuse;
+    vec3_type   specular;
+    GLfloat     shininess;
+} material_type;
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Create the light and material uniform blocks, needs a current
+ *        openGL context
+ */
+void lighting_init
+    (
+        void
+    );
+
+/**
+ * @brief Delete the light and material uniform blocks
+ */
+void lighting_deinit
+    (
+        void
+    );
+
+/**
+ * @brief Set the light every shader draws with, nothing is uploaded if
+ *        it hasn't changed
+ */
+void lighting_set_light
+    (
+        light_type const * light
+    );
+
+/**
+ * @brief Set the material every shader draws with, nothing is uploaded
+ *        if it hasn't changed
+ */
+void lighting_set_material
+    (
+        material_type const * material
+    );
+
+#endif /* LIGHTING_H */
@@ -63,7 +63,7 @@ void camera_util_init
 {
     system_listener_callbacks_type callbacks;
 
-
+    memset( &callbacks, 0, sizeof( callbacks ) );
     callbacks.frame_event_cb    = frame_cb;
     callbacks.system_event_cb   = system_cb;
     register_system_listeners( &callbacks );
@@ -42,11 +42,18 @@ object_type * object_create
 
     object->object_id = object_group->next_id++;
     vec3_set( &object->position, VEC3_NULL );
+    quat_set( &object->rotation, QUAT_IDENTITY );
+    vec3_set( &object->colour, 1.0f, 1.0f, 1.0f );
+    object->scale = 1.0f;
+    vec3_set( &object->previous_position, VEC3_NULL );
+    vec3_set( &object->step_displacement, VEC3_NULL );
     mat4_set( &object->model_matrix, MAT4_IDENTITY );
+    object->model_matrix_dirty = FALSE;
     object->bones = vector_init( sizeof( bone_type ) );
     object->shader = object_group->shader;
 
-    vector_push_back( object_group->objects, &object );
+    object->group_index = object_ptr_vector_size( &object_group->objects );
+    object_ptr_vector_push_back( &object_group->objects, &object );
     return object;
 }
 
@@ -59,14 +66,42 @@ void object_set_visibility
     object->is_visible = visible;
 }
 
+void object_set_scale
+    (
+        object_type * object,
+        GLfloat       scale
+    )
+{
+    object->scale = scale;
+    object->model_matrix_dirty = TRUE;
+}
+
+void object_set_colour
+    (
+        object_type       * object,
+        vec3_type const   * colour
+    )
+{
+    object->colour = *colour;
+}
+
 void object_delete
     (
         object_group_type   * object_group,
         object_type         * object
     )
 {
+    object_type * moved;
+
+    /* The last object takes the deleted one's place */
+    object_ptr_vector_swap_remove_at( &object_group->objects, object->group_index );
+    if( object->group_index < object_ptr_vector_size( &object_group->objects ) )
+    {
+        moved = *object_ptr_vector_at( &object_group->objects, object->group_index );
+        moved->group_index = object->group_index;
+    }
+
     vector_deinit( object->bones );
-    vector_remove( object_group->objects, &object );
     free( object );
 }
 
@@ -77,20 +112,14 @@ void object_rotate
         GLdouble              angle /* rad */
     )
 {
-    vec3_type origin;
-    vec3_type old_position;
-
-    vec3_cpy( &old_position, &( object->position ) );
-    vec3_set( &origin, VEC3_NULL );
-
-    /* Move to origin */
-    object_set_position( object, &origin );
+    quat_type rotation;
 
-    /* Apply rotation */
-    mat4_rotate( &( object->model_matrix ), axis, angle );
+    /* Rotations are applied after the ones before them, keep the quat unit length as they pile up */
+    quat_from_axis_angle( &rotation, axis, (GLfloat)angle );
+    quat_multiply( &object->rotation, &rotation, &object->rotation );
+    quat_normalize( &object->rotation );
 
-    /* Move back to position */
-    object_set_position( object, &old_position );
+    object->model_matrix_dirty = TRUE;
 }
 
 void object_translate
@@ -99,16 +128,8 @@ void object_translate
         vec3_type const     * shift
     )
 {
-    vec3_type zero;
-
-    vec3_set( &zero, VEC3_NULL );
-
-    /* Only shift is the amount of shift is non-zero */
-    if( 0 != memcmp( &zero, shift, sizeof( vec3_type ) ) )
-    {   
-        mat4_translate( &( object->model_matrix ), shift );
-        vec3_add( &( object->position ), &( object->position ), shift );
-    }
+    vec3_add( &( object->position ), &( object->position ), shift );
+    object->model_matrix_dirty = TRUE;
 }
 
 void object_set_position
@@ -117,14 +138,22 @@ void object_set_position
     vec3_type const     * position
     )
 {
-    vec3_type neg_position;
+    object->position = *position;
+    object->model_matrix_dirty = TRUE;
+}
 
-    /* Translate to origin */
-    vec3_scale( &neg_position, -1.0f, &( object->position ) );
-    object_translate( object, &neg_position ); 
+mat4_type const * object_get_model_matrix
+    (
+        object_type         * object
+    )
+{
+    if( object->model_matrix_dirty )
+    {
+        mat4_from_transform( &object->model_matrix, &object->position, &object->rotation, object->scale );
+        object->model_matrix_dirty = FALSE;
+    }
 
-    /* Translate to new position, if the new position isn't origin. */
-    object_translate( object, position );   
+    return &object->model_matrix;
 }
 
 void object_get_position
@@ -35,9 +35,28 @@ void object_set_visibility
         boolean       visible
     );
 
+/**
+ * @brief Set the size of an object.
+ */
+void object_set_scale
+    (
+        object_type * object,
+        GLfloat       scale
+    );
+
+/**
+ * @brief Set the colour of an object in an instanced object group.
+ */
+void object_set_colour
+    (
+        object_type       * object,
+        vec3_type const   * colour
+    );
+
 /**
  * @brief Delete an object, the memory associated with the object will be cleared
- *        and the object will not be rendered.
+ *        and the object will not be rendered. O(1), the group's last object
+ *        moves into its place in the group's object order.
  */
 void object_delete
     (
@@ -77,6 +96,15 @@ void object_set_position
         vec3_type const     * position
     );
 
+/**
+ * @brief Get the model matrix of an object, rebuilt from its position,
+ *        rotation and scale only if one changed since it was last built
+ */
+mat4_type const * object_get_model_matrix
+    (
+        object_type         * object
+    );
+
 /**
  * @brief Get position of object
  */
@@ -12,8 +12,12 @@
 #include "object.h"
 #include "texture.h"
 #include "camera.h"
+#include "stream_buffer.h"
 #include "common_util.h"
+#include <math.h>
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**********************************************************************
                             LITERAL CONSTANTS
@@ -57,6 +61,14 @@ static void object_group_global_frame_cb
         frame_event_type const * event_data
     );
 
+/**
+ * @brief Object group step event callback
+ */
+static void object_group_global_step_cb
+    (
+        step_event_type const * event_data
+    );
+
 /**
  *@brief Object group system event callback
  */
@@ -74,6 +86,72 @@ static void object_group_frame_cb
         frame_event_type  const * event_data
     );
 
+/**
+ * @brief Object group step event callback
+ */
+static void object_group_step_cb
+    (
+        object_group_type       * object_group,
+        step_event_type   const * event_data
+    );
+
+/**
+ * @brief Model matrix of an object moved back to where it was between the last two fixed steps
+ */
+static void interpolated_model_matrix
+    (
+        object_type         * object,
+        GLdouble              interpolation,
+        mat4_type           * model_matrix /* [out] */
+    );
+
+/**
+ * @brief Draw the instances just written to the instance stream, one call per level of detail
+ */
+static void draw_instances
+    (
+        object_group_type     * object_group,
+        uint32_t                lod_capacity,   /* Instances each level of detail has room for in the stream */
+        uint32_t        const * instance_counts /* Per level of detail */
+    );
+
+/**
+ * @brief Lay the levels of detail out in the group's vertex buffers and size the bounding sphere
+ */
+static void init_lods
+    (
+        object_group_type                       * object_group,
+        object_group_create_argument_type const * params
+    );
+
+/**
+ * @brief Allocate the bound GL_ARRAY_BUFFER for every level of detail and upload each one into its range
+ */
+static void upload_lods
+    (
+        object_group_type const   * object_group,
+        GLsizeiptr                  element_size,
+        void const * const        * data            /* One array per level of detail */
+    );
+
+/**
+ * @brief Radius of an object's bounding sphere, the group's radius under the object's scale
+ */
+static GLfloat object_bounding_radius
+    (
+        object_group_type const   * object_group,
+        object_type const         * object
+    );
+
+/**
+ * @brief Pick the level of detail for an object at a position
+ */
+static uint8_t select_lod
+    (
+        object_group_type const   * object_group,
+        vec3_type const           * position
+    );
+
 /**
  * @brief Object group system event callback
  */
@@ -107,8 +185,10 @@ void object_group_init
 
     active_object_groups.active_object_groups = vector_init( sizeof ( object_group_type * ) );
 
+    memset( &callbacks, 0, sizeof( callbacks ) );
     callbacks.frame_event_cb    = object_group_global_frame_cb;
     callbacks.system_event_cb   = object_group_global_system_cb;
+    callbacks.step_event_cb     = object_group_global_step_cb;
 
     register_system_listeners( &callbacks );
 }
@@ -123,13 +203,16 @@ void object_group_init
 
     object_group = calloc( 1, sizeof( object_group_type ) );
 
-    object_group->vertex_count          = params->vertex_count;
     object_group->object_cb             = params->object_cb;
+    object_group->batch_events          = params->batch_events;
     object_group->camera                = active_camera;
-    object_group->model_uniform_name    = params->model_uniform_name;
+    object_group->state_buffer          = params->state_buffer;
+    object_group->instanced             = params->instanced;
+    object_group->instance_position_channel = params->instance_position_channel;
+    object_group->instance_colour_channel   = params->instance_colour_channel;
 
     /* Init the array of object positions */
-    object_group->objects = vector_init( sizeof( object_type* ) );
+    object_ptr_vector_init( &object_group->objects );
 
     /* Init the array of buffers to delete */
     object_group->buffers_to_delete = vector_init( sizeof( GLuint ) );
@@ -139,10 +222,13 @@ void object_group_init
 
     /* Copy the shader to use */
     object_group->shader = params->shader;
+    object_group->model_uniform = ( NULL != params->model_uniform_name ) ? shader_get_uniform( params->shader, params->model_uniform_name ) : SHADER_UNIFORM_NONE;
 
     /* Copy texture to use */
     object_group->texture = params->texture;
 
+    init_lods( object_group, params );
+
     /* Do openGL specific init */
     status = openGL_init
         (
@@ -164,22 +250,25 @@ void object_group_delete
     )
 {
     uint32_t i;
-    uint32_t len;
 
     /* Free openGL resources */
     glDeleteVertexArrays( 1, &object_group->vertex_array_object );
     glDeleteBuffers( vector_size( object_group->buffers_to_delete ), vector_access( object_group->buffers_to_delete, 0, GLuint ) );
 
-    len = vector_size( object_group->objects );
-    for( i = 0; i < len; ++i )
+    /* Deleting from the back never moves another object */
+    for( i = object_ptr_vector_size( &object_group->objects ); i > 0; --i )
     {
-        object_delete( object_group, *vector_access( object_group->objects, i, object_type* ) );
+        object_delete( object_group, *object_ptr_vector_at( &object_group->objects, i - 1 ) );
     }
 
     /* Free system resources */
     vector_remove( active_object_groups.active_object_groups, &object_group );
-    vector_deinit( object_group->objects );
+    object_ptr_vector_deinit( &object_group->objects );
     vector_deinit( object_group->buffers_to_delete );
+    if( NULL != object_group->instance_stream )
+    {
+        stream_buffer_free( object_group->instance_stream );
+    }
     
     if( NULL != object_group->texture )
     {
@@ -216,6 +305,10 @@ static boolean openGL_init
     GLuint              vertex_buffer_object;
     GLuint              uv_buffer_object;
     GLuint              normal_buffer_object;
+    void const        * vertices[OBJECT_GROUP_MAX_LODS];
+    void const        * normals[OBJECT_GROUP_MAX_LODS];
+    void const        * uvs[OBJECT_GROUP_MAX_LODS];
+    uint8_t             i;
 
     /* Allocate data buffers. */ 
     glGenVertexArrays( 1, &object_group->vertex_array_object );
@@ -228,6 +321,17 @@ static boolean openGL_init
     vector_push_back( object_group->buffers_to_delete, &uv_buffer_object );
     vector_push_back( object_group->buffers_to_delete, &normal_buffer_object );
 
+    /* Every level of detail goes in the same buffers, one after the other */
+    vertices[0] = params->vertices;
+    normals[0]  = params->normals;
+    uvs[0]      = params->uvs;
+    for( i = 1; i < object_group->lod_count; ++i )
+    {
+        vertices[i] = params->lods[i - 1].vertices;
+        normals[i]  = params->lods[i - 1].normals;
+        uvs[i]      = params->lods[i - 1].uvs;
+    }
+
     /* Set the vertex array active. */
     glBindVertexArray( object_group->vertex_array_object );
 
@@ -236,7 +340,7 @@ static boolean openGL_init
     if( NULL != params->vertices )
     {
         glBindBuffer( GL_ARRAY_BUFFER, vertex_buffer_object );
-        glBufferData( GL_ARRAY_BUFFER, params->vertex_count * sizeof( vec3_type ), params->vertices, GL_STATIC_DRAW );
+        upload_lods( object_group, sizeof( vec3_type ), vertices );
         glVertexAttribPointer( params->vertex_channel, 3, GL_FLOAT, GL_FALSE, 0, NULL );
         glEnableVertexAttribArray( params->vertex_channel );
     }
@@ -248,7 +352,7 @@ static boolean openGL_init
     if( params->normals )
     {
         glBindBuffer( GL_ARRAY_BUFFER, normal_buffer_object );
-        glBufferData( GL_ARRAY_BUFFER, params->vertex_count * sizeof( vec3_type ), params->normals, GL_STATIC_DRAW );
+        upload_lods( object_group, sizeof( vec3_type ), normals );
         glVertexAttribPointer( params->normal_channel, 3, GL_FLOAT, GL_FALSE, 0, NULL );
         glEnableVertexAttribArray( params->normal_channel );
     }
@@ -256,11 +360,22 @@ static boolean openGL_init
     if( params->uvs )
     {
         glBindBuffer( GL_ARRAY_BUFFER, uv_buffer_object );
-        glBufferData( GL_ARRAY_BUFFER, params->vertex_count * sizeof( uv_type ), params->uvs, GL_STATIC_DRAW );
+        upload_lods( object_group, sizeof( uv_type ), uvs );
         glVertexAttribPointer( params->uv_channel, 2, GL_FLOAT, GL_FALSE, 0, NULL );
         glEnableVertexAttribArray( params->uv_channel );
     }
 
+    if( params->instanced )
+    {
+        /* The stream grows to the object count on the first frame, attributes are pointed at it after each write */
+        object_group->instance_stream = stream_buffer_create( sizeof( object_instance_type ) );
+
+        glVertexAttribDivisor( params->instance_position_channel, 1 );
+        glEnableVertexAttribArray( params->instance_position_channel );
+        glVertexAttribDivisor( params->instance_colour_channel, 1 );
+        glEnableVertexAttribArray( params->instance_colour_channel );
+    }
+
     glBindVertexArray( 0 );
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
 
@@ -287,6 +402,25 @@ static void object_group_global_frame_cb
     }
 }
 
+static void object_group_global_step_cb
+    (
+        step_event_type const * event_data
+    )
+{
+    /* Distribute the event onto each active object */
+    uint32_t              i;
+    uint32_t              len;
+    object_group_type   * object_group;
+
+    len = vector_size( active_object_groups.active_object_groups );
+
+    for( i = 0; i < len; ++i )
+    {
+        object_group = *vector_access( active_object_groups.active_object_groups, i, object_group_type* );
+        object_group_step_cb( object_group, event_data );
+    }
+}
+
 static void object_group_global_system_cb
     (
         system_event_type const * event_data
@@ -317,9 +451,18 @@ static void object_group_frame_cb
         frame_event_type  const * event_data
     )
 {
-    uint16_t i;
-    uint16_t len;
+    uint32_t i;
+    uint32_t len;
     object_event_type object_event;
+    mat4_type model_matrix;
+    void const * state;
+    object_instance_type* instances;
+    object_instance_type* instance;
+    uint32_t instance_counts[OBJECT_GROUP_MAX_LODS];
+    vec3_type shift;
+    vec3_type centre;
+    frustum_type frustum;
+    uint8_t lod;
     
     shader_use( object_group->shader );
 
@@ -328,50 +471,311 @@ static void object_group_frame_cb
         texture_use( object_group->texture );
     }
     
-    camera_set_active( object_group->camera, object_group->shader );
+    camera_set_active( object_group->camera );
+    camera_get_frustum( object_group->camera, &frustum );
     
-    len = vector_size( object_group->objects );
+    len = object_ptr_vector_size( &object_group->objects );
 
     glBindVertexArray( object_group->vertex_array_object );
 
+    if( object_group->instanced )
+    {
+        /* Instances are written straight into the stream as the objects are visited, with room for all of them in every level of detail */
+        instances = stream_buffer_map( object_group->instance_stream, object_group->lod_count * len * sizeof( object_instance_type ) );
+        memset( instance_counts, 0, sizeof( instance_counts ) );
+    }
+
+    /* Take the latest state once, so every object in the frame sees the same one */
+    state = ( NULL != object_group->state_buffer ) ? triple_buffer_read( object_group->state_buffer ) : NULL;
+
     if( NULL != object_group->object_cb )
     {
         object_event.event_type = OBJECT_EVENT_TYPE_RENDER_START;
         object_event.event_data.render_start_data.shader = object_group->shader;
+        object_event.event_data.render_start_data.state = state;
         object_group->object_cb( &object_event );
 
-        object_event.event_type = OBJECT_EVENT_TYPE_RENDER_OBJECT;
-        object_event.event_data.render_object_data.time_since_last_frame = event_data->timesince_last_frame;
+        if( object_group->batch_events )
+        {
+            object_event.event_type = OBJECT_EVENT_TYPE_RENDER_BATCH;
+            object_event.event_data.batch_data.objects = object_group->objects.items;
+            object_event.event_data.batch_data.count = len;
+            object_event.event_data.batch_data.time_step = event_data->timesince_last_frame;
+            object_event.event_data.batch_data.interpolation = event_data->interpolation;
+            object_event.event_data.batch_data.state = state;
+            object_group->object_cb( &object_event );
+        }
+        else
+        {
+            object_event.event_type = OBJECT_EVENT_TYPE_RENDER_OBJECT;
+            object_event.event_data.render_object_data.time_since_last_frame = event_data->timesince_last_frame;
+            object_event.event_data.render_object_data.interpolation = event_data->interpolation;
+            object_event.event_data.render_object_data.state = state;
+        }
     }
 
     for( i = 0; i < len; ++i )
     {
         object_type* object;
 
-        object = *vector_access( object_group->objects, i, object_type* );
+        object = *object_ptr_vector_at( &object_group->objects, i );
 
-        if( NULL != object_group->object_cb )
+        if( ( NULL != object_group->object_cb ) && !object_group->batch_events )
         {
             object_event.event_data.render_object_data.object = object;
             object_group->object_cb( &object_event );
         }
 
-        if( object->is_visible )
+        if( !object->is_visible )
+        {
+            continue;
+        }
+
+        /* Same interpolation as interpolated_model_matrix, on the position alone */
+        vec3_scale( &shift, (GLfloat)( event_data->interpolation - 1.0 ), &object->step_displacement );
+        vec3_add( &centre, &object->position, &shift );
+
+        if( !frustum_test_sphere( &frustum, &centre, object_bounding_radius( object_group, object ) ) )
+        {
+            continue;
+        }
+
+        lod = select_lod( object_group, &centre );
+
+        if( object_group->instanced )
+        {
+            instance = &instances[lod * len + instance_counts[lod]++];
+            instance->position = centre;
+            instance->scale = object->scale;
+            instance->colour = object->colour;
+        }
+        else
         {
-            if( object_group->model_uniform_name )
+            if( SHADER_UNIFORM_NONE != object_group->model_uniform )
             {
-                shader_set_uniform_mat4( object->shader, object_group->model_uniform_name, &object->model_matrix );
+                interpolated_model_matrix( object, event_data->interpolation, &model_matrix );
+                shader_set_uniform_mat4_handle( object_group->model_uniform, &model_matrix );
             }
-            glDrawArrays( GL_TRIANGLES, 0, object_group->vertex_count );
+            glDrawArrays( GL_TRIANGLES, object_group->lods[lod].first_vertex, object_group->lods[lod].vertex_count );
         }
     }
 
+    if( object_group->instanced )
+    {
+        draw_instances( object_group, len, instance_counts );
+    }
+
     glBindVertexArray( 0 );
 
     texture_clear();
     shader_clear();
 }
 
+static void draw_instances
+    (
+        object_group_type     * object_group,
+        uint32_t                lod_capacity,
+        uint32_t        const * instance_counts
+    )
+{
+    GLintptr                        offset;
+    object_group_lod_type const   * lod;
+    uint8_t                         i;
+
+    offset = stream_buffer_unmap( object_group->instance_stream );
+
+    for( i = 0; i < object_group->lod_count; ++i )
+    {
+        if( 0 == instance_counts[i] )
+        {
+            continue;
+        }
+
+        /* The VAO is bound, point its instance attributes at this level of detail's instances */
+        lod = &object_group->lods[i];
+        glVertexAttribPointer( object_group->instance_position_channel, 4, GL_FLOAT, GL_FALSE, sizeof( object_instance_type ), (void*)( offset + offsetof( object_instance_type, position ) ) );
+        glVertexAttribPointer( object_group->instance_colour_channel, 3, GL_FLOAT, GL_FALSE, sizeof( object_instance_type ), (void*)( offset + offsetof( object_instance_type, colour ) ) );
+        glDrawArraysInstanced( GL_TRIANGLES, lod->first_vertex, lod->vertex_count, instance_counts[i] );
+
+        offset += lod_capacity * sizeof( object_instance_type );
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    stream_buffer_fence( object_group->instance_stream );
+}
+
+static void init_lods
+    (
+        object_group_type                       * object_group,
+        object_group_create_argument_type const * params
+    )
+{
+    object_group_lod_type             * lod;
+    object_group_lod_mesh_type const  * mesh;
+    GLfloat                             radius_sq;
+    GLfloat                             length_sq;
+    uint32_t                            i;
+    uint8_t                             j;
+
+    ASSERT( params->lod_count < OBJECT_GROUP_MAX_LODS );
+
+    object_group->lod_count = 1 + params->lod_count;
+
+    object_group->lods[0].first_vertex  = 0;
+    object_group->lods[0].vertex_count  = params->vertex_count;
+    object_group->lods[0].distance_sq   = 0.0f;
+
+    radius_sq = 0.0f;
+    for( i = 0; i < params->vertex_count; ++i )
+    {
+        length_sq = vec3_dot( &params->vertices[i], &params->vertices[i] );
+        radius_sq = MAX( radius_sq, length_sq );
+    }
+
+    for( j = 1; j < object_group->lod_count; ++j )
+    {
+        lod  = &object_group->lods[j];
+        mesh = &params->lods[j - 1];
+
+        lod->first_vertex   = lod[-1].first_vertex + lod[-1].vertex_count;
+        lod->vertex_count   = mesh->vertex_count;
+        lod->distance_sq    = mesh->distance * mesh->distance;
+
+        for( i = 0; i < mesh->vertex_count; ++i )
+        {
+            length_sq = vec3_dot( &mesh->vertices[i], &mesh->vertices[i] );
+            radius_sq = MAX( radius_sq, length_sq );
+        }
+    }
+
+    object_group->bounding_radius = ( params->bounding_radius > 0.0f ) ? params->bounding_radius : (GLfloat)sqrt( radius_sq );
+}
+
+static void upload_lods
+    (
+        object_group_type const   * object_group,
+        GLsizeiptr                  element_size,
+        void const * const        * data
+    )
+{
+    object_group_lod_type const   * last;
+    uint8_t                         i;
+
+    last = &object_group->lods[object_group->lod_count - 1];
+    glBufferData( GL_ARRAY_BUFFER, ( last->first_vertex + last->vertex_count ) * element_size, NULL, GL_STATIC_DRAW );
+
+    for( i = 0; i < object_group->lod_count; ++i )
+    {
+        glBufferSubData( GL_ARRAY_BUFFER, object_group->lods[i].first_vertex * element_size, object_group->lods[i].vertex_count * element_size, data[i] );
+    }
+}
+
+static GLfloat object_bounding_radius
+    (
+        object_group_type const   * object_group,
+        object_type const         * object
+    )
+{
+    return object_group->bounding_radius * object->scale;
+}
+
+static uint8_t select_lod
+    (
+        object_group_type const   * object_group,
+        vec3_type const           * position
+    )
+{
+    vec3_type   offset;
+    GLfloat     distance_sq;
+    uint8_t     lod;
+
+    vec3_subtract( &offset, position, &object_group->camera->position );
+    distance_sq = vec3_dot( &offset, &offset );
+
+    lod = 0;
+    while( ( lod + 1 < object_group->lod_count ) && ( distance_sq >= object_group->lods[lod + 1].distance_sq ) )
+    {
+        lod++;
+    }
+
+    return lod;
+}
+
+static void object_group_step_cb
+    (
+        object_group_type       * object_group,
+        step_event_type   const * event_data
+    )
+{
+    uint32_t i;
+    uint32_t len;
+    object_event_type object_event;
+    object_type* object;
+
+    len = object_ptr_vector_size( &object_group->objects );
+
+    for( i = 0; i < len; ++i )
+    {
+        object = *object_ptr_vector_at( &object_group->objects, i );
+        object->previous_position = object->position;
+    }
+
+    if( NULL != object_group->object_cb )
+    {
+        object_event.event_type = OBJECT_EVENT_TYPE_STEP_START;
+        object_event.event_data.step_data.object = NULL;
+        object_event.event_data.step_data.time_step = event_data->time_step;
+        object_group->object_cb( &object_event );
+
+        if( object_group->batch_events )
+        {
+            object_event.event_type = OBJECT_EVENT_TYPE_STEP_BATCH;
+            object_event.event_data.batch_data.objects = object_group->objects.items;
+            object_event.event_data.batch_data.count = len;
+            object_event.event_data.batch_data.time_step = event_data->time_step;
+            object_event.event_data.batch_data.interpolation = 1.0;
+            object_event.event_data.batch_data.state = NULL;
+            object_group->object_cb( &object_event );
+        }
+        else
+        {
+            object_event.event_type = OBJECT_EVENT_TYPE_STEP_OBJECT;
+            for( i = 0; i < len; ++i )
+            {
+                object_event.event_data.step_data.object = *object_ptr_vector_at( &object_group->objects, i );
+                object_group->object_cb( &object_event );
+            }
+        }
+    }
+
+    /* Only movement made by the step is interpolated, moves made while rendering show as they are */
+    for( i = 0; i < len; ++i )
+    {
+        object = *object_ptr_vector_at( &object_group->objects, i );
+        vec3_subtract( &object->step_displacement, &object->position, &object->previous_position );
+    }
+}
+
+static void interpolated_model_matrix
+    (
+        object_type         * object,
+        GLdouble              interpolation,
+        mat4_type           * model_matrix
+    )
+{
+    GLfloat pull_back;
+
+    /* The model matrix is at the end of the last step, pull it back along the step's movement.
+       Translation is the last transform, so that only moves the translation column */
+    pull_back = (GLfloat)( interpolation - 1.0 );
+
+    *model_matrix = *object_get_model_matrix( object );
+    model_matrix->w.x += pull_back * object->step_displacement.x;
+    model_matrix->w.y += pull_back * object->step_displacement.y;
+    model_matrix->w.z += pull_back * object->step_displacement.z;
+}
+
 static void object_group_system_cb
     (
         object_group_type       * object_group,
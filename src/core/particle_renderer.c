@@ -0,0 +1,282 @@
+/**
+ * @file particle_renderer.c
+ *
+ * @brief Implementation of the point sprite particle renderer
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "particle_renderer.h"
+#include "camera.h"
+#include "system.h"
+#include "sim_runner.h"
+#include "stream_buffer.h"
+#include "common_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define POINT_SCALE_UNIFORM     "point_scale"       /* Pixel diameter of a body at unit clip w */
+#define COLOUR_UNIFORM          "particle_colour"
+
+#define AXIS_COUNT              ( 3 )
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+struct particle_renderer_struct
+{
+    GLuint                  vertex_array_object;
+    stream_buffer_type    * position_stream;        /* Each write is all x, then all y, then all z */
+    uint32_t                count;
+    shader_type           * shader;
+    camera_type           * camera;
+    GLfloat                 radius;
+    vec3_type               colour;
+    shader_uniform_type     point_scale_uniform;
+    shader_uniform_type     colour_uniform;
+    uint8_t                 channels[AXIS_COUNT];
+    triple_buffer_type    * state_buffer;
+    void const            * last_state;             /* Snapshot uploaded last, re-uploaded only when a new one comes in */
+};
+
+/**********************************************************************
+                             VARIABLES
+**********************************************************************/
+
+static vector_type *    active_renderers;   /* particle_renderer_type* */
+static camera_type *    active_camera;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Particle renderer frame event callback, draws every renderer
+ */
+static void particle_renderer_global_frame_cb
+    (
+        frame_event_type const * event_data
+    );
+
+/**
+ * @brief Particle renderer system event callback
+ */
+static void particle_renderer_global_system_cb
+    (
+        system_event_type const * event_data
+    );
+
+/**
+ * @brief Draw one renderer
+ */
+static void particle_renderer_draw
+    (
+        particle_renderer_type * renderer
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void particle_renderer_init
+    (
+        void
+    )
+{
+    system_listener_callbacks_type callbacks;
+
+    active_renderers = vector_init( sizeof( particle_renderer_type* ) );
+
+    memset( &callbacks, 0, sizeof( callbacks ) );
+    callbacks.frame_event_cb    = particle_renderer_global_frame_cb;
+    callbacks.system_event_cb   = particle_renderer_global_system_cb;
+
+    register_system_listeners( &callbacks );
+}
+
+particle_renderer_type * particle_renderer_create
+    (
+        particle_renderer_create_argument_type const * params
+    )
+{
+    particle_renderer_type    * renderer;
+    uint32_t                    axis;
+
+    renderer = calloc( 1, sizeof( particle_renderer_type ) );
+
+    renderer->shader        = params->shader;
+    renderer->camera        = active_camera;
+    renderer->radius        = params->radius;
+    renderer->colour        = params->colour;
+    renderer->channels[0]   = params->position_x_channel;
+    renderer->channels[1]   = params->position_y_channel;
+    renderer->channels[2]   = params->position_z_channel;
+    renderer->state_buffer  = params->state_buffer;
+    renderer->point_scale_uniform = shader_get_uniform( params->shader, POINT_SCALE_UNIFORM );
+    renderer->colour_uniform      = shader_get_uniform( params->shader, COLOUR_UNIFORM );
+
+    glGenVertexArrays( 1, &renderer->vertex_array_object );
+    renderer->position_stream = stream_buffer_create( 0 );
+
+    /* Every component is its own float stream, straight out of the SoA arrays. The pointers are set after each write */
+    glBindVertexArray( renderer->vertex_array_object );
+    for( axis = 0; axis < AXIS_COUNT; ++axis )
+    {
+        glEnableVertexAttribArray( renderer->channels[axis] );
+    }
+    glBindVertexArray( 0 );
+
+    vector_push_back( active_renderers, &renderer );
+
+    return renderer;
+}
+
+void particle_renderer_set_positions
+    (
+        particle_renderer_type    * renderer,
+        GLfloat const             * position_x,
+        GLfloat const             * position_y,
+        GLfloat const             * position_z,
+        uint32_t                    count
+    )
+{
+    GLfloat   * positions;
+    GLintptr    offset;
+    uint32_t    axis;
+
+    renderer->count = count;
+
+    if( 0 == count )
+    {
+        return;
+    }
+
+    positions = stream_buffer_map( renderer->position_stream, AXIS_COUNT * count * sizeof( GLfloat ) );
+    memcpy( &positions[0 * count], position_x, count * sizeof( GLfloat ) );
+    memcpy( &positions[1 * count], position_y, count * sizeof( GLfloat ) );
+    memcpy( &positions[2 * count], position_z, count * sizeof( GLfloat ) );
+
+    glBindVertexArray( renderer->vertex_array_object );
+    offset = stream_buffer_unmap( renderer->position_stream );
+
+    for( axis = 0; axis < AXIS_COUNT; ++axis )
+    {
+        glVertexAttribPointer( renderer->channels[axis], 1, GL_FLOAT, GL_FALSE, 0, (void*)( offset + axis * count * sizeof( GLfloat ) ) );
+    }
+
+    glBindVertexArray( 0 );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void particle_renderer_delete
+    (
+        particle_renderer_type * renderer
+    )
+{
+    glDeleteVertexArrays( 1, &renderer->vertex_array_object );
+    stream_buffer_free( renderer->position_stream );
+
+    vector_remove( active_renderers, &renderer );
+
+    shader_free( renderer->shader );
+    free( renderer );
+}
+
+void particle_renderer_deinit
+    (
+        void
+    )
+{
+    while( vector_size( active_renderers ) > 0 )
+    {
+        particle_renderer_delete( *vector_access( active_renderers, 0, particle_renderer_type* ) );
+    }
+
+    vector_deinit( active_renderers );
+}
+
+static void particle_renderer_global_frame_cb
+    (
+        frame_event_type const * event_data
+    )
+{
+    uint32_t i;
+    uint32_t len;
+
+    len = vector_size( active_renderers );
+    for( i = 0; i < len; ++i )
+    {
+        particle_renderer_draw( *vector_access( active_renderers, i, particle_renderer_type* ) );
+    }
+}
+
+static void particle_renderer_global_system_cb
+    (
+        system_event_type const * event_data
+    )
+{
+    uint32_t i;
+    uint32_t len;
+
+    if( SYSTEM_EVENT_NEW_CAMERA != event_data->event_type )
+    {
+        return;
+    }
+
+    active_camera = event_data->event_data.new_camera_data;
+
+    len = vector_size( active_renderers );
+    for( i = 0; i < len; ++i )
+    {
+        ( *vector_access( active_renderers, i, particle_renderer_type* ) )->camera = active_camera;
+    }
+}
+
+static void particle_renderer_draw
+    (
+        particle_renderer_type * renderer
+    )
+{
+    sim_snapshot_type const   * snapshot;
+    GLint                       viewport[4];
+
+    if( NULL != renderer->state_buffer )
+    {
+        snapshot = (sim_snapshot_type const *)triple_buffer_read( renderer->state_buffer );
+        if( ( NULL != snapshot ) && ( renderer->last_state != snapshot ) )
+        {
+            particle_renderer_set_positions( renderer, snapshot->position_x, snapshot->position_y, snapshot->position_z, snapshot->count );
+            renderer->last_state = snapshot;
+        }
+    }
+
+    if( ( 0 == renderer->count ) || ( NULL == renderer->camera ) )
+    {
+        return;
+    }
+
+    /* A body of radius r at clip w covers r * projection_yy / w of the half viewport height */
+    glGetIntegerv( GL_VIEWPORT, viewport );
+
+    shader_use( renderer->shader );
+    camera_set_active( renderer->camera );
+    shader_set_uniform_float_handle( renderer->point_scale_uniform, renderer->radius * renderer->camera->projection_matrix.y.y * (GLfloat)viewport[3] );
+    shader_set_uniform_vec3_handle( renderer->colour_uniform, &renderer->colour );
+
+    glEnable( GL_PROGRAM_POINT_SIZE );
+    glBindVertexArray( renderer->vertex_array_object );
+    glDrawArrays( GL_POINTS, 0, renderer->count );
+    glBindVertexArray( 0 );
+    glDisable( GL_PROGRAM_POINT_SIZE );
+
+    stream_buffer_fence( renderer->position_stream );
+
+    shader_clear();
+}
@@ -0,0 +1,89 @@
+/**
+ * @file particle_renderer.h
+ *
+ * @brief Draws large numbers of bodies as point sprites
+ *
+ * Positions go to the GPU straight from structure of arrays buffers, such
+ * as the snapshots of a sim runner, and are drawn as one GL_POINTS call.
+ * The fragment shader turns each point into a shaded sphere impostor, so
+ * there is no mesh and no object_type per body.
+ */
+#ifndef PARTICLE_RENDERER_H
+#define PARTICLE_RENDERER_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "system_types.h"
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/**
+ * @brief Arguments for creating a particle renderer
+ */
+typedef struct particle_renderer_create_argument_struct
+{
+    shader_type*        shader;             /* A shader object (@see shader.h), will be automatically deleted with the renderer. */
+    uint8_t             position_x_channel; /* float attribute locations of the position components */
+    uint8_t             position_y_channel;
+    uint8_t             position_z_channel;
+    GLfloat             radius;             /* World size of every body, for the point_scale uniform */
+    vec3_type           colour;             /* Passed in the particle_colour uniform */
+    triple_buffer_type* state_buffer;       /* (Optional) Triple buffer of sim_snapshot_type (@see sim_runner.h), uploaded whenever a new one is published. The renderer is its only reader. */
+} particle_renderer_create_argument_type;
+
+/* Particle renderer type, should only be accessed with interface functions below */
+typedef struct particle_renderer_struct particle_renderer_type;
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Initialize the particle renderer system
+ */
+void particle_renderer_init
+    (
+        void
+    );
+
+/**
+ * @brief Create a particle renderer, it draws every frame until deleted
+ */
+particle_renderer_type * particle_renderer_create
+    (
+        particle_renderer_create_argument_type const * params
+    );
+
+/**
+ * @brief Replace the positions drawn, for renderers without a state buffer
+ */
+void particle_renderer_set_positions
+    (
+        particle_renderer_type    * renderer,
+        GLfloat const             * position_x,
+        GLfloat const             * position_y,
+        GLfloat const             * position_z,
+        uint32_t                    count
+    );
+
+/**
+ * @brief Delete a particle renderer
+ */
+void particle_renderer_delete
+    (
+        particle_renderer_type * renderer
+    );
+
+/**
+ * @brief Deinit the particle renderer system, deleting any renderers left
+ */
+void particle_renderer_deinit
+    (
+        void
+    );
+
+#endif /* PARTICLE_RENDERER_H */
@@ -0,0 +1,246 @@
+/**
+ * @file stream_buffer.c
+ *
+ * @brief Implementation of the streaming vertex buffer
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "stream_buffer.h"
+#include "common_util.h"
+#include <stdlib.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define PERSISTENT_FLAGS    ( GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT )
+#define FENCE_TIMEOUT       ( 1000000 ) /* ns, between checks while waiting on the GPU */
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+struct stream_buffer_struct
+{
+    GLuint          buffer_object;
+    uint32_t        segment_size;
+    uint32_t        write_segment;                          /* Next segment to write */
+    uint32_t        data_segment;                           /* Last segment written */
+    boolean         persistent;                             /* GL_ARB_buffer_storage path */
+    uint8_t       * mapped;                                 /* Persistent only, the whole ring */
+    GLsync          fences[STREAM_BUFFER_SEGMENT_COUNT];    /* Persistent only, NULL once a segment is free */
+};
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Create the openGL buffer for segments of segment_size
+ */
+static void allocate
+    (
+        stream_buffer_type    * buffer,
+        uint32_t                segment_size
+    );
+
+/**
+ * @brief Delete the openGL buffer, waiting for any draws reading it
+ */
+static void release
+    (
+        stream_buffer_type * buffer
+    );
+
+/**
+ * @brief Wait for the draws reading a segment to finish
+ */
+static void wait_segment
+    (
+        stream_buffer_type    * buffer,
+        uint32_t                segment
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+stream_buffer_type * stream_buffer_create
+    (
+        uint32_t segment_size
+    )
+{
+    stream_buffer_type * buffer;
+
+    buffer = calloc( 1, sizeof( stream_buffer_type ) );
+
+    buffer->persistent = ( GLEW_ARB_buffer_storage || GLEW_VERSION_4_4 );
+    allocate( buffer, MAX( 1, segment_size ) );
+
+    return buffer;
+}
+
+void stream_buffer_free
+    (
+        stream_buffer_type * buffer
+    )
+{
+    release( buffer );
+    free( buffer );
+}
+
+void * stream_buffer_map
+    (
+        stream_buffer_type    * buffer,
+        uint32_t                size
+    )
+{
+    GLintptr offset;
+
+    if( size > buffer->segment_size )
+    {
+        /* Grow with room to spare so a slowly growing count doesn't reallocate every frame */
+        release( buffer );
+        allocate( buffer, MAX( size, buffer->segment_size + buffer->segment_size / 2 ) );
+    }
+
+    offset = buffer->write_segment * buffer->segment_size;
+
+    glBindBuffer( GL_ARRAY_BUFFER, buffer->buffer_object );
+
+    if( buffer->persistent )
+    {
+        wait_segment( buffer, buffer->write_segment );
+        return buffer->mapped + offset;
+    }
+
+    /* The GPU may still read any segment of the old storage, so each lap of the ring starts on new storage */
+    if( 0 == buffer->write_segment )
+    {
+        glBufferData( GL_ARRAY_BUFFER, STREAM_BUFFER_SEGMENT_COUNT * buffer->segment_size, NULL, GL_STREAM_DRAW );
+    }
+
+    return glMapBufferRange( GL_ARRAY_BUFFER, offset, MAX( 1, size ), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+}
+
+GLintptr stream_buffer_unmap
+    (
+        stream_buffer_type * buffer
+    )
+{
+    if( !buffer->persistent )
+    {
+        glUnmapBuffer( GL_ARRAY_BUFFER );
+    }
+
+    buffer->data_segment    = buffer->write_segment;
+    buffer->write_segment   = ( buffer->write_segment + 1 ) % STREAM_BUFFER_SEGMENT_COUNT;
+
+    return buffer->data_segment * buffer->segment_size;
+}
+
+void stream_buffer_fence
+    (
+        stream_buffer_type * buffer
+    )
+{
+    if( !buffer->persistent )
+    {
+        return;
+    }
+
+    /* Data drawn again in later frames needs its fence moved up to the latest draw */
+    if( NULL != buffer->fences[buffer->data_segment] )
+    {
+        glDeleteSync( buffer->fences[buffer->data_segment] );
+    }
+
+    buffer->fences[buffer->data_segment] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+}
+
+GLuint stream_buffer_id
+    (
+        stream_buffer_type const * buffer
+    )
+{
+    return buffer->buffer_object;
+}
+
+static void allocate
+    (
+        stream_buffer_type    * buffer,
+        uint32_t                segment_size
+    )
+{
+    GLsizeiptr size;
+
+    buffer->segment_size    = segment_size;
+    buffer->write_segment   = 0;
+    buffer->data_segment    = 0;
+    size                    = STREAM_BUFFER_SEGMENT_COUNT * segment_size;
+
+    glGenBuffers( 1, &buffer->buffer_object );
+    glBindBuffer( GL_ARRAY_BUFFER, buffer->buffer_object );
+
+    if( buffer->persistent )
+    {
+        glBufferStorage( GL_ARRAY_BUFFER, size, NULL, PERSISTENT_FLAGS );
+        buffer->mapped = glMapBufferRange( GL_ARRAY_BUFFER, 0, size, PERSISTENT_FLAGS );
+    }
+    else
+    {
+        glBufferData( GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW );
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+static void release
+    (
+        stream_buffer_type * buffer
+    )
+{
+    uint32_t i;
+
+    if( buffer->persistent )
+    {
+        for( i = 0; i < STREAM_BUFFER_SEGMENT_COUNT; ++i )
+        {
+            wait_segment( buffer, i );
+        }
+
+        glBindBuffer( GL_ARRAY_BUFFER, buffer->buffer_object );
+        glUnmapBuffer( GL_ARRAY_BUFFER );
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        buffer->mapped = NULL;
+    }
+
+    glDeleteBuffers( 1, &buffer->buffer_object );
+}
+
+static void wait_segment
+    (
+        stream_buffer_type    * buffer,
+        uint32_t                segment
+    )
+{
+    GLenum status;
+
+    if( NULL == buffer->fences[segment] )
+    {
+        return;
+    }
+
+    /* Flush on the first check so the fence is sure to be reached */
+    status = glClientWaitSync( buffer->fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT );
+    while( GL_TIMEOUT_EXPIRED == status )
+    {
+        status = glClientWaitSync( buffer->fences[segment], 0, FENCE_TIMEOUT );
+    }
+
+    glDeleteSync( buffer->fences[segment] );
+    buffer->fences[segment] = NULL;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file stream_buffer.h
+ *
+ * @brief Vertex buffer for data that is rewritten every frame
+ *
+ * The buffer is a ring of segments, each write goes to the next segment
+ * while the GPU may still be reading the previous ones, so uploads don't
+ * wait for draws. With GL_ARB_buffer_storage the whole ring is mapped
+ * once, persistently, and a fence per segment guards against overwriting
+ * data the GPU hasn't read yet. Without it the buffer is orphaned every
+ * time the ring wraps and segments are mapped unsynchronized.
+ */
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "system_types.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define STREAM_BUFFER_SEGMENT_COUNT     ( 3 )   /* Frames of data in flight */
+
+/* stream_buffer_type is declared in system_types.h, it should only be accessed with interface functions below */
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Create a stream buffer, needs a current openGL context
+ */
+stream_buffer_type * stream_buffer_create
+    (
+        uint32_t segment_size /* Starting size of a segment in bytes, grows on demand */
+    );
+
+/**
+ * @brief Delete a stream buffer
+ */
+void stream_buffer_free
+    (
+        stream_buffer_type * buffer
+    );
+
+/**
+ * @brief Start writing the next segment. Leaves the buffer bound to
+ *        GL_ARRAY_BUFFER.
+ *
+ * @return Memory to write size bytes to, valid until stream_buffer_unmap
+ */
+void * stream_buffer_map
+    (
+        stream_buffer_type    * buffer,
+        uint32_t                size
+    );
+
+/**
+ * @brief Finish writing a segment. Leaves the buffer bound to
+ *        GL_ARRAY_BUFFER for setting up attributes.
+ *
+ * @return Byte offset of the written data in the buffer
+ */
+GLintptr stream_buffer_unmap
+    (
+        stream_buffer_type * buffer
+    );
+
+/**
+ * @brief Mark the last written segment as in use by the draw calls issued
+ *        so far, it won't be written again until they are done
+ */
+void stream_buffer_fence
+    (
+        stream_buffer_type * buffer
+    );
+
+/**
+ * @brief Get the openGL buffer name. It can change in stream_buffer_map,
+ *        so attributes should be pointed at it after each write.
+ */
+GLuint stream_buffer_id
+    (
+        stream_buffer_type const * buffer
+    );
+
+#endif /* STREAM_BUFFER_H */
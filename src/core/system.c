@@ -10,8 +10,11 @@
 
 #include "system.h"
 #include "object_group_core.h"
+#include "particle_renderer.h"
 #include "object.h"
 #include "camera.h"
+#include "lighting.h"
+#include "frame_capture.h"
 #include "common_util.h"
 #include <stdlib.h>
 #include <string.h>
@@ -31,6 +34,8 @@
 
 #define WINDOW_NAME     "Particles"
 
+#define FRAME_ARENA_BLOCK_SIZE  ( 1 << 20 ) /* Bytes */
+
 /**********************************************************************
                              PROTOTYPES
 **********************************************************************/
@@ -40,7 +45,17 @@
  */
 static boolean openGL_system_init
     (
-        void
+        uint32_t width,
+        uint32_t height,
+        boolean  visible
+    );
+
+/**
+ * @brief Initialize the system, shared by the windowed and offscreen modes
+ */
+static boolean init
+    (
+        system_offscreen_config_type const * offscreen_config  /* NULL for a window */
     );
 
 /**
@@ -59,6 +74,14 @@ static void frame
         void
     );
 
+/**
+ * @brief Runs the fixed steps the frame time has accumulated
+ */
+static void run_steps
+    (
+        GLdouble frame_time
+    );
+
 /**
  * @brief Sends a system event
  */
@@ -104,6 +127,11 @@ void register_system_listeners
     {
         vector_push_back( system_instance.frame_event_listeners, &( callbacks->frame_event_cb ) );
     }
+
+    if( NULL != callbacks->step_event_cb )
+    {
+        vector_push_back( system_instance.step_event_listeners, &( callbacks->step_event_cb ) );
+    }
 }
 
 void system_set_camera
@@ -122,20 +150,72 @@ void system_set_camera
     send_system_event( &event_data );
 }
 
-
+void system_set_fixed_time_step
+    (
+        GLdouble time_step
+    )
+{
+    system_instance.fixed_time_step = time_step;
+}
 
 boolean system_init
     (
         void
     )
+{
+    return init( NULL );
+}
+
+boolean system_init_offscreen
+    (
+        system_offscreen_config_type const * config
+    )
+{
+    return init( config );
+}
+
+static boolean init
+    (
+        system_offscreen_config_type const * offscreen_config
+    )
 {
     memset( &system_instance, 0, sizeof( system_type ) );
 
     system_instance.system_event_listeners    = vector_init( sizeof( system_event_callback ) );
     system_instance.frame_event_listeners     = vector_init( sizeof( frame_event_callback ) );
+    system_instance.step_event_listeners      = vector_init( sizeof( step_event_callback ) );
+    system_instance.fixed_time_step           = SYSTEM_DEFAULT_FIXED_TIME_STEP;
+    system_instance.frame_arena               = arena_create( FRAME_ARENA_BLOCK_SIZE );
+
+    if( NULL == offscreen_config )
+    {
+        openGL_system_init( WINDOW_WIDTH, WINDOW_HEIGHT, TRUE );
+    }
+    else
+    {
+        system_instance.offscreen_config = *offscreen_config;
+        if( !openGL_system_init( offscreen_config->width, offscreen_config->height, FALSE ) )
+        {
+            return FALSE;
+        }
 
-    openGL_system_init();
+        system_instance.frame_capture = frame_capture_create
+            (
+                offscreen_config->width,
+                offscreen_config->height,
+                offscreen_config->output_pattern,
+                offscreen_config->encoder_command
+            );
+        if( NULL == system_instance.frame_capture )
+        {
+            return FALSE;
+        }
+    }
+
+    camera_block_init();
+    lighting_init();
     object_group_init();
+    particle_renderer_init();
     
 #if( PRINT_FRAMERATE )
     second_start_time = glfwGetTime();
@@ -170,10 +250,20 @@ GLFWwindow* system_get_window
     return system_instance.glfw_window;
 }
 
-static boolean openGL_system_init
+arena_type * system_get_frame_arena
     (
         void
     )
+{
+    return system_instance.frame_arena;
+}
+
+static boolean openGL_system_init
+    (
+        uint32_t width,
+        uint32_t height,
+        boolean  visible
+    )
 {
     if( !glfwInit() )
     {
@@ -185,13 +275,19 @@ static boolean openGL_system_init
     glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 0 );
     glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
     glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+    glfwWindowHint( GLFW_VISIBLE, visible ? GL_TRUE : GL_FALSE );
 
 #if FULLSCREEN
-    system_instance.glfw_window = glfwCreateWindow( WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_NAME, glfwGetPrimaryMonitor(), NULL );
+    system_instance.glfw_window = glfwCreateWindow( width, height, WINDOW_NAME, visible ? glfwGetPrimaryMonitor() : NULL, NULL );
 #else
-    system_instance.glfw_window = glfwCreateWindow( WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_NAME, NULL, NULL );
+    system_instance.glfw_window = glfwCreateWindow( width, height, WINDOW_NAME, NULL, NULL );
 #endif
 
+    if( NULL == system_instance.glfw_window )
+    {
+        return FALSE;
+    }
+
     glfwMakeContextCurrent( system_instance.glfw_window );
 
     glewExperimental = GL_TRUE;
@@ -200,7 +296,7 @@ static boolean openGL_system_init
         return FALSE;
     }
 
-    glViewport( 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT );
+    glViewport( 0, 0, width, height );
 
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
@@ -223,11 +319,22 @@ static void system_deinit
 
     send_system_event( &event_data );
 
+    /* Write out the frame still being read back while the context is still around */
+    if( NULL != system_instance.frame_capture )
+    {
+        frame_capture_free( system_instance.frame_capture );
+    }
+
     object_group_deinit();
+    particle_renderer_deinit();
+    lighting_deinit();
+    camera_block_deinit();
 
     /* Free the system memory */
     vector_deinit( system_instance.system_event_listeners );
     vector_deinit( system_instance.frame_event_listeners );
+    vector_deinit( system_instance.step_event_listeners );
+    arena_free( system_instance.frame_arena );
 
     glfwTerminate();
 }
@@ -243,14 +350,23 @@ static void frame
     frame_event_type        event_data;
     static GLdouble         last_timestamp = 0.0;
 
+    /* Nothing from the frame arena outlives the frame it was allocated in */
+    arena_reset( system_instance.frame_arena );
+
     /* Check for close signal */
     if ( ( glfwGetKey( system_instance.glfw_window, GLFW_KEY_ESCAPE ) == GLFW_PRESS ) ||
-         ( glfwWindowShouldClose( system_instance.glfw_window ) != 0 ) )
+         ( glfwWindowShouldClose( system_instance.glfw_window ) != 0 ) ||
+         ( ( NULL != system_instance.frame_capture ) && ( system_instance.frame_count >= system_instance.offscreen_config.frame_count ) ) )
     {
         system_instance.should_close_window = TRUE;
         return;
     }
 
+    if( NULL != system_instance.frame_capture )
+    {
+        frame_capture_begin( system_instance.frame_capture );
+    }
+
     /* Clear the last frame */
     glfwPollEvents();
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
@@ -258,7 +374,15 @@ static void frame
 
     /* Send the frame events out */
     memset( &event_data, 0, sizeof( frame_event_type ) );
-    event_data.timestamp = glfwGetTime();
+    if( NULL != system_instance.frame_capture )
+    {
+        /* Offscreen frames are evenly spaced in simulated time, so the images play back smoothly however slowly they render */
+        event_data.timestamp = ( system_instance.frame_count + 1 ) * system_instance.offscreen_config.frame_time;
+    }
+    else
+    {
+        event_data.timestamp = glfwGetTime();
+    }
     if( 0.0 == last_timestamp )
     {
         event_data.timesince_last_frame = 0.0;
@@ -269,6 +393,10 @@ static void frame
     }
     last_timestamp = event_data.timestamp;
 
+    /* Simulate in fixed steps up to the frame time, the frame shows the state part way into the next step */
+    run_steps( event_data.timesince_last_frame );
+    event_data.interpolation = system_instance.step_accumulator / system_instance.fixed_time_step;
+
 #if( PRINT_FRAMERATE )
     frames_since_second_start++;
 
@@ -288,11 +416,57 @@ static void frame
         cb( &event_data );
     }
 
+    system_instance.frame_count += 1;
+
+    if( NULL != system_instance.frame_capture )
+    {
+        frame_capture_end( system_instance.frame_capture );
+        return;
+    }
+
     /* Swap the buffer (finishing the frame) */
     glfwSwapBuffers( system_instance.glfw_window );
     glfwSwapInterval( 0 );
 }
 
+static void run_steps
+    (
+        GLdouble frame_time
+    )
+{
+    uint32_t                len;
+    uint32_t                i;
+    uint32_t                step;
+    step_event_callback     cb;
+    step_event_type         event_data;
+
+    system_instance.step_accumulator += frame_time;
+
+    memset( &event_data, 0, sizeof( step_event_type ) );
+    event_data.time_step = system_instance.fixed_time_step;
+
+    len = vector_size( system_instance.step_event_listeners );
+    for( step = 0; ( step < SYSTEM_MAX_STEPS_PER_FRAME ) && ( system_instance.step_accumulator >= system_instance.fixed_time_step ); ++step )
+    {
+        event_data.step_time = system_instance.step_time;
+
+        for( i = 0; i < len; ++i )
+        {
+            cb = *vector_access( system_instance.step_event_listeners, i, step_event_callback );
+            cb( &event_data );
+        }
+
+        system_instance.step_accumulator    -= system_instance.fixed_time_step;
+        system_instance.step_time           += system_instance.fixed_time_step;
+    }
+
+    /* Steps are slower than real time (or the window stalled), drop the backlog instead of spiralling */
+    if( system_instance.step_accumulator >= system_instance.fixed_time_step )
+    {
+        system_instance.step_accumulator = 0.0;
+    }
+}
+
 static void send_system_event
     (
         system_event_type const * event_data
@@ -18,6 +18,9 @@
 
 #define PRINT_FRAMERATE     ( TRUE )
 
+#define SYSTEM_DEFAULT_FIXED_TIME_STEP  ( 1.0 / 120.0 ) /* s */
+#define SYSTEM_MAX_STEPS_PER_FRAME      ( 8 )   /* Past this the simulation falls behind real time rather than stalling the display */
+
 /**********************************************************************
                               PROTOTYPES
 **********************************************************************/
@@ -38,6 +41,14 @@ void system_set_camera
         camera_type const * camera
     );
 
+/**
+ * @brief Sets the time advanced by every step event, independent of the frame rate
+ */
+void system_set_fixed_time_step
+    (
+        GLdouble time_step /* s */
+    );
+
 /**
  * @brief Initialize openGL and the system
  *
@@ -48,6 +59,19 @@ boolean system_init
         void
     );
 
+/**
+ * @brief Initialize openGL and the system to render into images instead
+ *        of a window, e.g. to make a movie of a long run on a batch node
+ *
+ * The window is still created, but hidden, to get an openGL context.
+ *
+ * @return TRUE on success, FALSE on failure
+ */
+boolean system_init_offscreen
+    (
+        system_offscreen_config_type const * config
+    );
+
 /**
  * @brief Run the application to completion
  */
@@ -64,4 +88,13 @@ GLFWwindow* system_get_window
         void
     );
 
+/**
+ * @brief Grab the frame arena, scratch memory for anything that only lives
+ *        until the end of the frame. It is reset at the start of every frame.
+ */
+arena_type * system_get_frame_arena
+    (
+        void
+    );
+
 #endif /* SYSTEM_H */
@@ -16,6 +16,7 @@
 #include "texture.h"
 #include "vector.h"
 #include "matrix_math.h"
+#include "triple_buffer.h"
 
 /**********************************************************************
                               CAMERA TYPES
@@ -32,6 +33,30 @@ typedef struct camera_struct
     vec3_type position;
 } camera_type;
 
+/**
+ * @brief Indices of the planes of a view frustum
+ */
+typedef uint8_t frustum_plane_t8; enum
+{
+    FRUSTUM_PLANE_LEFT,
+    FRUSTUM_PLANE_RIGHT,
+    FRUSTUM_PLANE_BOTTOM,
+    FRUSTUM_PLANE_TOP,
+    FRUSTUM_PLANE_NEAR,
+    FRUSTUM_PLANE_FAR,
+
+    FRUSTUM_PLANE_COUNT
+};
+
+/**
+ * @brief The volume a camera sees, as planes with unit normals pointing inwards
+ *        (a point p is inside a plane when x * p.x + y * p.y + z * p.z + w >= 0)
+ */
+typedef struct frustum_struct
+{
+    vec4_type planes[FRUSTUM_PLANE_COUNT];
+} frustum_type;
+
 
 /**********************************************************************
                            FRAME EVENT TYPES
@@ -44,6 +69,7 @@ typedef struct frame_event_struct
 {
     GLdouble timestamp;
     GLdouble timesince_last_frame;
+    GLdouble interpolation;         /* [0, 1), how far the frame is from the last fixed step towards the next one */
 } frame_event_type;
 
 
@@ -55,6 +81,27 @@ typedef void ( * frame_event_callback )
         frame_event_type const * event_data
     );
 
+/**********************************************************************
+                           STEP EVENT TYPES
+**********************************************************************/
+
+/**
+ * @brief A fixed simulation step, sent zero or more times per frame before the frame event
+ */
+typedef struct step_event_struct
+{
+    GLdouble step_time;             /* Simulated time at the start of the step */
+    GLdouble time_step;             /* Always the system fixed time step */
+} step_event_type;
+
+/**
+ * @brief
+ */
+typedef void ( * step_event_callback )
+    (
+        step_event_type const * event_data
+    );
+
 
 /**********************************************************************
                           OBJECT GROUP TYPES
@@ -90,14 +137,61 @@ typedef struct bone_struct
  */
 typedef struct object_struct
 {
-    uint16_t      object_id;
+    uint32_t      object_id;
+    uint32_t      group_index;       /* Of the object in its group's object list, which is unordered */
     boolean       is_visible;
     vec3_type     position;
-    mat4_type     model_matrix;
+    quat_type     rotation;          /* Around the model origin, unused by instanced groups */
+    GLfloat       scale;
+    vec3_type     colour;            /* Instanced groups only */
+    vec3_type     previous_position; /* Position at the start of the last fixed step */
+    vec3_type     step_displacement; /* Movement during the last fixed step, rendering interpolates across it */
+    mat4_type     model_matrix;      /* Built from position, rotation and scale, @see object_get_model_matrix */
+    boolean       model_matrix_dirty;
     shader_type*  shader;
     vector_type*  bones; /* Vector of bone_type, for each bone in the object */
 } object_type;
 
+/* object_ptr_vector_type, a vector of object_type* */
+VECTOR_DEFINE( object_ptr, object_type * )
+
+#define OBJECT_GROUP_MAX_LODS   ( 4 )   /* Meshes per group, the full detail one included */
+
+/* Streaming vertex buffer, @see stream_buffer.h */
+typedef struct stream_buffer_struct stream_buffer_type;
+
+/**
+ * @brief Per instance data of an instanced object group, as laid out in its instance buffer
+ */
+typedef struct object_instance_struct
+{
+    vec3_type     position;
+    GLfloat       scale;             /* Read with position as one vec4 */
+    vec3_type     colour;
+} object_instance_type;
+
+/**
+ * @brief One level of detail of an object group, a range of the group's vertex buffers
+ */
+typedef struct object_group_lod_struct
+{
+    uint32_t      first_vertex;
+    uint32_t      vertex_count;
+    GLfloat       distance_sq;       /* Used for objects at least this far from the camera, squared */
+} object_group_lod_type;
+
+/**
+ * @brief A lower detail mesh for an object group, @see object_group_create_argument_type
+ */
+typedef struct object_group_lod_mesh_struct
+{
+    vec3_type*    vertices;
+    vec3_type*    normals;           /* Given if the full detail mesh has normals */
+    uv_type*      uvs;               /* Given if the full detail mesh has uvs */
+    uint32_t      vertex_count;
+    GLfloat       distance;          /* Used for objects at least this far from the camera */
+} object_group_lod_mesh_type;
+
 /**
  * @brief
  */
@@ -105,6 +199,10 @@ typedef uint8_t object_event_type_t8; enum
 {
     OBJECT_EVENT_TYPE_RENDER_START,     /* Rendering of an object type has started, the shader is bound and uniforms can be passed in. */
     OBJECT_EVENT_TYPE_RENDER_OBJECT,    /* Rendering of a particular object is about to start. Changes to that objects position, rotation or scale will appear in the next frame. */
+    OBJECT_EVENT_TYPE_STEP_START,       /* A fixed simulation step of an object type has started. */
+    OBJECT_EVENT_TYPE_STEP_OBJECT,      /* A fixed simulation step of a particular object, position changes here are interpolated when rendering. */
+    OBJECT_EVENT_TYPE_RENDER_BATCH,     /* Replaces OBJECT_EVENT_TYPE_RENDER_OBJECT for groups created with batch_events, every object at once. */
+    OBJECT_EVENT_TYPE_STEP_BATCH,       /* Replaces OBJECT_EVENT_TYPE_STEP_OBJECT for groups created with batch_events, every object at once. */
 
     OBJECT_EVENT_TYPE_RENDER_COUNT
 };
@@ -115,6 +213,7 @@ typedef uint8_t object_event_type_t8; enum
 typedef struct object_event_type_render_start_data_struct
 {
     shader_type const *  shader;
+    void const *         state;             /* Latest item of the group's state buffer, NULL if it has none or nothing is published yet */
 } object_event_type_render_start_data_type;
 
 /**
@@ -124,8 +223,31 @@ typedef struct object_event_type_render_object_data_struct
 {
     object_type*         object;
     GLdouble             time_since_last_frame;
+    GLdouble             interpolation;     /* @see frame_event_type */
+    void const *         state;             /* @see object_event_type_render_start_data_type */
 } object_event_type_render_object_data_type;
 
+/**
+ * @brief
+ */
+typedef struct object_event_type_step_data_struct
+{
+    object_type*         object;            /* NULL for OBJECT_EVENT_TYPE_STEP_START */
+    GLdouble             time_step;
+} object_event_type_step_data_type;
+
+/**
+ * @brief
+ */
+typedef struct object_event_type_batch_data_struct
+{
+    object_type * const * objects;          /* Every object in the group, in one array */
+    uint32_t             count;
+    GLdouble             time_step;         /* The fixed step for OBJECT_EVENT_TYPE_STEP_BATCH, the time since the last frame for OBJECT_EVENT_TYPE_RENDER_BATCH */
+    GLdouble             interpolation;     /* OBJECT_EVENT_TYPE_RENDER_BATCH only, @see frame_event_type */
+    void const *         state;             /* OBJECT_EVENT_TYPE_RENDER_BATCH only, @see object_event_type_render_start_data_type */
+} object_event_type_batch_data_type;
+
 /**
  * @brief
  */
@@ -133,6 +255,8 @@ typedef union object_event_data_union
 {
     object_event_type_render_start_data_type  render_start_data;    /* Data for OBJECT_EVENT_TYPE_RENDER_START */
     object_event_type_render_object_data_type render_object_data;   /* Data for OBJECT_EVENT_TYPE_RENDER_OBJECT */
+    object_event_type_step_data_type          step_data;            /* Data for OBJECT_EVENT_TYPE_STEP_START and OBJECT_EVENT_TYPE_STEP_OBJECT */
+    object_event_type_batch_data_type         batch_data;           /* Data for OBJECT_EVENT_TYPE_RENDER_BATCH and OBJECT_EVENT_TYPE_STEP_BATCH */
 } object_event_data_type;
 
 /**
@@ -161,12 +285,20 @@ typedef struct object_group_struct
     GLuint          vertex_array_object;
     camera_type   * camera;
     shader_type   * shader;
-    sint8_t const * model_uniform_name;
+    shader_uniform_type model_uniform; /* Resolved from the model uniform name, SHADER_UNIFORM_NONE if it wasn't given */
     texture_type  * texture;
-    vector_type   * objects; /* Array of object_type* representing each unique object in the group */
-    uint32_t        vertex_count;
+    object_ptr_vector_type objects; /* Every unique object in the group */
+    object_group_lod_type lods[OBJECT_GROUP_MAX_LODS]; /* Full detail first, then by increasing distance */
+    uint8_t         lod_count;
+    GLfloat         bounding_radius; /* Of a sphere around the model origin holding every vertex, objects outside the camera's view are skipped */
     vector_type   * buffers_to_delete; /* GLuint Random buffers that must be deleted when the object goes out of scope */
     object_cb_type  object_cb;
+    boolean         batch_events;
+    triple_buffer_type * state_buffer; /* Optional, published by another thread and read once per frame */
+    boolean         instanced;
+    uint8_t         instance_position_channel;
+    uint8_t         instance_colour_channel;
+    stream_buffer_type * instance_stream; /* object_instance_type, rewritten every frame */
 } object_group_type;
 
 /**
@@ -185,6 +317,14 @@ typedef struct object_group_create_argument_struct
     uint32_t        vertex_count;
     texture_type*   texture;      /* A texture object (@see texture.h), will be automatically deleted when the object group goes out of scope.  */
     object_cb_type  object_cb;    /* Will be called on every frame for each instance of this object type. @see object_event_type_t8 */
+    boolean         batch_events; /* Call object_cb once per frame and step with every object, instead of once per object. Lets the update be one tight loop. */
+    triple_buffer_type* state_buffer; /* (Optional) State produced on another thread, e.g. by a sim runner (@see sim_runner.h). The group is its only reader. */
+    boolean         instanced;    /* Draw every object in one instanced draw call. Objects are then placed by position, scale and colour only, model_uniform_name is unused. */
+    uint8_t         instance_position_channel; /* Instanced only, vec4 of the instance position in xyz and scale in w */
+    uint8_t         instance_colour_channel;   /* Instanced only, vec3 of the instance colour */
+    object_group_lod_mesh_type const * lods; /* (Optional) Lower detail meshes with the same channels, by increasing distance */
+    uint8_t         lod_count;    /* At most OBJECT_GROUP_MAX_LODS - 1 */
+    GLfloat         bounding_radius; /* (Optional) Culling radius around the model origin, 0 to fit it to the vertices. Needed if the vertex shader moves vertices further out. */
 } object_group_create_argument_type;
 
 
@@ -238,8 +378,25 @@ typedef struct system_listener_callbacks_struct
 {
     system_event_callback   system_event_cb;
     frame_event_callback    frame_event_cb;
+    step_event_callback     step_event_cb;
 } system_listener_callbacks_type;
 
+/* Offscreen render target, @see frame_capture.h */
+typedef struct frame_capture_struct frame_capture_type;
+
+/**
+ * @brief How to run without a visible window, @see system_init_offscreen
+ */
+typedef struct system_offscreen_config_struct
+{
+    uint32_t                  width;                /* Image size in pixels */
+    uint32_t                  height;
+    sint8_t const           * output_pattern;       /* @see frame_capture_create */
+    sint8_t const           * encoder_command;      /* (Optional) @see frame_capture_create */
+    uint32_t                  frame_count;          /* Frames to render before system_run returns */
+    GLdouble                  frame_time;           /* s, frames are this far apart in simulated time however long they take to render */
+} system_offscreen_config_type;
+
 /**
  * @brief
  */
@@ -249,7 +406,15 @@ typedef struct system_struct
     camera_type             * system_camera;
     vector_type             * system_event_listeners;
     vector_type             * frame_event_listeners;
+    vector_type             * step_event_listeners;
+    GLdouble                  fixed_time_step;
+    GLdouble                  step_accumulator;     /* Frame time not yet simulated, less than one fixed step after each frame */
+    GLdouble                  step_time;            /* Simulated time */
     boolean                   should_close_window;
+    frame_capture_type      * frame_capture;        /* Offscreen only, every frame is drawn into it */
+    system_offscreen_config_type offscreen_config;
+    uint32_t                  frame_count;          /* Frames rendered */
+    arena_type              * frame_arena;          /* Scratch memory, reset at the start of every frame */
 } system_type;
 
 #endif /* SYSTEM_TYPES_H */
@@ -17,6 +17,7 @@
 #include "bouncy_sphere.h"
 #include "model_loader.h"
 #include "camera_util.h"
+#include "lighting.h"
 #include "string.h"
 
 /**********************************************************************
@@ -26,25 +27,6 @@
 /* Use C built in string concat for easy filename assembly */
 #define RESOURCE_DIR( filename ) "src/example/bouncy_sphere/resource/"filename
 
-/**********************************************************************
-                               TYPES
-**********************************************************************/
-
-typedef struct directional_light_config_struct {
-	vec3_type position;
-	vec3_type ambient;
-	vec3_type diffuse;
-	vec3_type specular;
-    vec3_type attenuation;
-} directional_light_config_type;
-
-typedef struct material_config_struct {
-	vec3_type ambient;
-	vec3_type diffuse;
-	vec3_type specular;
-	GLfloat shininess;
-} material_config_type;
-
 /**********************************************************************
                              PROTOTYPES
 **********************************************************************/
@@ -82,19 +64,20 @@ static void bouncy_sphere_pass_uniforms
     );
 
 /**
- * @brief Apply gravity to the sphere
+ * @brief Apply gravity to the spheres, they all share one speed
  */ 
 static void bouncy_sphere_apply_gravity
     (
-        object_type* object,
-        GLfloat      dt
+        object_type* const* objects,
+        uint32_t            count,
+        GLfloat             dt
     );
 
 /**********************************************************************
                              VARIABLES
 **********************************************************************/
 
-static directional_light_config_type light_config =
+static light_type light_config =
 {
     { 100.0f, 0.0f, 0.0f },   /* position */
     { 0.1f, 0.3f, 0.1f },   /* ambient */
@@ -103,7 +86,7 @@ static directional_light_config_type light_config =
     { 0.0f, 0.0f, 0.00005f }    /* attenuation */
 };
 
-static material_config_type material_config =
+static material_type material_config =
 {
     { 1.0f, 1.0f, 1.0f },   /* ambient */
     { 1.0f, 1.0f, 1.0f },   /* diffuse */
@@ -183,6 +166,7 @@ static void create_object_group
     bouncy_sphere.uv_channel = 0;                            /* Doesn't matter, no uvs provided. */
     bouncy_sphere.vertex_count = vector_size( model.vertices );
     bouncy_sphere.object_cb = object_cb;                     /* Called each frame and on system events */
+    bouncy_sphere.batch_events = TRUE;                       /* Step every sphere in one call */
 
     /* Create the group. */
     bouncy_sphere_group = object_group_create( &bouncy_sphere );
@@ -226,11 +210,12 @@ static void object_cb
     case OBJECT_EVENT_TYPE_RENDER_START:
         bouncy_sphere_pass_uniforms();
         break;
-    case OBJECT_EVENT_TYPE_RENDER_OBJECT:
+    case OBJECT_EVENT_TYPE_STEP_BATCH:
         bouncy_sphere_apply_gravity
         (
-            event_data->event_data.render_object_data.object,
-            event_data->event_data.render_object_data.time_since_last_frame
+            event_data->event_data.batch_data.objects,
+            event_data->event_data.batch_data.count,
+            event_data->event_data.batch_data.time_step
         );
         break;
     default:
@@ -243,88 +228,30 @@ static void bouncy_sphere_pass_uniforms
         void
     )
 {
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "camera_position",
-            &camera.position
-        );
-
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "light_config.position",
-            &light_config.position
-        );
-    
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "light_config.diffuse",
-            &light_config.diffuse
-        );
-
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "light_config.specular",
-            &light_config.specular
-        );
-
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "light_config.ambient",
-            &light_config.ambient
-        );
-
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "light_config.attenuation",
-            &light_config.attenuation
-        );
-
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "material_config.ambient",
-            &material_config.ambient
-        );
-
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "material_config.specular",
-            &material_config.specular
-        );
-
-    shader_set_uniform_vec3
-        (
-            bouncy_sphere_group->shader,
-            "material_config.diffuse",
-            &material_config.diffuse
-        );
-
-    shader_set_uniform_float
-        (
-            bouncy_sphere_group->shader,
-            "material_config.shininess",
-            material_config.shininess
-        );
+    /* The camera is passed in by the object group, these only upload when they change */
+    lighting_set_light( &light_config );
+    lighting_set_material( &material_config );
 }
 
 static void bouncy_sphere_apply_gravity
     (
-        object_type* object,
-        GLfloat      dt
+        object_type* const* objects,
+        uint32_t            count,
+        GLfloat             dt
     )
 {
     static vec3_type speed = { 0 };
     vec3_type pos;
     vec3_type dv = { 0 };
+    uint32_t  i;
 
-    object_get_position( object, &pos );
+    if( 0 == count )
+    {
+        return;
+    }
+
+    /* The spheres move together, so the first one decides the bounce */
+    object_get_position( objects[0], &pos );
 
     /* If the object passed ground level, bounce it. */
     if( pos.y < -15.0f && speed.y < 0.0f )
@@ -342,5 +269,8 @@ static void bouncy_sphere_apply_gravity
     }
 
     /* Apply speed to position */
-    object_translate( object, &speed );
+    for( i = 0; i < count; ++i )
+    {
+        object_translate( objects[i], &speed );
+    }
 }
\ No newline at end of file
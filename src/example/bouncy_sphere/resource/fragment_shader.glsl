@@ -1,28 +1,33 @@
 #version 330 core
 
-struct point_light_config_type {
-	vec3 position;
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-    vec3 attenuation;
-};
-
-struct material_config_type {
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-	float shininess;
-};
-
 out vec4 color;
 in vec3 normal_out;
 in vec3 pos_out;
 
 uniform sampler2D image;
-uniform vec3 camera_position;
-uniform point_light_config_type light_config;
-uniform material_config_type material_config;
+
+layout(std140) uniform camera_block
+{
+    mat4 projection_view_matrix;
+    vec3 camera_position;
+};
+
+layout(std140) uniform light_block
+{
+    vec3 light_position;
+    vec3 light_ambient;
+    vec3 light_diffuse;
+    vec3 light_specular;
+    vec3 light_attenuation;
+};
+
+layout(std140) uniform material_block
+{
+    vec3 material_ambient;
+    vec3 material_diffuse;
+    vec3 material_specular;
+    float material_shininess;
+};
 
 /*
 	Calculate the effect of a point light on this fragment
@@ -50,20 +55,20 @@ void main()
 vec3 calculate_point_light_factor()
 {
 	vec3 view_direction = normalize( camera_position - pos_out );
-	vec3 light_direction = normalize( light_config.position - pos_out );
+	vec3 light_direction = normalize( light_position - pos_out );
 	float diffuse = max( dot( normal_out, light_direction ), 0.0 );
 
 	vec3 reflect_direction = reflect( -light_direction, normal_out ) ;
 
-	float specular = pow( max( dot( view_direction, reflect_direction ), 0.0 ), material_config.shininess );
+	float specular = pow( max( dot( view_direction, reflect_direction ), 0.0 ), material_shininess );
 
-	vec3 ambient_factor = light_config.ambient * material_config.ambient;
-	vec3 diffuse_factor = light_config.diffuse * diffuse * material_config.diffuse;
-	vec3 specular_factor = light_config.specular * specular * material_config.specular;
+	vec3 ambient_factor = light_ambient * material_ambient;
+	vec3 diffuse_factor = light_diffuse * diffuse * material_diffuse;
+	vec3 specular_factor = light_specular * specular * material_specular;
 
-    float distance = length( light_config.position - pos_out );
+    float distance = length( light_position - pos_out );
 	
-    float attenuation = 1.0f / ( light_config.attenuation.x + light_config.attenuation.y * distance + light_config.attenuation.z * distance * distance);
+    float attenuation = 1.0f / ( light_attenuation.x + light_attenuation.y * distance + light_attenuation.z * distance * distance);
 
 	return ( ambient_factor + diffuse_factor + specular_factor ) * attenuation;
 }
\ No newline at end of file
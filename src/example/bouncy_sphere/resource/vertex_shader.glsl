@@ -3,7 +3,11 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 
-uniform mat4 projection_view_matrix;
+layout(std140) uniform camera_block
+{
+    mat4 projection_view_matrix;
+    vec3 camera_position;
+};
 uniform mat4 model_matrix;
 
 out vec3 normal_out;
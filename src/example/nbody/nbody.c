@@ -0,0 +1,345 @@
+/**
+ * @file nbody.c
+ *
+ * @brief Sample app that attaches the object group renderer to the
+ *        headless gravity simulation.
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "object.h"
+#include "object_group_core.h"
+#include "particle_renderer.h"
+#include "camera.h"
+#include "camera_util.h"
+#include "file_api.h"
+#include "model_loader.h"
+#include "nbody.h"
+#include "sim.h"
+#include "sim_runner.h"
+#include "sim_setup.h"
+#include "string.h"
+#include "system.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+/* Use C built in string concat for easy filename assembly */
+#define RESOURCE_DIR( filename ) "src/example/nbody/resource/"filename
+
+#define NBODY_PARTICLE_COUNT    ( 200 )
+#define NBODY_CLUSTER_RADIUS    ( 50.0f )
+#define NBODY_CLUSTER_MASS      ( 1000.0f )
+#define NBODY_SOFTENING         ( 1.0f )
+#define NBODY_TIME_STEP         ( 0.01f )
+#define NBODY_SEED              ( 1 )
+#define NBODY_STEPS_PER_SECOND  ( 120.0 )
+#define NBODY_POINT_SPRITES     ( FALSE )   /* Draw bodies as point sprite impostors instead of meshes, for large body counts */
+#define NBODY_BODY_RADIUS       ( 1.0f )    /* Point sprite size */
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Create and assign a system camera.
+ */
+static void create_camera
+    (
+    void
+    );
+
+/**
+ * @brief Initialize the simulation and its bodies.
+ */
+static void create_sim
+    (
+    void
+    );
+
+/**
+ * @brief Initialize the sphere object group and one sphere per body
+ */
+static void create_object_group
+    (
+    void
+    );
+
+/**
+ * @brief Initialize the point sprite renderer
+ */
+static void create_particle_renderer
+    (
+    void
+    );
+
+/**
+ * @brief Callback for system events, stops the runner and frees the sim on deinit.
+ */
+static void system_cb
+    (
+    system_event_type const * event_data
+    );
+
+/**
+ * @brief Callback for object events, moves each sphere to its body in the latest sim snapshot.
+ */
+static void object_cb
+    (
+    object_event_type const * event_data
+    );
+
+/**********************************************************************
+                             VARIABLES
+**********************************************************************/
+
+static object_group_type*   nbody_group;
+static camera_type          camera;
+static sim_type*            sim;
+static sim_runner_type*     runner;
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void nbody_start
+    (
+    void
+    )
+{
+    create_camera();
+    create_sim();
+
+    /* The point sprite renderer draws straight from the sim snapshots, no objects needed */
+    if( NBODY_POINT_SPRITES )
+    {
+        create_particle_renderer();
+    }
+    else
+    {
+        create_object_group();
+    }
+
+    /* Note: the render system will automatically free remaining objects, the sim and its runner are freed by system_cb. */
+}
+
+static void create_sim
+    (
+    void
+    )
+{
+    sim_config_type                 config;
+    sim_vec3_type                   centre;
+    system_listener_callbacks_type  callbacks;
+
+    sim_config_default( &config );
+    config.softening = NBODY_SOFTENING;
+    config.time_step = NBODY_TIME_STEP;
+
+    sim = sim_create( &config );
+
+    centre.x = 0.0f;
+    centre.y = 0.0f;
+    centre.z = 0.0f;
+    sim_setup_uniform_sphere( sim, NBODY_PARTICLE_COUNT, &centre, NBODY_CLUSTER_RADIUS, NBODY_CLUSTER_MASS, NBODY_SEED );
+
+    /* Steps run on their own thread from here on, the renderer only sees the snapshots */
+    runner = sim_runner_create( sim, NBODY_STEPS_PER_SECOND );
+
+    /* Stop the runner thread before the system shuts down, the renderers only read the snapshots while drawing */
+    memset( &callbacks, 0, sizeof( callbacks ) );
+    callbacks.system_event_cb = system_cb;
+    register_system_listeners( &callbacks );
+}
+
+static void create_object_group
+    (
+    void
+    )
+{
+    vector_type*                      vertex_shader_code;
+    vector_type*                      fragment_shader_code;
+    object_group_create_argument_type nbody;
+    model_load_data_out_type          model;
+    uint32_t                          i;
+    object_type*                      body;
+    vec3_type                         colour;
+
+    memset( &nbody, 0, sizeof( nbody ) );
+
+    /* Read shaders into RAM. */
+    vertex_shader_code = vector_init( sizeof( sint8_t ) );
+    fragment_shader_code = vector_init( sizeof( sint8_t ) );
+
+    file_read( RESOURCE_DIR( "vertex_shader.glsl" ), vertex_shader_code );
+    file_read( RESOURCE_DIR( "fragment_shader.glsl" ), fragment_shader_code );
+
+    /* Build shaders from source. */
+    nbody.shader = shader_build
+    (
+        vector_access( vertex_shader_code, 0, sint8_t ),
+        vector_access( fragment_shader_code, 0, sint8_t )
+    );
+
+    /* Free shader code. */
+    vector_deinit( vertex_shader_code );
+    vector_deinit( fragment_shader_code );
+
+    /* Load the model */
+    model_load( MODEL_FILE_FORMAT_AUTO, RESOURCE_DIR( "sphere.STL" ), &model );
+
+    /* Assign vertex info, shader info. */
+    nbody.model_uniform_name = NULL;                         /* Instanced, bodies are placed by the instance position instead */
+    nbody.vertices = (vec3_type*)vector_access( model.vertices, 0, vec3_type );
+    nbody.vertex_channel = 0;                                /* Corresponds with layout(location = 0) in vertex_shader.glsl */
+    nbody.normals = (vec3_type*)vector_access( model.normals, 0, vec3_type );
+    nbody.normal_channel = 1;                                /* Corresponds with layout(location = 1) in vertex_shader.glsl */
+    nbody.uvs = NULL;
+    nbody.uv_channel = 0;                                    /* Doesn't matter, no uvs provided. */
+    nbody.vertex_count = vector_size( model.vertices );
+    nbody.object_cb = object_cb;                             /* Called each frame and on system events */
+    nbody.batch_events = TRUE;                               /* Place every body in one loop over the snapshot */
+    nbody.instanced = TRUE;                                  /* Every body in one draw call */
+    nbody.instance_position_channel = 2;                     /* Corresponds with layout(location = 2) in vertex_shader.glsl */
+    nbody.instance_colour_channel = 3;                       /* Corresponds with layout(location = 3) in vertex_shader.glsl */
+    nbody.state_buffer = sim_runner_snapshots( runner );     /* Snapshots come through as the render event state */
+
+    /* Create the group. */
+    nbody_group = object_group_create( &nbody );
+
+    /* Free the model. */
+    model_load_free_data( &model );
+
+    /* One sphere per body, object ids line up with the particle handles. The runner owns the sim now, so go by the setup count */
+    vec3_set( &colour, 1.0f, 0.9f, 0.7f );
+    for( i = 0; i < NBODY_PARTICLE_COUNT; ++i )
+    {
+        body = object_create( nbody_group );
+        object_set_visibility( body, TRUE );
+        object_set_colour( body, &colour );
+    }
+}
+
+static void create_particle_renderer
+    (
+    void
+    )
+{
+    vector_type*                           vertex_shader_code;
+    vector_type*                           fragment_shader_code;
+    particle_renderer_create_argument_type particles;
+
+    memset( &particles, 0, sizeof( particles ) );
+
+    /* Read shaders into RAM. */
+    vertex_shader_code = vector_init( sizeof( sint8_t ) );
+    fragment_shader_code = vector_init( sizeof( sint8_t ) );
+
+    file_read( RESOURCE_DIR( "particle_vertex_shader.glsl" ), vertex_shader_code );
+    file_read( RESOURCE_DIR( "particle_fragment_shader.glsl" ), fragment_shader_code );
+
+    /* Build shaders from source. */
+    particles.shader = shader_build
+    (
+        vector_access( vertex_shader_code, 0, sint8_t ),
+        vector_access( fragment_shader_code, 0, sint8_t )
+    );
+
+    /* Free shader code. */
+    vector_deinit( vertex_shader_code );
+    vector_deinit( fragment_shader_code );
+
+    particles.position_x_channel = 0;                        /* Corresponds with layout(location = 0) in particle_vertex_shader.glsl */
+    particles.position_y_channel = 1;                        /* Corresponds with layout(location = 1) in particle_vertex_shader.glsl */
+    particles.position_z_channel = 2;                        /* Corresponds with layout(location = 2) in particle_vertex_shader.glsl */
+    particles.radius = NBODY_BODY_RADIUS;
+    vec3_set( &particles.colour, 1.0f, 0.9f, 0.7f );
+    particles.state_buffer = sim_runner_snapshots( runner ); /* Uploaded whenever the runner publishes a step */
+
+    particle_renderer_create( &particles );
+}
+
+static void create_camera
+    (
+    void
+    )
+{
+    vec3_type from;
+    vec3_type to;
+    vec3_type up;
+    GLfloat   fov;
+
+    fov = 90.0f * M_PI / 180.0f;
+
+    camera_init( &camera );
+    camera_set_perspective( &camera, fov, 1920, 1080, 0.1f, 1000.0f );
+
+    vec3_set( &from, 100.0f, 100.0f, 100.0f );
+    vec3_set( &to, 0.0f, 0.0f, 0.0f );
+    vec3_set( &up, 0.0f, 1.0f, 0.0f );
+
+    camera_set_view( &camera, &from, &to, &up );
+
+    camera_util_init();
+    camera_util_enable_mouse_keyboard_control( &camera, fov, 0.1f, 1000.0f );
+}
+
+static void object_cb
+    (
+    object_event_type const * event_data
+    )
+{
+    object_type* const*         bodies;
+    sim_snapshot_type const*    snapshot;
+    vec3_type                   position;
+    uint32_t                    id;
+    uint32_t                    i;
+
+    switch( event_data->event_type )
+    {
+    case OBJECT_EVENT_TYPE_RENDER_BATCH:
+        bodies = event_data->event_data.batch_data.objects;
+        snapshot = (sim_snapshot_type const*)event_data->event_data.batch_data.state;
+        if( NULL == snapshot )
+        {
+            break;
+        }
+
+        /* No bodies are removed, so the object ids are the dense indices of the snapshot */
+        for( i = 0; i < event_data->event_data.batch_data.count; ++i )
+        {
+            id = bodies[i]->object_id;
+            if( id >= snapshot->count )
+            {
+                continue;
+            }
+
+            vec3_set( &position, snapshot->position_x[id], snapshot->position_y[id], snapshot->position_z[id] );
+            object_set_position( bodies[i], &position );
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void system_cb
+    (
+    system_event_type const * event_data
+    )
+{
+    if( ( SYSTEM_EVENT_DEINIT_START != event_data->event_type ) || ( NULL == runner ) )
+    {
+        return;
+    }
+
+    /* The runner owns the sim until it is freed */
+    sim_runner_free( runner );
+    runner = NULL;
+
+    sim_free( sim );
+    sim = NULL;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file nbody.h
+ *
+ * @brief App that visualizes the n-body gravity simulation,
+ *        drawing every body as a sphere.
+ */
+#ifndef NBODY_H
+#define NBODY_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "system_types.h"
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Starts the n-body app.
+ *
+ * Should be called after system init.
+ */
+void nbody_start
+    (
+    void
+    );
+
+#endif /* NBODY_H */
@@ -0,0 +1,3 @@
+INCLUDE += src/example/nbody
+
+SOURCES += src/example/nbody/nbody.c
@@ -0,0 +1,21 @@
+#version 330 core
+
+out vec4 color;
+in vec3 normal_out;
+in vec3 pos_out;
+in vec3 colour_out;
+
+layout(std140) uniform camera_block
+{
+    mat4 projection_view_matrix;
+    vec3 camera_position;
+};
+
+void main()
+{
+    /* Light every body from the camera so the whole cluster stays visible */
+    vec3 view_direction = normalize( camera_position - pos_out );
+    float diffuse = max( dot( normalize( normal_out ), view_direction ), 0.0 );
+
+    color = vec4( ( 0.2f + 0.8f * diffuse ) * colour_out, 1.0 );
+}
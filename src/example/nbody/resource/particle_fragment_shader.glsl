@@ -0,0 +1,22 @@
+#version 330 core
+
+out vec4 color;
+
+uniform vec3 particle_colour;
+
+void main()
+{
+    /* Point coordinates to a unit disc, anything outside the sphere's silhouette is dropped */
+    vec2 disc = gl_PointCoord * 2.0f - 1.0f;
+    float radius_sq = dot( disc, disc );
+
+    if( radius_sq > 1.0f )
+    {
+        discard;
+    }
+
+    /* The sphere normal at this pixel, lit from the camera like the mesh bodies */
+    vec3 normal = vec3( disc.x, -disc.y, sqrt( 1.0f - radius_sq ) );
+
+    color = vec4( ( 0.2f + 0.8f * normal.z ) * particle_colour, 1.0 );
+}
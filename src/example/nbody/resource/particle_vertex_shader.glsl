@@ -0,0 +1,20 @@
+#version 330 core
+
+layout(location = 0) in float position_x;
+layout(location = 1) in float position_y;
+layout(location = 2) in float position_z;
+
+layout(std140) uniform camera_block
+{
+    mat4 projection_view_matrix;
+    vec3 camera_position;
+};
+uniform float point_scale;
+
+void main()
+{
+    gl_Position = projection_view_matrix * vec4(position_x, position_y, position_z, 1.0f);
+
+    /* Perspective size of the body, at least a pixel so distant bodies don't vanish */
+    gl_PointSize = max( point_scale / gl_Position.w, 1.0f );
+}
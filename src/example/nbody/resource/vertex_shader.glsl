@@ -0,0 +1,27 @@
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec4 instance_position_scale;
+layout(location = 3) in vec3 instance_colour;
+
+layout(std140) uniform camera_block
+{
+    mat4 projection_view_matrix;
+    vec3 camera_position;
+};
+
+out vec3 normal_out;
+out vec3 pos_out;
+out vec3 colour_out;
+
+void main()
+{
+    /* Bodies are only placed and scaled, so the model normal is already the world normal */
+    pos_out = position * instance_position_scale.w + instance_position_scale.xyz;
+
+    gl_Position = projection_view_matrix * vec4(pos_out, 1.0f);
+
+    normal_out = normal;
+    colour_out = instance_colour;
+}
\ No newline at end of file
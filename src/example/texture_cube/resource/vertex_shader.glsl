@@ -5,7 +5,11 @@ layout(location = 1) in vec2 uv;
 
 out vec2 UV;
 
-uniform mat4 projection_view_matrix;
+layout(std140) uniform camera_block
+{
+    mat4 projection_view_matrix;
+    vec3 camera_position;
+};
 uniform mat4 model_matrix;
 
 void main()
@@ -15,6 +15,7 @@
 #include "stdio.h"
 #include "model_loader.h"
 #include "texture_cube.h"
+#include "string.h"
 
 /**********************************************************************
                             LITERAL CONSTANTS
@@ -90,6 +91,8 @@ static void create_object_group
 vector_type*                      vertex_shader_code;
 vector_type*                      fragment_shader_code;
 object_group_create_argument_type texture_cube;
+
+memset( &texture_cube, 0, sizeof( texture_cube ) );
     
 /* Read shaders into RAM. */
 vertex_shader_code = vector_init(sizeof(sint8_t));
@@ -41,7 +41,7 @@ boolean file_read
     )
 {
     FILE*       fp;
-    uint8_t     read_buffer[READ_BUFFER_SIZE];
+    uint32_t    size;
     uint32_t    read_count;
     boolean     status;
 
@@ -63,10 +63,13 @@ boolean file_read
 
     vector_empty( contents );
 
+    /* Read straight into the vector, a chunk at a time */
     while( TRUE )
     {
-        read_count = fread( read_buffer, 1, sizeof( read_buffer ), fp );
-        vector_push_back_many( contents, read_buffer, read_count );
+        size = vector_size( contents );
+        vector_resize_uninitialized( contents, size + READ_BUFFER_SIZE );
+        read_count = fread( vector_access( contents, size, sint8_t ), 1, READ_BUFFER_SIZE, fp );
+        vector_resize_uninitialized( contents, size + read_count );
 
         if( 0 == read_count )
         {
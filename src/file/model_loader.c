@@ -17,6 +17,7 @@
 #include "system_types.h"
 
 #define STL_MIN_LEN ( 19 )
+#define LOAD_ARENA_BLOCK_SIZE ( 1 << 20 )   /* Bytes, file contents and tokens bigger than this get blocks of their own */
 
 /**********************************************************************
                                     TYPES
@@ -73,6 +74,7 @@ static boolean model_load_format_stl
 static boolean model_load_format_stl_ascii
     (
         vector_type*              file_contents, /* in: sint8_t */
+        arena_type*               arena,         /* for working memory */
         model_load_data_out_type* model_load_data_out
     );
 
@@ -95,12 +97,7 @@ static boolean is_whitespace
 
 static ascii_token_type* ascii_token_init
     (
-        void
-    );
-
-static void ascii_token_deinit
-    (
-        ascii_token_type* tokens
+        arena_type* arena
     );
 
 static sint8_t const * ascii_token_get_token
@@ -228,14 +225,18 @@ static boolean model_load_format_stl
         model_load_data_out_type* model_load_data_out
     )
 {
+    arena_type*     arena;
     vector_type*    file_contents;
     uint32_t        len;
     boolean         ret;
 
-    file_contents = vector_init( sizeof( sint8_t ) );
+    /* Everything but the output lives in the arena, and goes with it */
+    arena = arena_create( LOAD_ARENA_BLOCK_SIZE );
+
+    file_contents = vector_init_arena( sizeof( sint8_t ), arena );
     if( !file_read( file_name, file_contents ) )
     {
-        vector_deinit( file_contents );
+        arena_free( arena );
         DEBUG_LINE();
         return FALSE;
     }
@@ -243,27 +244,28 @@ static boolean model_load_format_stl
     len = vector_size( file_contents );
     if( len < STL_MIN_LEN )
     {
-        vector_deinit( file_contents );
+        arena_free( arena );
         DEBUG_LINE();
         return FALSE;
     }
 
     if( 0 == memcmp( vector_access(  file_contents, 0, sint8_t ), "solid", 5 ) )
     {
-        ret = model_load_format_stl_ascii( file_contents, model_load_data_out );
+        ret = model_load_format_stl_ascii( file_contents, arena, model_load_data_out );
     }
     else
     {
         ret = model_load_format_stl_binary( file_contents, model_load_data_out );
     }
 
-    vector_deinit( file_contents );
+    arena_free( arena );
     return ret;
 }
 
 static boolean model_load_format_stl_ascii
     (
         vector_type*              file_contents, /* in: sint8_t */
+        arena_type*               arena,
         model_load_data_out_type* model_load_data_out
     )
 {
@@ -287,7 +289,7 @@ static boolean model_load_format_stl_ascii
     normals  = vector_init( sizeof( vec3_type ) );
 
     /* Init token obj */
-    tokens = ascii_token_init();
+    tokens = ascii_token_init( arena );
 
     /* Tokenize the file contents */
     ascii_token_parse_tokens( tokens, file_contents );
@@ -353,9 +355,6 @@ static boolean model_load_format_stl_ascii
         token = ascii_token_get_token( tokens );
     }
 
-    /* Deinit token resources */
-    ascii_token_deinit( tokens );
-
     /* Assert vertices == normals */
     if( vector_size( vertices ) != vector_size( normals ) )
     {
@@ -406,6 +405,9 @@ static void ascii_token_parse_tokens
     len = vector_size( string );
     token_index = 0;
 
+    /* The token string is at most as long as the input */
+    vector_reserve( tokens->token_string, len );
+
     for( i = 0; i < len; ++i )
     {
         current_char = c_str[i];
@@ -462,25 +464,16 @@ static boolean is_whitespace
 
 static ascii_token_type* ascii_token_init
     (
-        void
+        arena_type* arena
     )
 {
-    ascii_token_type* tokens    = calloc( sizeof( ascii_token_type ), 1 );
-    tokens->token_indices       = vector_init( sizeof( uint32_t ) );
-    tokens->token_string        = vector_init( sizeof( sint8_t ) );
+    ascii_token_type* tokens    = arena_alloc( arena, sizeof( ascii_token_type ) );
+    memset( tokens, 0, sizeof( ascii_token_type ) );
+    tokens->token_indices       = vector_init_arena( sizeof( uint32_t ), arena );
+    tokens->token_string        = vector_init_arena( sizeof( sint8_t ), arena );
     return tokens;
 }
 
-static void ascii_token_deinit
-    (
-        ascii_token_type* tokens
-    )
-{
-    vector_deinit( tokens->token_indices );
-    vector_deinit( tokens->token_string );
-    free( tokens );
-}
-
 static sint8_t const * ascii_token_get_token
     (
         ascii_token_type* tokens
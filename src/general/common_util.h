@@ -48,5 +48,14 @@
 
 #define array_count( a )  ( sizeof( a ) / sizeof( ( a )[0] ) )
 
+/* C89 has no inline keyword, use the compiler's own so small functions in headers get inlined (and unused ones don't warn) */
+#if defined( __GNUC__ )
+    #define INLINE __inline__
+#elif defined( _MSC_VER )
+    #define INLINE __inline
+#else
+    #define INLINE
+#endif
+
 
 #endif /* COMMON_UTIL_H */
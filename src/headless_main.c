@@ -0,0 +1,297 @@
+/**
+ * @file headless_main.c
+ *
+ * @brief Entry point to the headless build, runs the n-body gravity simulation
+ *        without a window or openGL context so it can run on batch nodes.
+ *
+ * Usage: particles_headless [name=value ...], see print_usage for the names
+ */
+
+#include    "sim.h"
+#include    "sim_setup.h"
+#include    <stdio.h>
+#include    "sim_force.h"
+#include    "sim_force_direct.h"
+#include    <stdlib.h>
+#include    <string.h>
+#include    <time.h>
+
+#define DEFAULT_PARTICLE_COUNT  1000
+#define DEFAULT_STEP_COUNT      100
+#define ERROR_SAMPLE_COUNT      1000
+#define KERNEL_AUTO             SIM_FORCE_DIRECT_KERNEL_COUNT   /* Fastest kernel the CPU supports */
+
+/* Indexed by sim_force_solver_t8 */
+static char const * const solver_names[SIM_FORCE_SOLVER_COUNT] =
+{
+    "direct",
+    "bh",
+    "fmm"
+};
+
+/* Indexed by sim_integrator_t8 */
+static char const * const integrator_names[SIM_INTEGRATOR_COUNT] =
+{
+    "euler",
+    "leapfrog",
+    "yoshida4",
+    "hermite4",
+    "block"
+};
+
+/* Indexed by sim_force_direct_kernel_t8 */
+static char const * const kernel_names[SIM_FORCE_DIRECT_KERNEL_COUNT] =
+{
+    "scalar",
+    "avx2",
+    "avx512"
+};
+
+/**
+ * @brief Find a name in a table
+ *
+ * @return The index of the name, or count if it isn't there
+ */
+static uint32_t find_name
+    (
+        char const * const    * names,
+        uint32_t                count,
+        char const            * name
+    )
+{
+    uint32_t i;
+
+    for( i = 0; i < count; ++i )
+    {
+        if( 0 == strcmp( names[i], name ) )
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+static void print_usage
+    (
+        void
+    )
+{
+    printf( "usage: particles_headless [name=value ...]\n" );
+    printf( "  particles=N       body count, default %d\n", DEFAULT_PARTICLE_COUNT );
+    printf( "  steps=N           step count, default %d\n", DEFAULT_STEP_COUNT );
+    printf( "  solver=NAME       direct, bh or fmm\n" );
+    printf( "  theta=X           tree opening angle\n" );
+    printf( "  order=N           FMM expansion order\n" );
+    printf( "  leaf=N            tree leaf capacity\n" );
+    printf( "  integrator=NAME   euler, leapfrog, yoshida4, hermite4 or block (block needs direct or bh)\n" );
+    printf( "  dt=X              time step, the longest block step for block\n" );
+    printf( "  levels=N          block step rungs, the shortest step is dt / 2^( N - 1 )\n" );
+    printf( "  eta=X             block step accuracy, dt = eta * sqrt( softening / |a| )\n" );
+    printf( "  softening=X       Plummer softening length\n" );
+    printf( "  threads=N         force workers, default one per core\n" );
+    printf( "  pin=0|1           pin force worker i to core i, default 0\n" );
+    printf( "  kernel=NAME       direct summation kernel, scalar, avx2 or avx512, default the fastest supported\n" );
+    printf( "  energy=N          report the energy drift every N steps, an O(N^2) pass, default off\n" );
+}
+
+int main
+    (
+        int     argc,
+        char ** argv
+    )
+{
+    sim_config_type               config;
+    sim_type                    * sim;
+    sim_vec3_type                 centre;
+    uint32_t                      particle_count;
+    uint32_t                      step_count;
+    uint32_t                      energy_interval;
+    uint32_t                      run_count;
+    uint32_t                      i;
+    double_t                      start_energy;
+    double_t                      energy;
+    clock_t                       start_clock;
+    time_t                        start_time;
+    double_t                      elapsed;
+    sim_force_error_type          force_error;
+    sim_force_direct_kernel_t8    kernel;
+    char                        * value;
+
+    particle_count  = DEFAULT_PARTICLE_COUNT;
+    step_count      = DEFAULT_STEP_COUNT;
+    kernel          = KERNEL_AUTO;
+    energy_interval = 0;
+
+    sim_config_default( &config );
+
+    /* Batch runs use every core unless told otherwise */
+    config.worker_count = THREAD_POOL_WORKERS_AUTO;
+
+    for( i = 1; i < (uint32_t)argc; ++i )
+    {
+        value = strchr( argv[i], '=' );
+        if( NULL == value )
+        {
+            print_usage();
+            return 1;
+        }
+
+        *value++ = '\0';
+
+        if( 0 == strcmp( argv[i], "particles" ) )
+        {
+            particle_count = (uint32_t)atoi( value );
+        }
+        else if( 0 == strcmp( argv[i], "steps" ) )
+        {
+            step_count = (uint32_t)atoi( value );
+        }
+        else if( 0 == strcmp( argv[i], "solver" ) )
+        {
+            config.force_solver = (sim_force_solver_t8)find_name( solver_names, SIM_FORCE_SOLVER_COUNT, value );
+        }
+        else if( 0 == strcmp( argv[i], "theta" ) )
+        {
+            config.opening_angle = (float_t)atof( value );
+        }
+        else if( 0 == strcmp( argv[i], "order" ) )
+        {
+            config.expansion_order = (uint8_t)atoi( value );
+        }
+        else if( 0 == strcmp( argv[i], "leaf" ) )
+        {
+            config.leaf_capacity = (uint32_t)atoi( value );
+        }
+        else if( 0 == strcmp( argv[i], "integrator" ) )
+        {
+            config.integrator = (sim_integrator_t8)find_name( integrator_names, SIM_INTEGRATOR_COUNT, value );
+        }
+        else if( 0 == strcmp( argv[i], "dt" ) )
+        {
+            config.time_step = (float_t)atof( value );
+        }
+        else if( 0 == strcmp( argv[i], "levels" ) )
+        {
+            config.block_levels = (uint8_t)atoi( value );
+        }
+        else if( 0 == strcmp( argv[i], "eta" ) )
+        {
+            config.time_step_accuracy = (float_t)atof( value );
+        }
+        else if( 0 == strcmp( argv[i], "softening" ) )
+        {
+            config.softening = (float_t)atof( value );
+        }
+        else if( 0 == strcmp( argv[i], "threads" ) )
+        {
+            config.worker_count = (uint32_t)atoi( value );
+        }
+        else if( 0 == strcmp( argv[i], "pin" ) )
+        {
+            config.pin_workers = ( 0 != atoi( value ) );
+        }
+        else if( 0 == strcmp( argv[i], "energy" ) )
+        {
+            energy_interval = (uint32_t)atoi( value );
+        }
+        else if( 0 == strcmp( argv[i], "kernel" ) )
+        {
+            kernel = (sim_force_direct_kernel_t8)find_name( kernel_names, SIM_FORCE_DIRECT_KERNEL_COUNT, value );
+            if( kernel >= SIM_FORCE_DIRECT_KERNEL_COUNT )
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else
+        {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if( ( config.force_solver >= SIM_FORCE_SOLVER_COUNT ) || ( config.integrator >= SIM_INTEGRATOR_COUNT ) )
+    {
+        print_usage();
+        return 1;
+    }
+
+    if( ( SIM_INTEGRATOR_BLOCK_LEAPFROG == config.integrator ) && !sim_force_supports_block_steps( config.force_solver ) )
+    {
+        printf( "integrator=block needs a solver that can compute the active bodies alone, direct or bh\n" );
+        return 1;
+    }
+
+    if( ( KERNEL_AUTO != kernel ) && !sim_force_direct_set_kernel( kernel ) )
+    {
+        printf( "kernel=%s isn't supported by this build or CPU\n", kernel_names[kernel] );
+        return 1;
+    }
+
+    sim = sim_create( &config );
+
+    centre.x = 0.0f;
+    centre.y = 0.0f;
+    centre.z = 0.0f;
+    sim_setup_uniform_sphere( sim, particle_count, &centre, 1.0f, 1.0f, 1 );
+
+    printf( "particles: %d steps: %d solver: %s integrator: %s dt: %g\n", particle_count, step_count,
+            solver_names[config.force_solver], integrator_names[config.integrator], config.time_step );
+    printf( "direct kernel: %s workers: %d\n",
+            sim_force_direct_kernel_name( sim_force_direct_get_kernel() ), thread_pool_worker_count( sim->pool ) );
+
+    /* The energy is an O(N^2) pass, so it is only computed when asked for */
+    start_energy = 0.0;
+    if( 0 != energy_interval )
+    {
+        start_energy = sim_total_energy( sim );
+        printf( "E0: %.9g\n", start_energy );
+    }
+
+    sim_force_measure_error( sim, ERROR_SAMPLE_COUNT, &force_error );
+    printf( "force error vs direct: rms %.3e max %.3e over %d bodies\n",
+            force_error.rms_relative_error, force_error.max_relative_error, force_error.sample_count );
+
+    elapsed = 0.0;
+    start_time = time( NULL );
+
+    for( i = 0; i < step_count; i += run_count )
+    {
+        run_count = step_count - i;
+        if( ( 0 != energy_interval ) && ( energy_interval < run_count ) )
+        {
+            run_count = energy_interval;
+        }
+
+        /* Only time the stepping, the energy check is diagnostics */
+        start_clock = clock();
+        sim_run( sim, run_count );
+        elapsed += (double_t)( clock() - start_clock ) / CLOCKS_PER_SEC;
+
+        if( 0 == energy_interval )
+        {
+            continue;
+        }
+
+        energy = sim_total_energy( sim );
+
+        /* No pairs, e.g. one body, means E0 is zero and only the absolute drift means anything */
+        if( 0.0 == start_energy )
+        {
+            printf( "t: %.5f dE: %.3e\n", sim_get_time( sim ), energy - start_energy );
+        }
+        else
+        {
+            printf( "t: %.5f dE/E0: %.3e\n", sim_get_time( sim ), ( energy - start_energy ) / start_energy );
+        }
+    }
+
+    /* clock() adds up every worker's time, wall time is only to the second in C89 */
+    printf( "cpu: %.3fs steps per cpu s: %.1f wall: %.0fs\n", elapsed, ( elapsed > 0.0 ) ? step_count / elapsed : 0.0,
+            difftime( time( NULL ), start_time ) );
+
+    sim_free( sim );
+
+    return 0;
+}
@@ -3,21 +3,56 @@
 *
 * @brief Entry point to the particles program, this program runs an n-body gravity simulation
 *
+* Usage: particles [output_pattern frame_count]
+*        With no arguments the app runs in a window, otherwise frame_count
+*        frames are rendered offscreen into files named by output_pattern
+*        (e.g. frames/%05u.ppm). An output_pattern starting with | is a
+*        command to pipe raw rgb24 frames to instead, e.g. an ffmpeg encoder
+*
 * @author Patrick Settle (https://github.com/psettle)
 */
 
 #include    "system.h"
 #include    "bouncy_sphere.h"
 #include    "model_loader.h"
+#include    <stdlib.h>
+
+#define OFFSCREEN_WIDTH         1920
+#define OFFSCREEN_HEIGHT        1080
+#define OFFSCREEN_FRAME_TIME    ( 1.0 / 30.0 )  /* s, 30 fps playback */
 
-int main()
+int main
+    (
+        int     argc,
+        char ** argv
+    )
 {
-    if( system_init() )
+    system_offscreen_config_type    offscreen_config;
+    boolean                         status;
+
+    if( 3 == argc )
+    {
+        offscreen_config.width              = OFFSCREEN_WIDTH;
+        offscreen_config.height             = OFFSCREEN_HEIGHT;
+        offscreen_config.output_pattern     = argv[1];
+        offscreen_config.encoder_command    = ( '|' == argv[1][0] ) ? &argv[1][1] : NULL;
+        offscreen_config.frame_count        = (uint32_t)atoi( argv[2] );
+        offscreen_config.frame_time         = OFFSCREEN_FRAME_TIME;
+
+        status = system_init_offscreen( &offscreen_config );
+    }
+    else
+    {
+        status = system_init();
+    }
+
+    if( status )
     {
         /* texture_cube_start(); */
+        /* nbody_start(); */
         bouncy_sphere_start();
         system_run();
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -158,6 +158,76 @@ GLfloat vec4_dot
     return sum;
 }
 
+void quat_set
+    (
+        quat_type * quat,
+        GLfloat     x,
+        GLfloat     y,
+        GLfloat     z,
+        GLfloat     w
+    )
+{
+    quat->x = x;
+    quat->y = y;
+    quat->z = z;
+    quat->w = w;
+}
+
+void quat_from_axis_angle
+    (
+        quat_type       * quat,
+        vec3_type const * axis,
+        GLfloat           angle_rad
+    )
+{
+    vec3_type unit_axis;
+    GLfloat   sin_half;
+
+    unit_axis = *axis;
+    vec3_normalize( &unit_axis );
+    sin_half = sin( angle_rad / 2.0f );
+
+    quat->x = unit_axis.x * sin_half;
+    quat->y = unit_axis.y * sin_half;
+    quat->z = unit_axis.z * sin_half;
+    quat->w = cos( angle_rad / 2.0f );
+}
+
+void quat_multiply
+    (
+        quat_type*        product,
+        quat_type const * left,
+        quat_type const * right
+    )
+{
+    quat_type l;
+    quat_type r;
+
+    /* Make copies incase left == product || right == product */
+    l = *left;
+    r = *right;
+
+    product->x = l.w * r.x + l.x * r.w + l.y * r.z - l.z * r.y;
+    product->y = l.w * r.y - l.x * r.z + l.y * r.w + l.z * r.x;
+    product->z = l.w * r.z + l.x * r.y - l.y * r.x + l.z * r.w;
+    product->w = l.w * r.w - l.x * r.x - l.y * r.y - l.z * r.z;
+}
+
+void quat_normalize
+    (
+        quat_type * quat
+    )
+{
+    GLfloat length;
+
+    length = sqrt( quat->x * quat->x + quat->y * quat->y + quat->z * quat->z + quat->w * quat->w );
+
+    quat->x = quat->x / length;
+    quat->y = quat->y / length;
+    quat->z = quat->z / length;
+    quat->w = quat->w / length;
+}
+
 void mat4_set
     (
         mat4_type * mat4,
@@ -406,4 +476,54 @@ void mat4_translate
         &translation_matrix,
         to_translate
         );
-}
\ No newline at end of file
+}
+
+void mat4_from_transform
+    (
+        mat4_type       * model,
+        vec3_type const * position,
+        quat_type const * rotation,
+        GLfloat           scale
+    )
+{
+    GLfloat xx;
+    GLfloat yy;
+    GLfloat zz;
+    GLfloat xy;
+    GLfloat xz;
+    GLfloat yz;
+    GLfloat wx;
+    GLfloat wy;
+    GLfloat wz;
+
+    xx = rotation->x * rotation->x;
+    yy = rotation->y * rotation->y;
+    zz = rotation->z * rotation->z;
+    xy = rotation->x * rotation->y;
+    xz = rotation->x * rotation->z;
+    yz = rotation->y * rotation->z;
+    wx = rotation->w * rotation->x;
+    wy = rotation->w * rotation->y;
+    wz = rotation->w * rotation->z;
+
+    /* Rotation matrix columns times the scale, then the translation column */
+    model->x.x = ( 1.0f - 2.0f * ( yy + zz ) ) * scale;
+    model->x.y = ( 2.0f * ( xy + wz ) ) * scale;
+    model->x.z = ( 2.0f * ( xz - wy ) ) * scale;
+    model->x.w = 0.0f;
+
+    model->y.x = ( 2.0f * ( xy - wz ) ) * scale;
+    model->y.y = ( 1.0f - 2.0f * ( xx + zz ) ) * scale;
+    model->y.z = ( 2.0f * ( yz + wx ) ) * scale;
+    model->y.w = 0.0f;
+
+    model->z.x = ( 2.0f * ( xz + wy ) ) * scale;
+    model->z.y = ( 2.0f * ( yz - wx ) ) * scale;
+    model->z.z = ( 1.0f - 2.0f * ( xx + yy ) ) * scale;
+    model->z.w = 0.0f;
+
+    model->w.x = position->x;
+    model->w.y = position->y;
+    model->w.z = position->z;
+    model->w.w = 1.0f;
+}
@@ -24,6 +24,8 @@
 #define VEC4_NULL VEC3_NULL, 0.0
 #define MAT4_NULL VEC4_NULL, VEC4_NULL, VEC4_NULL, VEC4_NULL
 
+#define QUAT_IDENTITY 0.0f, 0.0f, 0.0f, 1.0f
+
 #define MAT4_IDENTITY 1.0f, 0.0f, 0.0f, 0.0f,\
                       0.0f, 1.0f, 0.0f, 0.0f,\
                       0.0f, 0.0f, 1.0f, 0.0f,\
@@ -58,6 +60,17 @@ typedef struct vec4_struct
     GLfloat w;
 } vec4_type;
 
+/**
+ * @brief A rotation, w is the scalar part
+ */
+typedef struct quat_struct
+{
+    GLfloat x;
+    GLfloat y;
+    GLfloat z;
+    GLfloat w;
+} quat_type;
+
 /**
  * @brief
  */
@@ -184,6 +197,46 @@ GLfloat vec4_dot
         vec4_type const * right
     );
 
+/**
+ * @brief Set a quat
+ */
+void quat_set
+    (
+        quat_type * quat,
+        GLfloat     x,
+        GLfloat     y,
+        GLfloat     z,
+        GLfloat     w
+    );
+
+/**
+ * @brief Set a quat to a rotation of angle around axis
+ */
+void quat_from_axis_angle
+    (
+        quat_type       * quat,
+        vec3_type const * axis,
+        GLfloat           angle_rad
+    );
+
+/**
+ * @brief product = left * right, the rotation right then left
+ */
+void quat_multiply
+    (
+        quat_type*        product,
+        quat_type const * left,
+        quat_type const * right
+    );
+
+/**
+ * @brief Scale a quat back to unit length, rounding drifts it over many multiplies
+ */
+void quat_normalize
+    (
+        quat_type * quat
+    );
+
 /**
  * @brief Set a mat4
  */
@@ -257,4 +310,16 @@ void mat4_translate
         vec3_type const * amount
     );
 
+/**
+ * @brief Sets a model matrix that scales, then rotates, then translates,
+ *        built directly from the components without multiplying matrices
+ */
+void mat4_from_transform
+    (
+        mat4_type       * model,
+        vec3_type const * position,
+        quat_type const * rotation, /* Unit length */
+        GLfloat           scale
+    );
+
 #endif /* MATRIX_MATH_H */
@@ -0,0 +1,200 @@
+/**
+ * @file arena.c
+ *
+ * @brief Implementation of the bump pointer allocator
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "arena.h"
+#include "common_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                                MACROS
+**********************************************************************/
+
+#define align_up( size ) ( ( ( size ) + ARENA_ALIGNMENT - 1 ) & ~(size_t)( ARENA_ALIGNMENT - 1 ) )
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocates a block with room for size bytes
+ */
+static arena_block_type * block_create
+    (
+        size_t size
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+arena_type * arena_create
+    (
+        size_t block_size
+    )
+{
+    arena_type * arena;
+
+    arena = (arena_type *)calloc( 1, sizeof( arena_type ) );
+
+    arena->block_size   = align_up( block_size );
+    arena->first        = block_create( arena->block_size );
+    arena->current      = arena->first;
+
+    return arena;
+}
+
+void arena_free
+    (
+        arena_type * arena
+    )
+{
+    arena_block_type * block;
+    arena_block_type * next;
+
+    for( block = arena->first; NULL != block; block = next )
+    {
+        next = block->next;
+        free( block );
+    }
+
+    free( arena );
+}
+
+void * arena_alloc
+    (
+        arena_type    * arena,
+        size_t          size
+    )
+{
+    arena_block_type  * block;
+    void              * memory;
+
+    size = align_up( size );
+    block = arena->current;
+
+    if( size > block->size - block->used )
+    {
+        /* Move on to the next free block, or put a new one in front of it if it's too small */
+        if( ( NULL == block->next ) || ( size > block->next->size ) )
+        {
+            block = block_create( MAX( size, arena->block_size ) );
+            block->next = arena->current->next;
+            arena->current->next = block;
+        }
+        else
+        {
+            block = block->next;
+        }
+
+        block->used = 0;
+        arena->current = block;
+    }
+
+    memory = &block->data[block->used];
+    block->used += size;
+    arena->last_allocation = memory;
+
+    return memory;
+}
+
+void * arena_realloc
+    (
+        arena_type    * arena,
+        void          * memory,
+        size_t          old_size,
+        size_t          new_size
+    )
+{
+    arena_block_type  * block;
+    void              * new_memory;
+    size_t              start;
+
+    if( NULL == memory )
+    {
+        return arena_alloc( arena, new_size );
+    }
+
+    /* The latest allocation sits at the end of the current block, it can just take more of the block */
+    block = arena->current;
+    if( memory == arena->last_allocation )
+    {
+        start = (uint8_t *)memory - block->data;
+        if( align_up( new_size ) <= block->size - start )
+        {
+            block->used = start + align_up( new_size );
+            return memory;
+        }
+    }
+
+    if( new_size <= old_size )
+    {
+        return memory;
+    }
+
+    new_memory = arena_alloc( arena, new_size );
+    memcpy( new_memory, memory, old_size );
+
+    return new_memory;
+}
+
+arena_mark_type arena_mark
+    (
+        arena_type const * arena
+    )
+{
+    arena_mark_type mark;
+
+    mark.block  = arena->current;
+    mark.used   = arena->current->used;
+
+    return mark;
+}
+
+void arena_reset_to_mark
+    (
+        arena_type            * arena,
+        arena_mark_type const * mark
+    )
+{
+    /* Blocks after the mark's stay linked after it, so they are reused */
+    arena->current          = mark->block;
+    arena->current->used    = mark->used;
+    arena->last_allocation  = NULL;
+}
+
+void arena_reset
+    (
+        arena_type * arena
+    )
+{
+    arena->current          = arena->first;
+    arena->current->used    = 0;
+    arena->last_allocation  = NULL;
+}
+
+static arena_block_type * block_create
+    (
+        size_t size
+    )
+{
+    arena_block_type * block;
+
+    /* Over allocate so the data can start on an aligned address after the header */
+    block = (arena_block_type *)malloc( sizeof( arena_block_type ) + ARENA_ALIGNMENT + size );
+
+    block->next = NULL;
+    block->data = (uint8_t *)( block + 1 );
+    block->data += ( ARENA_ALIGNMENT - ( (size_t)block->data % ARENA_ALIGNMENT ) ) % ARENA_ALIGNMENT;
+    block->size = size;
+    block->used = 0;
+
+    return block;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file arena.h
+ *
+ * @brief Bump pointer allocator for short lived memory
+ *
+ * Allocations are carved off the end of large blocks and are never freed
+ * one at a time, the whole arena (or everything since a mark) is released
+ * at once. Blocks are kept for reuse after a reset, so an arena that is
+ * reset every frame or every load stops calling malloc once it has grown
+ * to its working size.
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+#include <stddef.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define ARENA_ALIGNMENT     ( 16 )  /* Of every allocation, enough for any scalar and SSE vectors */
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/* Block of arena memory, the allocations follow the header */
+typedef struct arena_block_struct
+{
+    struct arena_block_struct * next;       /* Blocks after this one, unused until the arena moves on to them */
+    uint8_t                   * data;       /* ARENA_ALIGNMENT aligned */
+    size_t                      size;       /* Bytes at data */
+    size_t                      used;       /* Bytes at data handed out */
+} arena_block_type;
+
+/* Arena type, should only be accessed with interface functions below */
+typedef struct arena_struct
+{
+    arena_block_type  * first;
+    arena_block_type  * current;            /* Allocations come from here, blocks past it are free */
+    void              * last_allocation;    /* Can be grown in place by arena_realloc */
+    size_t              block_size;
+} arena_type;
+
+/* Position in an arena to reset back to, @see arena_mark */
+typedef struct arena_mark_struct
+{
+    arena_block_type  * block;
+    size_t              used;
+} arena_mark_type;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocates and returns a new arena
+ */
+arena_type * arena_create
+    (
+        size_t block_size   /* Bytes, larger allocations get a block of their own */
+    );
+
+/**
+ * @brief Deletes an arena and every allocation made from it
+ */
+void arena_free
+    (
+        arena_type * arena
+    );
+
+/**
+ * @brief Allocates uninitialized memory that lives until the arena is reset
+ */
+void * arena_alloc
+    (
+        arena_type    * arena,
+        size_t          size
+    );
+
+/**
+ * @brief Resizes an allocation, in place if it is the arena's latest one
+ *        and the block has room, otherwise by copying into a new allocation
+ *
+ * @return The resized allocation
+ */
+void * arena_realloc
+    (
+        arena_type    * arena,
+        void          * memory,     /* NULL to allocate */
+        size_t          old_size,
+        size_t          new_size
+    );
+
+/**
+ * @brief Records the current position of the arena
+ */
+arena_mark_type arena_mark
+    (
+        arena_type const * arena
+    );
+
+/**
+ * @brief Releases everything allocated since mark was taken
+ */
+void arena_reset_to_mark
+    (
+        arena_type            * arena,
+        arena_mark_type const * mark
+    );
+
+/**
+ * @brief Releases everything allocated from the arena, keeping its blocks
+ */
+void arena_reset
+    (
+        arena_type * arena
+    );
+
+#endif /* ARENA_H */
@@ -9,12 +9,21 @@
 **********************************************************************/
 
 #include "shader.h"
+#include "uniform_block.h"
 #include "file_api.h"
 #include "opengl_includes.h"
 #include "common_util.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define FNV_OFFSET_BASIS    ( 2166136261UL )
+#define FNV_PRIME           ( 16777619UL )
 
 /**********************************************************************
                                   TYPES
@@ -60,6 +69,51 @@ static boolean shader_link
         GLuint* program_handle
     );
 
+/**
+ * @brief Fill in the uniform location table with every active uniform
+ *        of the linked program
+ */
+static void build_uniform_table
+    (
+        shader_type * shader
+    );
+
+/**
+ * @brief Bind every shared uniform block the program declares to its
+ *        binding point (@see uniform_block.h)
+ */
+static void bind_uniform_blocks
+    (
+        shader_type * shader
+    );
+
+/**
+ * @brief Add one uniform to the location table
+ */
+static void add_uniform
+    (
+        shader_type   * shader,
+        sint8_t const * uniform_name
+    );
+
+/**
+ * @brief Find the table slot of a uniform name, or the empty slot it would go in
+ */
+static shader_uniform_entry_type * find_uniform
+    (
+        shader_type const * shader,
+        sint8_t     const * uniform_name,
+        uint32_t            hash
+    );
+
+/**
+ * @brief FNV-1a hash of a uniform name
+ */
+static uint32_t hash_name
+    (
+        sint8_t const * name
+    );
+
 /**
  * @brief Retrieves and prints the shader compile log
  */
@@ -117,6 +171,9 @@ shader_type* shader_build
         return NULL;
     }
 
+    build_uniform_table( shader );
+    bind_uniform_blocks( shader );
+
     return shader;
 }
 
@@ -142,10 +199,36 @@ void shader_free
         shader_type* shader
     )
 {
+    uint32_t i;
+
+    for( i = 0; i < shader->uniform_table_size; ++i )
+    {
+        free( shader->uniform_table[i].name );
+    }
+
+    free( shader->uniform_table );
     glDeleteProgram( shader->program_id );
     free( shader );
 }
 
+shader_uniform_type shader_get_uniform
+    (
+        shader_type const * shader,
+        sint8_t     const * uniform_name
+    )
+{
+    shader_uniform_entry_type * entry;
+
+    if( 0 == shader->uniform_table_size )
+    {
+        return SHADER_UNIFORM_NONE;
+    }
+
+    entry = find_uniform( shader, uniform_name, hash_name( uniform_name ) );
+
+    return ( NULL != entry->name ) ? entry->location : SHADER_UNIFORM_NONE;
+}
+
 void shader_set_uniform_mat4
     (
         shader_type const * shader,
@@ -153,10 +236,7 @@ void shader_set_uniform_mat4
         mat4_type   const * mat4
     )
 {
-    GLuint uniform_location;
-
-    uniform_location = glGetUniformLocation( shader->program_id, uniform_name );
-    glUniformMatrix4fv( uniform_location, 1, GL_FALSE, &mat4->x.x );
+    shader_set_uniform_mat4_handle( shader_get_uniform( shader, uniform_name ), mat4 );
 }
 
 void shader_set_uniform_vec3
@@ -166,10 +246,7 @@ void shader_set_uniform_vec3
         vec3_type   const * vec3
     )
 {
-    GLuint uniform_location;
-    
-    uniform_location = glGetUniformLocation( shader->program_id, uniform_name );
-    glUniform3f( uniform_location, vec3->x, vec3->y, vec3->z );
+    shader_set_uniform_vec3_handle( shader_get_uniform( shader, uniform_name ), vec3 );
 }
 
 void shader_set_uniform_float
@@ -179,10 +256,7 @@ void shader_set_uniform_float
         GLfloat             fl
     )
 {
-    GLuint uniform_location;
-
-    uniform_location = glGetUniformLocation( shader->program_id, uniform_name );
-    glUniform1f( uniform_location, fl );
+    shader_set_uniform_float_handle( shader_get_uniform( shader, uniform_name ), fl );
 }
 
 void shader_set_uniform_uint32
@@ -192,10 +266,43 @@ void shader_set_uniform_uint32
         uint32_t            uint32
     )
 {
-    GLuint uniform_location;
+    shader_set_uniform_uint32_handle( shader_get_uniform( shader, uniform_name ), uint32 );
+}
+
+void shader_set_uniform_mat4_handle
+    (
+        shader_uniform_type     uniform,
+        mat4_type       const * mat4
+    )
+{
+    glUniformMatrix4fv( uniform, 1, GL_FALSE, &mat4->x.x );
+}
+
+void shader_set_uniform_vec3_handle
+    (
+        shader_uniform_type     uniform,
+        vec3_type       const * vec3
+    )
+{
+    glUniform3f( uniform, vec3->x, vec3->y, vec3->z );
+}
 
-    uniform_location = glGetUniformLocation( shader->program_id, uniform_name );
-    glUniform1i( uniform_location, uint32 );
+void shader_set_uniform_float_handle
+    (
+        shader_uniform_type     uniform,
+        GLfloat                 fl
+    )
+{
+    glUniform1f( uniform, fl );
+}
+
+void shader_set_uniform_uint32_handle
+    (
+        shader_uniform_type     uniform,
+        uint32_t                uint32
+    )
+{
+    glUniform1i( uniform, uint32 );
 }
 
 static boolean shader_compile
@@ -276,6 +383,173 @@ static boolean shader_link
 #endif
 }
 
+static void build_uniform_table
+    (
+        shader_type * shader
+    )
+{
+    GLint       uniform_count;
+    GLint       max_name_length;
+    GLint       i;
+    GLint       j;
+    GLint       array_size;
+    GLenum      uniform_type;
+    sint8_t   * name;
+    sint8_t   * element_name;
+    sint8_t   * bracket;
+
+    glGetProgramiv( shader->program_id, GL_ACTIVE_UNIFORMS, &uniform_count );
+    glGetProgramiv( shader->program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length );
+
+    if( 0 == uniform_count )
+    {
+        return;
+    }
+
+    /* Arrays add an entry per element and one for the bare name, keep the table at most half full */
+    shader->uniform_table_size = 1;
+    while( shader->uniform_table_size < 2 * (uint32_t)uniform_count )
+    {
+        shader->uniform_table_size *= 2;
+    }
+
+    shader->uniform_table = calloc( shader->uniform_table_size, sizeof( shader_uniform_entry_type ) );
+
+    /* Room for an element index appended to the longest name */
+    name            = malloc( max_name_length + 1 );
+    element_name    = malloc( max_name_length + 16 );
+
+    for( i = 0; i < uniform_count; ++i )
+    {
+        glGetActiveUniform( shader->program_id, i, max_name_length + 1, NULL, &array_size, &uniform_type, name );
+
+        add_uniform( shader, name );
+
+        /* Arrays are listed once as "name[0]", the bare name and the other elements can be set too */
+        bracket = strstr( name, "[0]" );
+        if( ( NULL != bracket ) && ( '\0' == bracket[3] ) )
+        {
+            *bracket = '\0';
+            add_uniform( shader, name );
+
+            for( j = 1; j < array_size; ++j )
+            {
+                sprintf( element_name, "%s[%d]", name, j );
+                add_uniform( shader, element_name );
+            }
+        }
+    }
+
+    free( name );
+    free( element_name );
+}
+
+static void bind_uniform_blocks
+    (
+        shader_type * shader
+    )
+{
+    GLuint                      block_index;
+    uniform_block_binding_t8    binding;
+
+    /* glsl 330 can't give a block its binding in the shader */
+    for( binding = 0; binding < UNIFORM_BLOCK_BINDING_COUNT; ++binding )
+    {
+        block_index = glGetUniformBlockIndex( shader->program_id, uniform_block_name( binding ) );
+        if( GL_INVALID_INDEX != block_index )
+        {
+            glUniformBlockBinding( shader->program_id, block_index, binding );
+        }
+    }
+}
+
+static void add_uniform
+    (
+        shader_type   * shader,
+        sint8_t const * uniform_name
+    )
+{
+    shader_uniform_entry_type     * entry;
+    shader_uniform_entry_type     * old_table;
+    uint32_t                        old_size;
+    uint32_t                        hash;
+    uint32_t                        i;
+
+    /* Grow when more than half full, only large arrays take it there */
+    if( 2 * ( shader->uniform_count + 1 ) > shader->uniform_table_size )
+    {
+        old_table = shader->uniform_table;
+        old_size  = shader->uniform_table_size;
+
+        shader->uniform_table_size *= 2;
+        shader->uniform_table = calloc( shader->uniform_table_size, sizeof( shader_uniform_entry_type ) );
+
+        for( i = 0; i < old_size; ++i )
+        {
+            if( NULL != old_table[i].name )
+            {
+                *find_uniform( shader, old_table[i].name, old_table[i].hash ) = old_table[i];
+            }
+        }
+
+        free( old_table );
+    }
+
+    hash  = hash_name( uniform_name );
+    entry = find_uniform( shader, uniform_name, hash );
+    if( NULL != entry->name )
+    {
+        return;
+    }
+
+    entry->name     = malloc( strlen( uniform_name ) + 1 );
+    entry->hash     = hash;
+    entry->location = glGetUniformLocation( shader->program_id, uniform_name );
+    strcpy( entry->name, uniform_name );
+
+    shader->uniform_count += 1;
+}
+
+static shader_uniform_entry_type * find_uniform
+    (
+        shader_type const * shader,
+        sint8_t     const * uniform_name,
+        uint32_t            hash
+    )
+{
+    shader_uniform_entry_type * entry;
+    uint32_t                    mask;
+    uint32_t                    i;
+
+    mask = shader->uniform_table_size - 1;
+
+    /* Linear probing, the table always has empty slots to stop on */
+    for( i = hash & mask; ; i = ( i + 1 ) & mask )
+    {
+        entry = &shader->uniform_table[i];
+        if( ( NULL == entry->name ) || ( ( entry->hash == hash ) && ( 0 == strcmp( entry->name, uniform_name ) ) ) )
+        {
+            return entry;
+        }
+    }
+}
+
+static uint32_t hash_name
+    (
+        sint8_t const * name
+    )
+{
+    uint32_t hash;
+
+    hash = FNV_OFFSET_BASIS;
+    while( '\0' != *name )
+    {
+        hash = ( hash ^ (uint8_t)*name++ ) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
 static void print_shader_error_log
     (
         GLuint shader_handle
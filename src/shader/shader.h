@@ -19,15 +19,30 @@
 **********************************************************************/
 
 #define SHADER_PRINT_ERROR_LOG  TRUE
+#define SHADER_UNIFORM_NONE     ( -1 )  /* Handle of a uniform the shader doesn't have, setting it does nothing */
 
 /**********************************************************************
                                  TYPES
 **********************************************************************/
 
+/* Pre-resolved location of a uniform, @see shader_get_uniform */
+typedef GLint shader_uniform_type;
+
+/* One active uniform in a shader's location table */
+typedef struct shader_uniform_entry_struct
+{
+    sint8_t               * name;       /* NULL for an empty slot */
+    uint32_t                hash;
+    shader_uniform_type     location;
+} shader_uniform_entry_type;
+
 /* Data to describe one shader */
 typedef struct shader_struct
 {
-    GLuint program_id;
+    GLuint                      program_id;
+    uint32_t                    uniform_count;
+    uint32_t                    uniform_table_size; /* Power of two, open addressed */
+    shader_uniform_entry_type * uniform_table;      /* Every active uniform, filled in at link time */
 } shader_type;
 
 /**********************************************************************
@@ -71,6 +86,19 @@ void shader_free
         shader_type* shader
     );
 
+/**
+ * @brief Look up the location of a uniform once, to set it every frame
+ *        without finding it by name
+ *
+ * @return The uniform handle, SHADER_UNIFORM_NONE if the shader doesn't
+ *         have an active uniform of that name
+ */
+shader_uniform_type shader_get_uniform
+    (
+        shader_type const * shader,
+        sint8_t     const * uniform_name
+    );
+
 /**
  * @brief Set the value of an mat4 uniform
  */
@@ -111,4 +139,40 @@ void shader_set_uniform_uint32
         uint32_t            uint32
     );
 
+/**
+ * @brief Set the value of an mat4 uniform of the shader in use
+ */
+void shader_set_uniform_mat4_handle
+    (
+        shader_uniform_type     uniform,
+        mat4_type       const * mat4
+    );
+
+/**
+ * @brief Set the value of an vec3 uniform of the shader in use
+ */
+void shader_set_uniform_vec3_handle
+    (
+        shader_uniform_type     uniform,
+        vec3_type       const * vec3
+    );
+
+/**
+ * @brief Set the value of an float uniform of the shader in use
+ */
+void shader_set_uniform_float_handle
+    (
+        shader_uniform_type     uniform,
+        GLfloat                 fl
+    );
+
+/**
+ * @brief Set the value of an int uniform of the shader in use
+ */
+void shader_set_uniform_uint32_handle
+    (
+        shader_uniform_type     uniform,
+        uint32_t                uint32
+    );
+
 #endif /* SHADER_H */
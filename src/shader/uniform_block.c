@@ -0,0 +1,102 @@
+/**
+ * @file uniform_block.c
+ *
+ * @brief Implementation of the shared uniform buffer objects
+ */
+
+/**********************************************************************
+                                INCLUDES
+**********************************************************************/
+
+#include "uniform_block.h"
+#include "common_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                                  TYPES
+**********************************************************************/
+
+struct uniform_block_struct
+{
+    GLuint      buffer_object;
+    uint32_t    size;
+    uint8_t   * data;       /* Last uploaded contents */
+};
+
+/**********************************************************************
+                                VARIABLES
+**********************************************************************/
+
+/* Indexed by uniform_block_binding_t8 */
+static sint8_t const * const block_names[UNIFORM_BLOCK_BINDING_COUNT] =
+{
+    "camera_block",
+    "light_block",
+    "material_block"
+};
+
+/**********************************************************************
+                                FUNCTIONS
+**********************************************************************/
+
+uniform_block_type * uniform_block_create
+    (
+        uniform_block_binding_t8    binding,
+        uint32_t                    size
+    )
+{
+    uniform_block_type * block;
+
+    ASSERT( binding < UNIFORM_BLOCK_BINDING_COUNT );
+
+    block = calloc( 1, sizeof( uniform_block_type ) );
+
+    block->size = size;
+    block->data = calloc( 1, size );
+
+    glGenBuffers( 1, &block->buffer_object );
+    glBindBuffer( GL_UNIFORM_BUFFER, block->buffer_object );
+    glBufferData( GL_UNIFORM_BUFFER, size, block->data, GL_DYNAMIC_DRAW );
+    glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+
+    glBindBufferBase( GL_UNIFORM_BUFFER, binding, block->buffer_object );
+
+    return block;
+}
+
+void uniform_block_free
+    (
+        uniform_block_type * block
+    )
+{
+    glDeleteBuffers( 1, &block->buffer_object );
+    free( block->data );
+    free( block );
+}
+
+void uniform_block_update
+    (
+        uniform_block_type    * block,
+        void            const * data
+    )
+{
+    if( 0 == memcmp( block->data, data, block->size ) )
+    {
+        return;
+    }
+
+    memcpy( block->data, data, block->size );
+
+    glBindBuffer( GL_UNIFORM_BUFFER, block->buffer_object );
+    glBufferSubData( GL_UNIFORM_BUFFER, 0, block->size, block->data );
+    glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+}
+
+sint8_t const * uniform_block_name
+    (
+        uniform_block_binding_t8 binding
+    )
+{
+    return block_names[binding];
+}
@@ -0,0 +1,77 @@
+/**
+ * @file uniform_block.h
+ *
+ * @brief Uniform buffer objects shared by every shader
+ *
+ * Each block has a fixed binding point, shader_build binds any block of
+ * a matching name in a program to it. A block keeps a copy of what was
+ * last uploaded, so writing unchanged data costs no openGL traffic.
+ */
+#ifndef UNIFORM_BLOCK_H
+#define UNIFORM_BLOCK_H
+
+/**********************************************************************
+                                INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+#include "opengl_includes.h"
+
+/**********************************************************************
+                                 TYPES
+**********************************************************************/
+
+/* Binding points, the name of each block in glsl is given by uniform_block_name */
+typedef uint8_t uniform_block_binding_t8; enum
+{
+    UNIFORM_BLOCK_BINDING_CAMERA,
+    UNIFORM_BLOCK_BINDING_LIGHT,
+    UNIFORM_BLOCK_BINDING_MATERIAL,
+
+    UNIFORM_BLOCK_BINDING_COUNT
+};
+
+/* Should only be accessed with interface functions below */
+typedef struct uniform_block_struct uniform_block_type;
+
+/**********************************************************************
+                                PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Create a block and bind it to its binding point, needs a
+ *        current openGL context
+ */
+uniform_block_type * uniform_block_create
+    (
+        uniform_block_binding_t8    binding,
+        uint32_t                    size    /* Size of the std140 layout in bytes */
+    );
+
+/**
+ * @brief Delete a block
+ */
+void uniform_block_free
+    (
+        uniform_block_type * block
+    );
+
+/**
+ * @brief Write the whole block, only uploaded if it differs from the
+ *        last write
+ */
+void uniform_block_update
+    (
+        uniform_block_type    * block,
+        void            const * data    /* std140 layout, size given at create */
+    );
+
+/**
+ * @brief Get the glsl name of the block at a binding point
+ */
+sint8_t const * uniform_block_name
+    (
+        uniform_block_binding_t8 binding
+    );
+
+#endif /* UNIFORM_BLOCK_H */
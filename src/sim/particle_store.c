@@ -0,0 +1,324 @@
+/**
+ * @file particle_store.c
+ *
+ * @brief Implementation of the structure-of-arrays particle storage
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "particle_store.h"
+#include "common_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define PARTICLE_STORE_DEFAULT_CAPACITY     ( 1024 )
+#define PARTICLE_STORE_GROWTH_FACTOR        ( 2 )
+#define PARTICLE_STORE_ATTRIBUTE_COUNT      ( 10 )
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Collect pointers to every float attribute array of the store
+ */
+static void get_attributes
+    (
+        particle_store_type * store,
+        float_t            ** attributes[PARTICLE_STORE_ATTRIBUTE_COUNT] /* [out] */
+    );
+
+/**
+ * @brief Reallocate every array to hold capacity bodies
+ */
+static void resize
+    (
+        particle_store_type * store,
+        uint32_t              capacity
+    );
+
+/**
+ * @brief Allocate zero filled memory aligned to PARTICLE_STORE_ALIGNMENT
+ */
+static void * aligned_calloc
+    (
+        uint32_t size
+    );
+
+/**
+ * @brief Free memory from aligned_calloc
+ */
+static void aligned_free
+    (
+        void * memory
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+particle_store_type * particle_store_create
+    (
+        uint32_t initial_capacity
+    )
+{
+    particle_store_type * store;
+
+    store = calloc( 1, sizeof( particle_store_type ) );
+
+    store->handle_to_index  = vector_init( sizeof( uint32_t ) );
+    store->free_handles     = vector_init( sizeof( particle_handle_type ) );
+
+    if( 0 == initial_capacity )
+    {
+        initial_capacity = PARTICLE_STORE_DEFAULT_CAPACITY;
+    }
+
+    resize( store, initial_capacity );
+
+    return store;
+}
+
+void particle_store_free
+    (
+        particle_store_type * store
+    )
+{
+    float_t  ** attributes[PARTICLE_STORE_ATTRIBUTE_COUNT];
+    uint32_t    i;
+
+    get_attributes( store, attributes );
+
+    for( i = 0; i < PARTICLE_STORE_ATTRIBUTE_COUNT; ++i )
+    {
+        aligned_free( *attributes[i] );
+    }
+
+    aligned_free( store->index_to_handle );
+    vector_deinit( store->handle_to_index );
+    vector_deinit( store->free_handles );
+    free( store );
+}
+
+void particle_store_reserve
+    (
+        particle_store_type * store,
+        uint32_t              capacity
+    )
+{
+    if( capacity > store->capacity )
+    {
+        resize( store, capacity );
+    }
+
+    /* Until handles are freed every particle takes a new one */
+    vector_reserve( store->handle_to_index, capacity );
+}
+
+particle_handle_type particle_store_add
+    (
+        particle_store_type * store,
+        float_t               position_x,
+        float_t               position_y,
+        float_t               position_z,
+        float_t               velocity_x,
+        float_t               velocity_y,
+        float_t               velocity_z,
+        float_t               mass
+    )
+{
+    particle_handle_type    handle;
+    uint32_t                index;
+
+    if( store->count >= store->capacity )
+    {
+        resize( store, store->capacity * PARTICLE_STORE_GROWTH_FACTOR );
+    }
+
+    index = store->count;
+    store->count += 1;
+
+    store->position_x[index]        = position_x;
+    store->position_y[index]        = position_y;
+    store->position_z[index]        = position_z;
+    store->velocity_x[index]        = velocity_x;
+    store->velocity_y[index]        = velocity_y;
+    store->velocity_z[index]        = velocity_z;
+    store->acceleration_x[index]    = 0.0f;
+    store->acceleration_y[index]    = 0.0f;
+    store->acceleration_z[index]    = 0.0f;
+    store->mass[index]              = mass;
+
+    /* Prefer recycled handles so the handle table stays dense */
+    if( vector_size( store->free_handles ) > 0 )
+    {
+        vector_pop_back( store->free_handles, &handle );
+        *vector_access( store->handle_to_index, handle, uint32_t ) = index;
+    }
+    else
+    {
+        handle = vector_size( store->handle_to_index );
+        vector_push_back( store->handle_to_index, &index );
+    }
+
+    store->index_to_handle[index] = handle;
+
+    return handle;
+}
+
+void particle_store_remove
+    (
+        particle_store_type * store,
+        particle_handle_type  handle
+    )
+{
+    float_t              ** attributes[PARTICLE_STORE_ATTRIBUTE_COUNT];
+    uint32_t                index;
+    uint32_t                last;
+    uint32_t                i;
+    uint32_t                invalid;
+    particle_handle_type    moved_handle;
+
+    index = particle_store_index( store, handle );
+    last = store->count - 1;
+
+    get_attributes( store, attributes );
+
+    /* Move the last body into the hole, then clear the last slot so the padding stays massless */
+    for( i = 0; i < PARTICLE_STORE_ATTRIBUTE_COUNT; ++i )
+    {
+        ( *attributes[i] )[index] = ( *attributes[i] )[last];
+        ( *attributes[i] )[last]  = 0.0f;
+    }
+
+    moved_handle = store->index_to_handle[last];
+    store->index_to_handle[index] = moved_handle;
+    *vector_access( store->handle_to_index, moved_handle, uint32_t ) = index;
+
+    invalid = PARTICLE_HANDLE_INVALID;
+    *vector_access( store->handle_to_index, handle, uint32_t ) = invalid;
+    vector_push_back( store->free_handles, &handle );
+
+    store->count -= 1;
+}
+
+uint32_t particle_store_index
+    (
+        particle_store_type const * store,
+        particle_handle_type        handle
+    )
+{
+    uint32_t index;
+
+    ASSERT( handle < vector_size( store->handle_to_index ) );
+
+    index = *vector_access( store->handle_to_index, handle, uint32_t );
+
+    ASSERT( index < store->count );
+
+    return index;
+}
+
+uint32_t particle_store_count
+    (
+        particle_store_type const * store
+    )
+{
+    return store->count;
+}
+
+static void get_attributes
+    (
+        particle_store_type * store,
+        float_t            ** attributes[PARTICLE_STORE_ATTRIBUTE_COUNT]
+    )
+{
+    attributes[0] = &store->position_x;
+    attributes[1] = &store->position_y;
+    attributes[2] = &store->position_z;
+    attributes[3] = &store->velocity_x;
+    attributes[4] = &store->velocity_y;
+    attributes[5] = &store->velocity_z;
+    attributes[6] = &store->acceleration_x;
+    attributes[7] = &store->acceleration_y;
+    attributes[8] = &store->acceleration_z;
+    attributes[9] = &store->mass;
+}
+
+static void resize
+    (
+        particle_store_type * store,
+        uint32_t              capacity
+    )
+{
+    float_t  ** attributes[PARTICLE_STORE_ATTRIBUTE_COUNT];
+    float_t   * new_array;
+    uint32_t  * new_handles;
+    uint32_t    i;
+
+    /* Round up to a whole number of vector lanes */
+    capacity = ( ( capacity + PARTICLE_STORE_LANES - 1 ) / PARTICLE_STORE_LANES ) * PARTICLE_STORE_LANES;
+
+    get_attributes( store, attributes );
+
+    for( i = 0; i < PARTICLE_STORE_ATTRIBUTE_COUNT; ++i )
+    {
+        new_array = aligned_calloc( capacity * sizeof( float_t ) );
+
+        if( NULL != *attributes[i] )
+        {
+            memcpy( new_array, *attributes[i], store->count * sizeof( float_t ) );
+            aligned_free( *attributes[i] );
+        }
+
+        *attributes[i] = new_array;
+    }
+
+    new_handles = aligned_calloc( capacity * sizeof( uint32_t ) );
+
+    if( NULL != store->index_to_handle )
+    {
+        memcpy( new_handles, store->index_to_handle, store->count * sizeof( uint32_t ) );
+        aligned_free( store->index_to_handle );
+    }
+
+    store->index_to_handle  = new_handles;
+    store->capacity         = capacity;
+}
+
+static void * aligned_calloc
+    (
+        uint32_t size
+    )
+{
+    uint8_t * raw;
+    uint8_t * aligned;
+
+    /* Over allocate, then stash the raw pointer just before the aligned block */
+    raw = calloc( 1, size + PARTICLE_STORE_ALIGNMENT + sizeof( void * ) );
+    ASSERT( NULL != raw );
+
+    aligned = raw + sizeof( void * );
+    aligned += ( PARTICLE_STORE_ALIGNMENT - ( (size_t)aligned % PARTICLE_STORE_ALIGNMENT ) ) % PARTICLE_STORE_ALIGNMENT;
+
+    ( (void **)aligned )[-1] = raw;
+
+    return aligned;
+}
+
+static void aligned_free
+    (
+        void * memory
+    )
+{
+    if( NULL != memory )
+    {
+        free( ( (void **)memory )[-1] );
+    }
+}
@@ -0,0 +1,139 @@
+/**
+ * @file particle_store.h
+ *
+ * @brief Structure-of-arrays storage for simulation bodies
+ *
+ * Every attribute lives in its own contiguous, cache line aligned float
+ * array so force and integration loops stream through memory linearly.
+ * Bodies are referred to by stable handles; the dense index of a body
+ * may change when another body is removed.
+ */
+#ifndef PARTICLE_STORE_H
+#define PARTICLE_STORE_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+#include "vector.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+/* Byte alignment of every attribute array, enough for a 512 bit load */
+#define PARTICLE_STORE_ALIGNMENT    ( 64 )
+
+/* Capacity is always a multiple of this many floats, so vector loops can run past count without a scalar tail */
+#define PARTICLE_STORE_LANES        ( PARTICLE_STORE_ALIGNMENT / sizeof( float_t ) )
+
+#define PARTICLE_HANDLE_INVALID     ( 0xFFFFFFFF )
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+typedef uint32_t particle_handle_type;
+
+/**
+ * @brief SoA particle storage.
+ *
+ * The attribute arrays may be read and written directly for indices
+ * [0, count). Slots in [count, capacity) are zero filled with zero mass.
+ * Any add, remove or reserve may reallocate the arrays, so pointers
+ * to them should be fetched again afterwards.
+ */
+typedef struct particle_store_struct
+{
+    float_t       * position_x;
+    float_t       * position_y;
+    float_t       * position_z;
+    float_t       * velocity_x;
+    float_t       * velocity_y;
+    float_t       * velocity_z;
+    float_t       * acceleration_x;
+    float_t       * acceleration_y;
+    float_t       * acceleration_z;
+    float_t       * mass;
+    uint32_t      * index_to_handle;    /* The handle of the body at each dense index */
+    uint32_t        count;
+    uint32_t        capacity;
+    vector_type   * handle_to_index;    /* uint32_t dense index for each handle, PARTICLE_HANDLE_INVALID if removed */
+    vector_type   * free_handles;       /* particle_handle_type handles available for reuse */
+} particle_store_type;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocates and returns a new, empty particle store
+ */
+particle_store_type * particle_store_create
+    (
+        uint32_t initial_capacity
+    );
+
+/**
+ * @brief Deletes a particle store
+ */
+void particle_store_free
+    (
+        particle_store_type * store
+    );
+
+/**
+ * @brief Make room for at least capacity bodies, so a known number of adds
+ *        won't reallocate.
+ */
+void particle_store_reserve
+    (
+        particle_store_type * store,
+        uint32_t              capacity
+    );
+
+/**
+ * @brief Add a body to the store
+ *
+ * @return A handle that stays valid until the body is removed
+ */
+particle_handle_type particle_store_add
+    (
+        particle_store_type * store,
+        float_t               position_x,
+        float_t               position_y,
+        float_t               position_z,
+        float_t               velocity_x,
+        float_t               velocity_y,
+        float_t               velocity_z,
+        float_t               mass
+    );
+
+/**
+ * @brief Remove a body from the store, the last body is moved into its slot
+ */
+void particle_store_remove
+    (
+        particle_store_type * store,
+        particle_handle_type  handle
+    );
+
+/**
+ * @brief Get the current dense index of a body
+ */
+uint32_t particle_store_index
+    (
+        particle_store_type const * store,
+        particle_handle_type        handle
+    );
+
+/**
+ * @brief Get the number of bodies in the store
+ */
+uint32_t particle_store_count
+    (
+        particle_store_type const * store
+    );
+
+#endif /* PARTICLE_STORE_H */
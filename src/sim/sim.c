@@ -0,0 +1,209 @@
+/**
+ * @file sim.c
+ *
+ * @brief Implementation of the headless n-body gravity simulation
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim.h"
+#include "sim_force.h"
+#include "sim_integrator.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define SIM_DEFAULT_GRAVITATIONAL_CONSTANT  ( 1.0f )
+#define SIM_DEFAULT_SOFTENING               ( 0.01f )
+#define SIM_DEFAULT_TIME_STEP               ( 0.001f )
+#define SIM_DEFAULT_FORCE_SOLVER            ( SIM_FORCE_SOLVER_DIRECT )
+#define SIM_DEFAULT_INTEGRATOR              ( SIM_INTEGRATOR_LEAPFROG )
+#define SIM_DEFAULT_BLOCK_LEVELS            ( 6 )
+#define SIM_DEFAULT_TIME_STEP_ACCURACY      ( 0.025f )
+#define SIM_DEFAULT_OPENING_ANGLE           ( 0.5f )
+#define SIM_DEFAULT_LEAF_CAPACITY           ( 16 )
+#define SIM_DEFAULT_EXPANSION_ORDER         ( 4 )
+#define SIM_DEFAULT_WORKER_COUNT            ( 1 ) /* Apps opt in to using more cores */
+#define SIM_DEFAULT_CAPACITY                ( 0 ) /* Use the store default */
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void sim_config_default
+    (
+        sim_config_type * config
+    )
+{
+    memset( config, 0, sizeof( sim_config_type ) );
+
+    config->gravitational_constant  = SIM_DEFAULT_GRAVITATIONAL_CONSTANT;
+    config->softening               = SIM_DEFAULT_SOFTENING;
+    config->time_step               = SIM_DEFAULT_TIME_STEP;
+    config->force_solver            = SIM_DEFAULT_FORCE_SOLVER;
+    config->integrator              = SIM_DEFAULT_INTEGRATOR;
+    config->block_levels            = SIM_DEFAULT_BLOCK_LEVELS;
+    config->time_step_accuracy      = SIM_DEFAULT_TIME_STEP_ACCURACY;
+    config->opening_angle           = SIM_DEFAULT_OPENING_ANGLE;
+    config->leaf_capacity           = SIM_DEFAULT_LEAF_CAPACITY;
+    config->expansion_order         = SIM_DEFAULT_EXPANSION_ORDER;
+    config->worker_count            = SIM_DEFAULT_WORKER_COUNT;
+    config->pin_workers             = FALSE;
+}
+
+sim_type * sim_create
+    (
+        sim_config_type const * config
+    )
+{
+    sim_type * sim;
+
+    sim = calloc( 1, sizeof( sim_type ) );
+
+    memcpy( &sim->config, config, sizeof( sim_config_type ) );
+    sim->particles              = particle_store_create( SIM_DEFAULT_CAPACITY );
+    sim->time                   = 0.0;
+    sim->step_count             = 0;
+    sim->accelerations_valid    = FALSE;
+    sim->pool                   = thread_pool_create( config->worker_count, config->pin_workers );
+
+    sim_force_init( sim );
+    sim_integrator_init( sim );
+
+    return sim;
+}
+
+void sim_free
+    (
+        sim_type * sim
+    )
+{
+    sim_integrator_deinit( sim );
+    sim_force_deinit( sim );
+    thread_pool_free( sim->pool );
+    particle_store_free( sim->particles );
+    free( sim );
+}
+
+void sim_reserve
+    (
+        sim_type * sim,
+        uint32_t   capacity
+    )
+{
+    particle_store_reserve( sim->particles, capacity );
+}
+
+particle_handle_type sim_add_particle
+    (
+        sim_type            * sim,
+        sim_vec3_type const * position,
+        sim_vec3_type const * velocity,
+        float_t               mass
+    )
+{
+    sim->accelerations_valid = FALSE;
+
+    return particle_store_add
+        (
+            sim->particles,
+            position->x, position->y, position->z,
+            velocity->x, velocity->y, velocity->z,
+            mass
+        );
+}
+
+void sim_remove_particle
+    (
+        sim_type              * sim,
+        particle_handle_type    handle
+    )
+{
+    particle_store_remove( sim->particles, handle );
+    sim->accelerations_valid = FALSE;
+}
+
+uint32_t sim_particle_count
+    (
+        sim_type const * sim
+    )
+{
+    return particle_store_count( sim->particles );
+}
+
+void sim_get_position
+    (
+        sim_type const        * sim,
+        particle_handle_type    handle,
+        sim_vec3_type         * position
+    )
+{
+    uint32_t index;
+
+    index = particle_store_index( sim->particles, handle );
+
+    position->x = sim->particles->position_x[index];
+    position->y = sim->particles->position_y[index];
+    position->z = sim->particles->position_z[index];
+}
+
+void sim_step
+    (
+        sim_type * sim
+    )
+{
+    sim_integrator_step( sim );
+
+    sim->time += sim->config.time_step;
+    sim->step_count += 1;
+}
+
+void sim_run
+    (
+        sim_type * sim,
+        uint32_t   step_count
+    )
+{
+    uint32_t i;
+
+    for( i = 0; i < step_count; ++i )
+    {
+        sim_step( sim );
+    }
+}
+
+double_t sim_get_time
+    (
+        sim_type const * sim
+    )
+{
+    return sim->time;
+}
+
+double_t sim_total_energy
+    (
+        sim_type const * sim
+    )
+{
+    particle_store_type const * store;
+    uint32_t                    i;
+    double_t                    kinetic;
+
+    store = sim->particles;
+    kinetic = 0.0;
+
+    for( i = 0; i < store->count; ++i )
+    {
+        kinetic += 0.5 * store->mass[i] *
+            ( (double_t)store->velocity_x[i] * store->velocity_x[i] +
+              (double_t)store->velocity_y[i] * store->velocity_y[i] +
+              (double_t)store->velocity_z[i] * store->velocity_z[i] );
+    }
+
+    return kinetic + sim_force_potential_energy( sim );
+}
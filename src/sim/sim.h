@@ -0,0 +1,127 @@
+/**
+ * @file sim.h
+ *
+ * @brief Interface to the headless n-body gravity simulation
+ */
+#ifndef SIM_H
+#define SIM_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Fill a config with sensible defaults
+ */
+void sim_config_default
+    (
+        sim_config_type * config
+    );
+
+/**
+ * @brief Allocates and returns a new, empty simulation
+ */
+sim_type * sim_create
+    (
+        sim_config_type const * config
+    );
+
+/**
+ * @brief Deletes a simulation and all of its particles
+ */
+void sim_free
+    (
+        sim_type * sim
+    );
+
+/**
+ * @brief Make room for capacity bodies up front, avoids repeated
+ *        reallocation when building large systems.
+ */
+void sim_reserve
+    (
+        sim_type * sim,
+        uint32_t   capacity
+    );
+
+/**
+ * @brief Add a body to the simulation
+ *
+ * @return A handle to the new particle, stable until it is removed
+ */
+particle_handle_type sim_add_particle
+    (
+        sim_type            * sim,
+        sim_vec3_type const * position,
+        sim_vec3_type const * velocity,
+        float_t               mass
+    );
+
+/**
+ * @brief Remove a body from the simulation
+ */
+void sim_remove_particle
+    (
+        sim_type              * sim,
+        particle_handle_type    handle
+    );
+
+/**
+ * @brief Get the number of bodies in the simulation
+ */
+uint32_t sim_particle_count
+    (
+        sim_type const * sim
+    );
+
+/**
+ * @brief Get the current position of a body
+ */
+void sim_get_position
+    (
+        sim_type const        * sim,
+        particle_handle_type    handle,
+        sim_vec3_type         * position /* [out] */
+    );
+
+/**
+ * @brief Advance the simulation by one time step
+ */
+void sim_step
+    (
+        sim_type * sim
+    );
+
+/**
+ * @brief Advance the simulation by several time steps
+ */
+void sim_run
+    (
+        sim_type * sim,
+        uint32_t   step_count
+    );
+
+/**
+ * @brief Get the simulation time
+ */
+double_t sim_get_time
+    (
+        sim_type const * sim
+    );
+
+/**
+ * @brief Compute the total (kinetic + potential) energy of the system.
+ *        Useful for monitoring integration error, O(N^2).
+ */
+double_t sim_total_energy
+    (
+        sim_type const * sim
+    );
+
+#endif /* SIM_H */
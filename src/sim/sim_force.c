@@ -0,0 +1,277 @@
+/**
+ * @file sim_force.c
+ *
+ * @brief Dispatch to the configured gravity force solver
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_force.h"
+#include "sim_force_direct.h"
+#include "sim_force_barnes_hut.h"
+#include "sim_force_fmm.h"
+#include "common_util.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+typedef void * (*sim_force_create_cb)
+    (
+        sim_config_type const * config
+    );
+
+typedef void (*sim_force_free_cb)
+    (
+        void * state
+    );
+
+typedef void (*sim_force_compute_cb)
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+typedef void (*sim_force_active_cb)
+    (
+        sim_type                        * sim,
+        void                            * state,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    );
+
+typedef struct sim_force_solver_struct
+{
+    sim_force_create_cb         create;         /* Optional, state is NULL if not provided */
+    sim_force_free_cb           free;           /* Optional */
+    sim_force_compute_cb        compute;
+    sim_force_compute_cb        begin_block;    /* Optional, block steps only */
+    sim_force_active_cb         compute_active; /* Optional, the solver can't do block steps if not provided */
+    sim_force_active_cb         update_active;  /* Optional, block steps only */
+} sim_force_solver_type;
+
+/**********************************************************************
+                                MEMORY CONSTANTS
+**********************************************************************/
+
+/* Indexed by sim_force_solver_t8 */
+static sim_force_solver_type const force_solvers[SIM_FORCE_SOLVER_COUNT] =
+{
+    { sim_force_direct_create,      sim_force_direct_free,      sim_force_direct_compute,       NULL,                               sim_force_direct_compute_active,        NULL },
+    { sim_force_barnes_hut_create,  sim_force_barnes_hut_free,  sim_force_barnes_hut_compute,   sim_force_barnes_hut_begin_block,   sim_force_barnes_hut_compute_active,    sim_force_barnes_hut_update_active },
+    { sim_force_fmm_create,         sim_force_fmm_free,         sim_force_fmm_compute,          NULL,                               NULL,                                   NULL }
+};
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void sim_force_init
+    (
+        sim_type * sim
+    )
+{
+    sim_force_solver_type const * solver;
+
+    ASSERT( sim->config.force_solver < SIM_FORCE_SOLVER_COUNT );
+
+    /* Pick the direct kernel now rather than have the force workers race to */
+    sim_force_direct_get_kernel();
+
+    solver = &force_solvers[sim->config.force_solver];
+    sim->force_state = ( NULL != solver->create ) ? solver->create( &sim->config ) : NULL;
+}
+
+void sim_force_deinit
+    (
+        sim_type * sim
+    )
+{
+    sim_force_solver_type const * solver;
+
+    solver = &force_solvers[sim->config.force_solver];
+
+    if( NULL != solver->free )
+    {
+        solver->free( sim->force_state );
+    }
+
+    sim->force_state = NULL;
+}
+
+void sim_force_compute
+    (
+        sim_type * sim
+    )
+{
+    force_solvers[sim->config.force_solver].compute( sim, sim->force_state );
+    sim->accelerations_valid = TRUE;
+}
+
+boolean sim_force_supports_block_steps
+    (
+        sim_force_solver_t8 solver
+    )
+{
+    return ( solver < SIM_FORCE_SOLVER_COUNT ) && ( NULL != force_solvers[solver].compute_active );
+}
+
+void sim_force_begin_block_step
+    (
+        sim_type * sim
+    )
+{
+    sim_force_solver_type const * solver;
+
+    solver = &force_solvers[sim->config.force_solver];
+
+    if( NULL != solver->begin_block )
+    {
+        solver->begin_block( sim, sim->force_state );
+    }
+}
+
+void sim_force_compute_active
+    (
+        sim_type                        * sim,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    )
+{
+    sim_force_solver_type const * solver;
+
+    solver = &force_solvers[sim->config.force_solver];
+    ASSERT( NULL != solver->compute_active );
+
+    if( 0 == active_count )
+    {
+        return;
+    }
+
+    solver->compute_active( sim, sim->force_state, active, active_count, prediction );
+}
+
+void sim_force_update_active
+    (
+        sim_type                        * sim,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    )
+{
+    sim_force_solver_type const * solver;
+
+    solver = &force_solvers[sim->config.force_solver];
+
+    if( NULL != solver->update_active )
+    {
+        solver->update_active( sim, sim->force_state, active, active_count, prediction );
+    }
+}
+
+void sim_force_measure_error
+    (
+        sim_type                * sim,
+        uint32_t                  sample_count,
+        sim_force_error_type    * error
+    )
+{
+    particle_store_type   * store;
+    uint32_t                i;
+    uint32_t                stride;
+    float_t                 ax;
+    float_t                 ay;
+    float_t                 az;
+    double_t                dx;
+    double_t                dy;
+    double_t                dz;
+    double_t                magnitude_sq;
+    double_t                relative_error;
+    double_t                sum_sq;
+
+    memset( error, 0, sizeof( sim_force_error_type ) );
+
+    sim_force_compute( sim );
+
+    store = sim->particles;
+    if( 0 == store->count )
+    {
+        return;
+    }
+
+    if( ( 0 == sample_count ) || ( sample_count > store->count ) )
+    {
+        sample_count = store->count;
+    }
+
+    stride = store->count / sample_count;
+    sum_sq = 0.0;
+
+    for( i = 0; i < sample_count; ++i )
+    {
+        sim_force_direct_target( sim, i * stride, &ax, &ay, &az );
+
+        dx = store->acceleration_x[i * stride] - ax;
+        dy = store->acceleration_y[i * stride] - ay;
+        dz = store->acceleration_z[i * stride] - az;
+
+        magnitude_sq = (double_t)ax * ax + (double_t)ay * ay + (double_t)az * az;
+        if( 0.0 == magnitude_sq )
+        {
+            continue;
+        }
+
+        relative_error = sqrt( ( dx * dx + dy * dy + dz * dz ) / magnitude_sq );
+
+        sum_sq += relative_error * relative_error;
+        error->max_relative_error = MAX( error->max_relative_error, relative_error );
+        error->sample_count += 1;
+    }
+
+    if( error->sample_count > 0 )
+    {
+        error->rms_relative_error = sqrt( sum_sq / error->sample_count );
+    }
+}
+
+double_t sim_force_potential_energy
+    (
+        sim_type const * sim
+    )
+{
+    particle_store_type const * store;
+    uint32_t                    i;
+    uint32_t                    j;
+    uint32_t                    len;
+    double_t                    energy;
+    double_t                    dx;
+    double_t                    dy;
+    double_t                    dz;
+    double_t                    softening_sq;
+
+    store           = sim->particles;
+    len             = store->count;
+    softening_sq    = (double_t)sim->config.softening * sim->config.softening;
+    energy          = 0.0;
+
+    for( i = 0; i < len; ++i )
+    {
+        for( j = i + 1; j < len; ++j )
+        {
+            dx = store->position_x[j] - store->position_x[i];
+            dy = store->position_y[j] - store->position_y[i];
+            dz = store->position_z[j] - store->position_z[i];
+
+            energy -= (double_t)store->mass[i] * store->mass[j] / sqrt( dx * dx + dy * dy + dz * dz + softening_sq );
+        }
+    }
+
+    return energy * sim->config.gravitational_constant;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file sim_force.h
+ *
+ * @brief Gravity force solvers for the simulation
+ */
+#ifndef SIM_FORCE_H
+#define SIM_FORCE_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Set up the state of the force solver selected in the sim config
+ */
+void sim_force_init
+    (
+        sim_type * sim
+    );
+
+/**
+ * @brief Free the state of the force solver
+ */
+void sim_force_deinit
+    (
+        sim_type * sim
+    );
+
+/**
+ * @brief Compute the gravitational acceleration on every particle
+ *        with the force solver selected in the sim config.
+ */
+void sim_force_compute
+    (
+        sim_type * sim
+    );
+
+/**
+ * @brief Check whether a solver can compute the active bodies of a block step alone
+ */
+boolean sim_force_supports_block_steps
+    (
+        sim_force_solver_t8 solver
+    );
+
+/**
+ * @brief Start a block step, every body is synchronised at time 0 of the step.
+ *        Tree solvers build their tree here, once per block step.
+ */
+void sim_force_begin_block_step
+    (
+        sim_type * sim
+    );
+
+/**
+ * @brief Compute the gravitational acceleration on the listed particles only,
+ *        part way through a block step. The listed bodies must be synchronised
+ *        at the prediction time, the others are predicted from their sync time.
+ */
+void sim_force_compute_active
+    (
+        sim_type                        * sim,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    );
+
+/**
+ * @brief The listed particles were drifted to the prediction time and kicked,
+ *        update whatever the solver keeps about them for the rest of the block step
+ */
+void sim_force_update_active
+    (
+        sim_type                        * sim,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    );
+
+/**
+ * @brief Measure the error of the configured force solver against direct summation.
+ *
+ * Direct summation is only run for sample_count evenly spaced bodies
+ * (0 for all bodies), so this stays affordable for large systems.
+ *
+ * @note Leaves the accelerations from the configured solver in the particle store.
+ */
+void sim_force_measure_error
+    (
+        sim_type                * sim,
+        uint32_t                  sample_count,
+        sim_force_error_type    * error /* [out] */
+    );
+
+/**
+ * @brief Compute the softened gravitational potential energy of the system
+ */
+double_t sim_force_potential_energy
+    (
+        sim_type const * sim
+    );
+
+#endif /* SIM_FORCE_H */
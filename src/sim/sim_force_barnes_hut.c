@@ -0,0 +1,667 @@
+/**
+ * @file sim_force_barnes_hut.c
+ *
+ * @brief Implementation of the Barnes-Hut octree gravity solver
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_force_barnes_hut.h"
+#include "sim_force_direct.h"
+#include "sim_octree.h"
+#include "common_util.h"
+#include <math.h>
+#include <stdlib.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define BH_STACK_SIZE       ( SIM_OCTREE_MAX_DEPTH * ( SIM_OCTREE_CHILD_COUNT - 1 ) + 1 )
+#define BH_PREDICT_CHUNK    ( 64 )  /* Leaf bodies predicted per kernel call in a block step */
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+/**
+ * @brief Per body bookkeeping next to the tree's sorted positions and masses
+ *
+ * For a block step the sorted positions are x - v * sync_time, so a body's
+ * position at time t is position + velocity * t whenever it was last kicked.
+ */
+typedef struct bh_sorted_struct
+{
+    float_t   * velocity_x;     /* In body_order, block steps only */
+    float_t   * velocity_y;
+    float_t   * velocity_z;
+    uint32_t  * rank;           /* Per particle index, its index in body_order */
+    uint32_t  * leaf;           /* Per particle index, the leaf node holding it */
+    uint32_t    capacity;
+} bh_sorted_type;
+
+/**
+ * @brief Solver state, the tree storage is reused between steps
+ *
+ * Through a block step the tree is kept from its start. Between kicks every
+ * body moves in a straight line, so each node's centre of mass at time t is
+ * com + com_velocity * t, with com the mass weighted mean of x - v * sync_time.
+ * Kicks refit com and com_velocity along the path from the body's leaf to the root.
+ */
+typedef struct bh_solver_struct
+{
+    sim_octree_type                   * tree;
+    float_t                             opening_angle;
+    uint32_t                            leaf_capacity;
+    bh_sorted_type                      sorted;         /* Valid for the last tree built */
+    uint32_t                          * parent;         /* Per node, valid from the start of a block step, the root is its own parent */
+    uint32_t                            parent_capacity;
+    sim_type                          * sim;            /* Set for the duration of a force pass, for the worker tasks */
+    uint32_t const                    * targets;        /* Set for the duration of a force pass, indices of the bodies to compute */
+    sim_force_prediction_type const   * prediction;     /* Set for the duration of a block step pass, NULL when every body is synchronised */
+} bh_solver_type;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Build the tree over the current positions and record where every body landed
+ */
+static void build_tree
+    (
+        bh_solver_type            * solver,
+        particle_store_type const * store
+    );
+
+/**
+ * @brief Run a force pass over the listed targets on the current tree
+ */
+static void compute_pass
+    (
+        bh_solver_type                    * solver,
+        sim_type                          * sim,
+        uint32_t const                    * targets,
+        uint32_t                            target_count,
+        sim_force_prediction_type const   * prediction
+    );
+
+/**
+ * @brief Thread pool task, computes the accelerations of targets[first, last)
+ */
+static void compute_targets
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    );
+
+/**
+ * @brief Walk the tree to compute the (unscaled by G) acceleration on one body
+ */
+static void walk_tree
+    (
+        bh_solver_type const      * solver,
+        particle_store_type const * store,
+        uint32_t                    index,
+        float_t                     softening_sq,
+        float_t                   * ax, /* [out] */
+        float_t                   * ay, /* [out] */
+        float_t                   * az  /* [out] */
+    );
+
+/**
+ * @brief Add the (unscaled by G) acceleration at x, y, z due to the sorted bodies [first, last),
+ *        predicted to the pass's time in a block step
+ */
+static void accumulate_leaf
+    (
+        bh_solver_type const  * solver,
+        float_t                 x,
+        float_t                 y,
+        float_t                 z,
+        uint32_t                first,
+        uint32_t                last,
+        float_t                 softening_sq,
+        float_t               * ax, /* [in/out] */
+        float_t               * ay, /* [in/out] */
+        float_t               * az  /* [in/out] */
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void * sim_force_barnes_hut_create
+    (
+        sim_config_type const * config
+    )
+{
+    bh_solver_type * solver;
+
+    solver = calloc( 1, sizeof( bh_solver_type ) );
+
+    solver->tree            = sim_octree_create();
+    solver->opening_angle   = config->opening_angle;
+    solver->leaf_capacity   = config->leaf_capacity;
+
+    return solver;
+}
+
+void sim_force_barnes_hut_free
+    (
+        void * state
+    )
+{
+    bh_solver_type * solver;
+
+    solver = (bh_solver_type *)state;
+
+    sim_octree_free( solver->tree );
+
+    free( solver->sorted.velocity_x );
+    free( solver->sorted.velocity_y );
+    free( solver->sorted.velocity_z );
+    free( solver->sorted.rank );
+    free( solver->sorted.leaf );
+
+    free( solver->parent );
+    free( solver );
+}
+
+void sim_force_barnes_hut_compute
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    bh_solver_type * solver;
+
+    solver = (bh_solver_type *)state;
+
+    if( 0 == sim->particles->count )
+    {
+        return;
+    }
+
+    build_tree( solver, sim->particles );
+
+    /*
+     * Visit targets in tree order so neighbouring walks touch the same nodes,
+     * each worker takes contiguous runs of body_order and so whole subtrees.
+     */
+    compute_pass( solver, sim, solver->tree->body_order, sim->particles->count, NULL );
+}
+
+void sim_force_barnes_hut_begin_block
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    bh_solver_type        * solver;
+    particle_store_type   * store;
+    bh_sorted_type        * sorted;
+    sim_octree_type       * tree;
+    sim_octree_node_type  * node;
+    sim_octree_node_type  * child;
+    uint32_t                n;
+    uint32_t                i;
+
+    solver  = (bh_solver_type *)state;
+    store   = sim->particles;
+    sorted  = &solver->sorted;
+    tree    = solver->tree;
+
+    if( 0 == store->count )
+    {
+        return;
+    }
+
+    /* Every body is synchronised at time 0, so x - v * sync_time is just the position and the built com is right */
+    build_tree( solver, store );
+
+    for( i = 0; i < store->count; ++i )
+    {
+        sorted->velocity_x[i] = store->velocity_x[tree->body_order[i]];
+        sorted->velocity_y[i] = store->velocity_y[tree->body_order[i]];
+        sorted->velocity_z[i] = store->velocity_z[tree->body_order[i]];
+    }
+
+    if( tree->node_count > solver->parent_capacity )
+    {
+        free( solver->parent );
+        solver->parent_capacity = tree->node_capacity;
+        solver->parent          = malloc( solver->parent_capacity * sizeof( uint32_t ) );
+    }
+
+    solver->parent[0] = 0;
+
+    /* Bottom up, so the children are done before their parent */
+    for( n = tree->node_count; n-- > 0; )
+    {
+        node = &tree->nodes[n];
+
+        node->com_velocity_x = 0.0f;
+        node->com_velocity_y = 0.0f;
+        node->com_velocity_z = 0.0f;
+
+        if( SIM_OCTREE_NO_CHILDREN == node->first_child )
+        {
+            for( i = node->first_body; i < node->first_body + node->body_count; ++i )
+            {
+                node->com_velocity_x += tree->sorted.mass[i] * sorted->velocity_x[i];
+                node->com_velocity_y += tree->sorted.mass[i] * sorted->velocity_y[i];
+                node->com_velocity_z += tree->sorted.mass[i] * sorted->velocity_z[i];
+            }
+        }
+        else
+        {
+            for( i = node->first_child; i < node->first_child + SIM_OCTREE_CHILD_COUNT; ++i )
+            {
+                child = &tree->nodes[i];
+
+                node->com_velocity_x += child->mass * child->com_velocity_x;
+                node->com_velocity_y += child->mass * child->com_velocity_y;
+                node->com_velocity_z += child->mass * child->com_velocity_z;
+
+                solver->parent[i] = n;
+            }
+        }
+
+        /* Empty nodes are skipped by the walks and never refit */
+        if( node->mass > 0.0f )
+        {
+            node->com_velocity_x /= node->mass;
+            node->com_velocity_y /= node->mass;
+            node->com_velocity_z /= node->mass;
+        }
+    }
+}
+
+void sim_force_barnes_hut_compute_active
+    (
+        sim_type                        * sim,
+        void                            * state,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    )
+{
+    /* The tree is the one from the start of the block step, nothing is rebuilt here */
+    compute_pass( (bh_solver_type *)state, sim, active, active_count, prediction );
+}
+
+void sim_force_barnes_hut_update_active
+    (
+        sim_type                        * sim,
+        void                            * state,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    )
+{
+    bh_solver_type          * solver;
+    particle_store_type     * store;
+    bh_sorted_type          * sorted;
+    sim_force_sources_type  * bodies;
+    sim_octree_node_type    * node;
+    uint32_t                  i;
+    uint32_t                  index;
+    uint32_t                  rank;
+    uint32_t                  n;
+    float_t                   mass;
+    float_t                   inv_mass;
+    float_t                   position_x;
+    float_t                   position_y;
+    float_t                   position_z;
+    float_t                   d_position_x;
+    float_t                   d_position_y;
+    float_t                   d_position_z;
+    float_t                   d_velocity_x;
+    float_t                   d_velocity_y;
+    float_t                   d_velocity_z;
+
+    solver  = (bh_solver_type *)state;
+    store   = sim->particles;
+    sorted  = &solver->sorted;
+    bodies  = &solver->tree->sorted;
+
+    /*
+     * A drift leaves x - v * t alone, only the kicks change what a body adds
+     * to the moments. Push the change up from its leaf, O(depth) per body.
+     */
+    for( i = 0; i < active_count; ++i )
+    {
+        index   = active[i];
+        rank    = sorted->rank[index];
+        mass    = store->mass[index];
+
+        position_x = store->position_x[index] - store->velocity_x[index] * prediction->time;
+        position_y = store->position_y[index] - store->velocity_y[index] * prediction->time;
+        position_z = store->position_z[index] - store->velocity_z[index] * prediction->time;
+
+        d_position_x = mass * ( position_x - bodies->position_x[rank] );
+        d_position_y = mass * ( position_y - bodies->position_y[rank] );
+        d_position_z = mass * ( position_z - bodies->position_z[rank] );
+        d_velocity_x = mass * ( store->velocity_x[index] - sorted->velocity_x[rank] );
+        d_velocity_y = mass * ( store->velocity_y[index] - sorted->velocity_y[rank] );
+        d_velocity_z = mass * ( store->velocity_z[index] - sorted->velocity_z[rank] );
+
+        bodies->position_x[rank] = position_x;
+        bodies->position_y[rank] = position_y;
+        bodies->position_z[rank] = position_z;
+        sorted->velocity_x[rank] = store->velocity_x[index];
+        sorted->velocity_y[rank] = store->velocity_y[index];
+        sorted->velocity_z[rank] = store->velocity_z[index];
+
+        if( 0.0f == mass )
+        {
+            continue;
+        }
+
+        n = sorted->leaf[index];
+        for( ;; )
+        {
+            node        = &solver->tree->nodes[n];
+            inv_mass    = 1.0f / node->mass;
+
+            node->com_x             += d_position_x * inv_mass;
+            node->com_y             += d_position_y * inv_mass;
+            node->com_z             += d_position_z * inv_mass;
+            node->com_velocity_x    += d_velocity_x * inv_mass;
+            node->com_velocity_y    += d_velocity_y * inv_mass;
+            node->com_velocity_z    += d_velocity_z * inv_mass;
+
+            if( 0 == n )
+            {
+                break;
+            }
+
+            n = solver->parent[n];
+        }
+    }
+}
+
+static void build_tree
+    (
+        bh_solver_type            * solver,
+        particle_store_type const * store
+    )
+{
+    sim_octree_type const       * tree;
+    sim_octree_node_type const  * node;
+    bh_sorted_type              * sorted;
+    uint32_t                      n;
+    uint32_t                      i;
+
+    tree    = solver->tree;
+    sorted  = &solver->sorted;
+
+    sim_octree_build( solver->tree, store, solver->leaf_capacity );
+
+    if( store->count > sorted->capacity )
+    {
+        free( sorted->velocity_x );
+        free( sorted->velocity_y );
+        free( sorted->velocity_z );
+        free( sorted->rank );
+        free( sorted->leaf );
+
+        sorted->capacity    = store->count;
+        sorted->velocity_x  = malloc( store->count * sizeof( float_t ) );
+        sorted->velocity_y  = malloc( store->count * sizeof( float_t ) );
+        sorted->velocity_z  = malloc( store->count * sizeof( float_t ) );
+        sorted->rank        = malloc( store->count * sizeof( uint32_t ) );
+        sorted->leaf        = malloc( store->count * sizeof( uint32_t ) );
+    }
+
+    for( i = 0; i < store->count; ++i )
+    {
+        sorted->rank[tree->body_order[i]] = i;
+    }
+
+    for( n = 0; n < tree->node_count; ++n )
+    {
+        node = &tree->nodes[n];
+
+        if( SIM_OCTREE_NO_CHILDREN != node->first_child )
+        {
+            continue;
+        }
+
+        for( i = node->first_body; i < node->first_body + node->body_count; ++i )
+        {
+            sorted->leaf[tree->body_order[i]] = n;
+        }
+    }
+}
+
+static void compute_pass
+    (
+        bh_solver_type                    * solver,
+        sim_type                          * sim,
+        uint32_t const                    * targets,
+        uint32_t                            target_count,
+        sim_force_prediction_type const   * prediction
+    )
+{
+    solver->sim         = sim;
+    solver->targets     = targets;
+    solver->prediction  = prediction;
+    thread_pool_parallel_for( sim->pool, target_count, THREAD_POOL_GRAIN_AUTO, compute_targets, solver );
+    solver->sim         = NULL;
+    solver->targets     = NULL;
+    solver->prediction  = NULL;
+}
+
+static void compute_targets
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    )
+{
+    bh_solver_type        * solver;
+    particle_store_type   * store;
+    uint32_t                i;
+    uint32_t                index;
+    float_t                 g;
+    float_t                 softening_sq;
+
+    solver          = (bh_solver_type *)user_data;
+    store           = solver->sim->particles;
+    g               = solver->sim->config.gravitational_constant;
+    softening_sq    = solver->sim->config.softening * solver->sim->config.softening;
+
+    for( i = first; i < last; ++i )
+    {
+        index = solver->targets[i];
+
+        walk_tree( solver, store, index, softening_sq, &store->acceleration_x[index], &store->acceleration_y[index], &store->acceleration_z[index] );
+
+        store->acceleration_x[index] *= g;
+        store->acceleration_y[index] *= g;
+        store->acceleration_z[index] *= g;
+    }
+}
+
+static void walk_tree
+    (
+        bh_solver_type const      * solver,
+        particle_store_type const * store,
+        uint32_t                    index,
+        float_t                     softening_sq,
+        float_t                   * ax,
+        float_t                   * ay,
+        float_t                   * az
+    )
+{
+    sim_octree_type const            * tree;
+    sim_force_prediction_type const  * prediction;
+    sim_octree_node_type const       * node;
+    uint32_t                           stack[BH_STACK_SIZE];
+    uint32_t                           stack_size;
+    uint32_t                           i;
+    uint32_t                           rank;
+    float_t                            x;
+    float_t                            y;
+    float_t                            z;
+    float_t                            dx;
+    float_t                            dy;
+    float_t                            dz;
+    float_t                            distance_sq;
+    float_t                            size;
+    float_t                            theta_sq;
+    float_t                            inv_r;
+    float_t                            inv_r3;
+    float_t                            sum_x;
+    float_t                            sum_y;
+    float_t                            sum_z;
+    boolean                            contains_target;
+
+    tree        = solver->tree;
+    prediction  = solver->prediction;
+    rank        = solver->sorted.rank[index];
+
+    /* A target is always synchronised at the force time */
+    x = store->position_x[index];
+    y = store->position_y[index];
+    z = store->position_z[index];
+
+    theta_sq = solver->opening_angle * solver->opening_angle;
+
+    sum_x = 0.0f;
+    sum_y = 0.0f;
+    sum_z = 0.0f;
+
+    stack[0] = 0;
+    stack_size = 1;
+
+    while( stack_size > 0 )
+    {
+        node = &tree->nodes[stack[--stack_size]];
+
+        if( 0.0f == node->mass )
+        {
+            continue;
+        }
+
+        if( NULL == prediction )
+        {
+            dx = node->com_x - x;
+            dy = node->com_y - y;
+            dz = node->com_z - z;
+        }
+        else
+        {
+            /* The node keeps its box from the start of the block step, only its centre of mass moves */
+            dx = node->com_x + node->com_velocity_x * prediction->time - x;
+            dy = node->com_y + node->com_velocity_y * prediction->time - y;
+            dz = node->com_z + node->com_velocity_z * prediction->time - z;
+        }
+
+        distance_sq = dx * dx + dy * dy + dz * dz;
+        size = 2.0f * node->half_size;
+
+        /*
+         * A node holding the target is always opened, otherwise the target would attract itself.
+         * Checked by the target's place in body_order, bodies may have drifted out of the node's box.
+         */
+        contains_target = ( rank >= node->first_body ) && ( rank < node->first_body + node->body_count );
+
+        if( !contains_target && ( size * size < theta_sq * distance_sq ) )
+        {
+            /* Far enough away, treat the whole node as a point mass */
+            inv_r  = 1.0f / (float_t)sqrt( distance_sq + softening_sq );
+            inv_r3 = node->mass * inv_r * inv_r * inv_r;
+
+            sum_x += dx * inv_r3;
+            sum_y += dy * inv_r3;
+            sum_z += dz * inv_r3;
+        }
+        else if( SIM_OCTREE_NO_CHILDREN == node->first_child )
+        {
+            /* Too close and can't be opened, sum the leaf bodies directly, around the target */
+            if( contains_target )
+            {
+                accumulate_leaf( solver, x, y, z, node->first_body, rank, softening_sq, &sum_x, &sum_y, &sum_z );
+                accumulate_leaf( solver, x, y, z, rank + 1, node->first_body + node->body_count, softening_sq, &sum_x, &sum_y, &sum_z );
+            }
+            else
+            {
+                accumulate_leaf( solver, x, y, z, node->first_body, node->first_body + node->body_count, softening_sq, &sum_x, &sum_y, &sum_z );
+            }
+        }
+        else
+        {
+            /* Too close, open the node */
+            for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+            {
+                stack[stack_size++] = node->first_child + i;
+            }
+        }
+    }
+
+    *ax = sum_x;
+    *ay = sum_y;
+    *az = sum_z;
+}
+
+static void accumulate_leaf
+    (
+        bh_solver_type const  * solver,
+        float_t                 x,
+        float_t                 y,
+        float_t                 z,
+        uint32_t                first,
+        uint32_t                last,
+        float_t                 softening_sq,
+        float_t               * ax,
+        float_t               * ay,
+        float_t               * az
+    )
+{
+    sim_force_sources_type const  * bodies;
+    sim_force_sources_type          predicted;
+    float_t                         predicted_x[BH_PREDICT_CHUNK];
+    float_t                         predicted_y[BH_PREDICT_CHUNK];
+    float_t                         predicted_z[BH_PREDICT_CHUNK];
+    float_t                         time;
+    uint32_t                        count;
+    uint32_t                        i;
+
+    bodies = &solver->tree->sorted;
+
+    if( NULL == solver->prediction )
+    {
+        sim_force_direct_accumulate( bodies, x, y, z, first, last, softening_sq, ax, ay, az );
+        return;
+    }
+
+    /* Predict the run a chunk at a time into the stack, and stream each chunk through the kernel */
+    time                    = solver->prediction->time;
+    predicted.position_x    = predicted_x;
+    predicted.position_y    = predicted_y;
+    predicted.position_z    = predicted_z;
+
+    for( ; first < last; first += count )
+    {
+        count = MIN( last - first, BH_PREDICT_CHUNK );
+
+        for( i = 0; i < count; ++i )
+        {
+            predicted_x[i] = bodies->position_x[first + i] + solver->sorted.velocity_x[first + i] * time;
+            predicted_y[i] = bodies->position_y[first + i] + solver->sorted.velocity_y[first + i] * time;
+            predicted_z[i] = bodies->position_z[first + i] + solver->sorted.velocity_z[first + i] * time;
+        }
+
+        predicted.mass = &bodies->mass[first];
+
+        sim_force_direct_accumulate( &predicted, x, y, z, 0, count, softening_sq, ax, ay, az );
+    }
+}
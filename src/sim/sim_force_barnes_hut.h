@@ -0,0 +1,84 @@
+/**
+ * @file sim_force_barnes_hut.h
+ *
+ * @brief Barnes-Hut octree gravity solver
+ *
+ * The tree is rebuilt from scratch every force pass into a flat node
+ * array that is reused between steps, nodes refer to each other by index.
+ * Block steps build it once per step and refit the node moments as the
+ * active bodies are kicked.
+ */
+#ifndef SIM_FORCE_BARNES_HUT_H
+#define SIM_FORCE_BARNES_HUT_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocate the (initially empty) tree storage
+ */
+void * sim_force_barnes_hut_create
+    (
+        sim_config_type const * config
+    );
+
+/**
+ * @brief Free the tree storage
+ */
+void sim_force_barnes_hut_free
+    (
+        void * state
+    );
+
+/**
+ * @brief Build the octree over the current positions and compute the acceleration of every particle
+ */
+void sim_force_barnes_hut_compute
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+/**
+ * @brief Build the octree once for a block step, with node moments that
+ *        move the centres of mass along with the bodies' velocities
+ */
+void sim_force_barnes_hut_begin_block
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+/**
+ * @brief Compute the acceleration of only the listed particles with the Barnes-Hut method,
+ *        using the block step's tree with every other body predicted to the prediction time
+ */
+void sim_force_barnes_hut_compute_active
+    (
+        sim_type                        * sim,
+        void                            * state,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    );
+
+/**
+ * @brief Refit the moments of the nodes holding the listed particles after they were kicked
+ */
+void sim_force_barnes_hut_update_active
+    (
+        sim_type                        * sim,
+        void                            * state,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    );
+
+#endif /* SIM_FORCE_BARNES_HUT_H */
@@ -0,0 +1,562 @@
+/**
+ * @file sim_force_direct.c
+ *
+ * @brief Implementation of the direct summation gravity solver
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_force_direct.h"
+#include "sim_force_direct_kernel.h"
+#include <math.h>
+#include <stdlib.h>
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+/**
+ * @brief Solver state, positions predicted for block steps
+ */
+typedef struct direct_solver_struct
+{
+    sim_force_sources_type  predicted;  /* The masses point into the particle store */
+    uint32_t                capacity;
+} direct_solver_type;
+
+/**
+ * @brief Arguments of the worker tasks
+ */
+typedef struct target_pass_struct
+{
+    sim_type                      * sim;
+    sim_force_sources_type const  * sources;    /* What the targets are attracted to, indexed like the particle store */
+    uint32_t const                * targets;    /* Indices of the targets, NULL for all of them in order */
+} target_pass_type;
+
+/**
+ * @brief Arguments of the jerk worker tasks
+ */
+typedef struct jerk_pass_struct
+{
+    sim_type  * sim;
+    float_t   * jerk_x;
+    float_t   * jerk_y;
+    float_t   * jerk_z;
+} jerk_pass_type;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Check whether the build and the running CPU support a kernel
+ */
+static boolean kernel_supported
+    (
+        sim_force_direct_kernel_t8 kernel
+    );
+
+/**
+ * @brief Compute the acceleration of a single particle by summing over all others in sources
+ */
+static void compute_target
+    (
+        sim_type const                * sim,
+        sim_force_sources_type const  * sources,
+        uint32_t                        index,
+        float_t                       * ax, /* [out] */
+        float_t                       * ay, /* [out] */
+        float_t                       * az  /* [out] */
+    );
+
+/**
+ * @brief Get the positions and masses of the particle store as kernel sources
+ */
+static void store_sources
+    (
+        particle_store_type const * store,
+        sim_force_sources_type    * sources /* [out] */
+    );
+
+/**
+ * @brief Thread pool task, computes the accelerations of targets [first, last) of the pass
+ */
+static void compute_targets
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    );
+
+/**
+ * @brief Thread pool task, computes the accelerations and jerks of targets [first, last)
+ */
+static void compute_jerk_targets
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    );
+
+/**********************************************************************
+                             VARIABLES
+**********************************************************************/
+
+static sim_force_direct_kernel_cb const kernels[SIM_FORCE_DIRECT_KERNEL_COUNT] =
+{
+    sim_force_direct_accumulate_scalar,
+#ifdef SIM_FORCE_SIMD
+    sim_force_direct_accumulate_avx2,
+    sim_force_direct_accumulate_avx512
+#else
+    NULL,
+    NULL
+#endif
+};
+
+static char const * const kernel_names[SIM_FORCE_DIRECT_KERNEL_COUNT] =
+{
+    "scalar",
+    "avx2",
+    "avx512"
+};
+
+static sim_force_direct_kernel_t8   active_kernel;
+static boolean                      kernel_selected = FALSE;
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void * sim_force_direct_create
+    (
+        sim_config_type const * config
+    )
+{
+    return calloc( 1, sizeof( direct_solver_type ) );
+}
+
+void sim_force_direct_free
+    (
+        void * state
+    )
+{
+    direct_solver_type * solver;
+
+    solver = (direct_solver_type *)state;
+
+    free( solver->predicted.position_x );
+    free( solver->predicted.position_y );
+    free( solver->predicted.position_z );
+    free( solver );
+}
+
+void sim_force_direct_compute
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    sim_force_sources_type  sources;
+    target_pass_type        pass;
+
+    store_sources( sim->particles, &sources );
+
+    pass.sim        = sim;
+    pass.sources    = &sources;
+    pass.targets    = NULL;
+
+    /* Every target only writes its own acceleration, so targets split freely between workers */
+    thread_pool_parallel_for( sim->pool, sim->particles->count, THREAD_POOL_GRAIN_AUTO, compute_targets, &pass );
+}
+
+void sim_force_direct_compute_active
+    (
+        sim_type                        * sim,
+        void                            * state,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    )
+{
+    direct_solver_type    * solver;
+    particle_store_type   * store;
+    target_pass_type        pass;
+    uint32_t                i;
+    float_t                 dt;
+
+    solver  = (direct_solver_type *)state;
+    store   = sim->particles;
+
+    if( store->count > solver->capacity )
+    {
+        free( solver->predicted.position_x );
+        free( solver->predicted.position_y );
+        free( solver->predicted.position_z );
+
+        solver->capacity                = store->count;
+        solver->predicted.position_x    = malloc( store->count * sizeof( float_t ) );
+        solver->predicted.position_y    = malloc( store->count * sizeof( float_t ) );
+        solver->predicted.position_z    = malloc( store->count * sizeof( float_t ) );
+    }
+
+    solver->predicted.mass = store->mass;
+
+    /* Predicting every source is O(N), small next to the O(active N) pass it feeds */
+    for( i = 0; i < store->count; ++i )
+    {
+        dt = prediction->time - prediction->sync_time[i];
+
+        solver->predicted.position_x[i] = store->position_x[i] + store->velocity_x[i] * dt;
+        solver->predicted.position_y[i] = store->position_y[i] + store->velocity_y[i] * dt;
+        solver->predicted.position_z[i] = store->position_z[i] + store->velocity_z[i] * dt;
+    }
+
+    pass.sim        = sim;
+    pass.sources    = &solver->predicted;
+    pass.targets    = active;
+
+    thread_pool_parallel_for( sim->pool, active_count, THREAD_POOL_GRAIN_AUTO, compute_targets, &pass );
+}
+
+static void compute_targets
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    )
+{
+    target_pass_type const    * pass;
+    particle_store_type       * store;
+    uint32_t                    i;
+    uint32_t                    index;
+
+    pass    = (target_pass_type const *)user_data;
+    store   = pass->sim->particles;
+
+    for( i = first; i < last; ++i )
+    {
+        index = ( NULL != pass->targets ) ? pass->targets[i] : i;
+        compute_target( pass->sim, pass->sources, index, &store->acceleration_x[index], &store->acceleration_y[index], &store->acceleration_z[index] );
+    }
+}
+
+void sim_force_direct_compute_jerk
+    (
+        sim_type  * sim,
+        float_t   * jerk_x,
+        float_t   * jerk_y,
+        float_t   * jerk_z
+    )
+{
+    jerk_pass_type pass;
+
+    pass.sim    = sim;
+    pass.jerk_x = jerk_x;
+    pass.jerk_y = jerk_y;
+    pass.jerk_z = jerk_z;
+
+    thread_pool_parallel_for( sim->pool, sim->particles->count, THREAD_POOL_GRAIN_AUTO, compute_jerk_targets, &pass );
+}
+
+static void compute_jerk_targets
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    )
+{
+    jerk_pass_type const  * pass;
+    particle_store_type   * store;
+    uint32_t                i;
+    uint32_t                j;
+    float_t                 g;
+    float_t                 softening_sq;
+    float_t                 dx;
+    float_t                 dy;
+    float_t                 dz;
+    float_t                 dvx;
+    float_t                 dvy;
+    float_t                 dvz;
+    float_t                 inv_r;
+    float_t                 inv_r3;
+    float_t                 rv;
+    float_t                 acc[3];
+    float_t                 jerk[3];
+
+    pass            = (jerk_pass_type const *)user_data;
+    store           = pass->sim->particles;
+    g               = pass->sim->config.gravitational_constant;
+    softening_sq    = pass->sim->config.softening * pass->sim->config.softening;
+
+    for( i = first; i < last; ++i )
+    {
+        acc[0]  = acc[1]  = acc[2]  = 0.0f;
+        jerk[0] = jerk[1] = jerk[2] = 0.0f;
+
+        /* Scalar only, Hermite runs are small N and the jerk term doesn't fit the SIMD kernels */
+        for( j = 0; j < store->count; ++j )
+        {
+            if( j == i )
+            {
+                continue;
+            }
+
+            dx  = store->position_x[j] - store->position_x[i];
+            dy  = store->position_y[j] - store->position_y[i];
+            dz  = store->position_z[j] - store->position_z[i];
+            dvx = store->velocity_x[j] - store->velocity_x[i];
+            dvy = store->velocity_y[j] - store->velocity_y[i];
+            dvz = store->velocity_z[j] - store->velocity_z[i];
+
+            inv_r   = 1.0f / (float_t)sqrt( dx * dx + dy * dy + dz * dz + softening_sq );
+            inv_r3  = store->mass[j] * inv_r * inv_r * inv_r;
+            rv      = 3.0f * ( dx * dvx + dy * dvy + dz * dvz ) * inv_r * inv_r;
+
+            /* a = m r / |r|^3, da/dt = m ( v / |r|^3 - 3 ( r.v ) r / |r|^5 ) */
+            acc[0] += dx * inv_r3;
+            acc[1] += dy * inv_r3;
+            acc[2] += dz * inv_r3;
+
+            jerk[0] += ( dvx - rv * dx ) * inv_r3;
+            jerk[1] += ( dvy - rv * dy ) * inv_r3;
+            jerk[2] += ( dvz - rv * dz ) * inv_r3;
+        }
+
+        store->acceleration_x[i] = g * acc[0];
+        store->acceleration_y[i] = g * acc[1];
+        store->acceleration_z[i] = g * acc[2];
+
+        pass->jerk_x[i] = g * jerk[0];
+        pass->jerk_y[i] = g * jerk[1];
+        pass->jerk_z[i] = g * jerk[2];
+    }
+}
+
+void sim_force_direct_target
+    (
+        sim_type const    * sim,
+        uint32_t            index,
+        float_t           * ax,
+        float_t           * ay,
+        float_t           * az
+    )
+{
+    sim_force_sources_type sources;
+
+    store_sources( sim->particles, &sources );
+    compute_target( sim, &sources, index, ax, ay, az );
+}
+
+static void compute_target
+    (
+        sim_type const                * sim,
+        sim_force_sources_type const  * sources,
+        uint32_t                        index,
+        float_t                       * ax,
+        float_t                       * ay,
+        float_t                       * az
+    )
+{
+    float_t     g;
+    float_t     softening_sq;
+    float_t     x;
+    float_t     y;
+    float_t     z;
+    float_t     sum_x;
+    float_t     sum_y;
+    float_t     sum_z;
+
+    g               = sim->config.gravitational_constant;
+    softening_sq    = sim->config.softening * sim->config.softening;
+
+    x = sources->position_x[index];
+    y = sources->position_y[index];
+    z = sources->position_z[index];
+
+    sum_x = 0.0f;
+    sum_y = 0.0f;
+    sum_z = 0.0f;
+
+    /*
+     * The target gathers from every source into registers, so the inner loop
+     * only streams the source arrays. The self term is skipped by splitting the
+     * source range in two rather than branching inside the loop.
+     */
+    sim_force_direct_accumulate( sources, x, y, z, 0, index, softening_sq, &sum_x, &sum_y, &sum_z );
+    sim_force_direct_accumulate( sources, x, y, z, index + 1, sim->particles->count, softening_sq, &sum_x, &sum_y, &sum_z );
+
+    *ax = sum_x * g;
+    *ay = sum_y * g;
+    *az = sum_z * g;
+}
+
+static void store_sources
+    (
+        particle_store_type const * store,
+        sim_force_sources_type    * sources
+    )
+{
+    sources->position_x = store->position_x;
+    sources->position_y = store->position_y;
+    sources->position_z = store->position_z;
+    sources->mass       = store->mass;
+}
+
+void sim_force_direct_accumulate
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax,
+        float_t                       * ay,
+        float_t                       * az
+    )
+{
+    kernels[sim_force_direct_get_kernel()]( sources, x, y, z, first, last, softening_sq, ax, ay, az );
+}
+
+sim_force_direct_kernel_t8 sim_force_direct_get_kernel
+    (
+        void
+    )
+{
+    sim_force_direct_kernel_t8 kernel;
+
+    if( !kernel_selected )
+    {
+        /* Kernels are listed narrowest to widest */
+        active_kernel = SIM_FORCE_DIRECT_KERNEL_SCALAR;
+
+        for( kernel = SIM_FORCE_DIRECT_KERNEL_SCALAR + 1; kernel < SIM_FORCE_DIRECT_KERNEL_COUNT; ++kernel )
+        {
+            if( kernel_supported( kernel ) )
+            {
+                active_kernel = kernel;
+            }
+        }
+
+        kernel_selected = TRUE;
+    }
+
+    return active_kernel;
+}
+
+boolean sim_force_direct_set_kernel
+    (
+        sim_force_direct_kernel_t8 kernel
+    )
+{
+    if( !kernel_supported( kernel ) )
+    {
+        return FALSE;
+    }
+
+    active_kernel   = kernel;
+    kernel_selected = TRUE;
+
+    return TRUE;
+}
+
+char const * sim_force_direct_kernel_name
+    (
+        sim_force_direct_kernel_t8 kernel
+    )
+{
+    return ( kernel < SIM_FORCE_DIRECT_KERNEL_COUNT ) ? kernel_names[kernel] : "unknown";
+}
+
+static boolean kernel_supported
+    (
+        sim_force_direct_kernel_t8 kernel
+    )
+{
+    if( ( kernel >= SIM_FORCE_DIRECT_KERNEL_COUNT ) || ( NULL == kernels[kernel] ) )
+    {
+        return FALSE;
+    }
+
+#ifdef SIM_FORCE_SIMD
+    /* Checks CPUID, and XGETBV for the OS saving the wider registers */
+    __builtin_cpu_init();
+
+    switch( kernel )
+    {
+    case SIM_FORCE_DIRECT_KERNEL_AVX2:
+        return ( 0 != __builtin_cpu_supports( "avx2" ) ) && ( 0 != __builtin_cpu_supports( "fma" ) );
+    case SIM_FORCE_DIRECT_KERNEL_AVX512:
+        return ( 0 != __builtin_cpu_supports( "avx512f" ) );
+    default:
+        break;
+    }
+#endif
+
+    return TRUE;
+}
+
+void sim_force_direct_accumulate_scalar
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax,
+        float_t                       * ay,
+        float_t                       * az
+    )
+{
+    float_t const * position_x;
+    float_t const * position_y;
+    float_t const * position_z;
+    float_t const * mass;
+    uint32_t        j;
+    float_t         dx;
+    float_t         dy;
+    float_t         dz;
+    float_t         inv_r;
+    float_t         inv_r3;
+    float_t         sum_x;
+    float_t         sum_y;
+    float_t         sum_z;
+
+    position_x  = sources->position_x;
+    position_y  = sources->position_y;
+    position_z  = sources->position_z;
+    mass        = sources->mass;
+
+    sum_x = 0.0f;
+    sum_y = 0.0f;
+    sum_z = 0.0f;
+
+    for( j = first; j < last; ++j )
+    {
+        dx = position_x[j] - x;
+        dy = position_y[j] - y;
+        dz = position_z[j] - z;
+
+        inv_r  = 1.0f / (float_t)sqrt( dx * dx + dy * dy + dz * dz + softening_sq );
+        inv_r3 = mass[j] * inv_r * inv_r * inv_r;
+
+        sum_x += dx * inv_r3;
+        sum_y += dy * inv_r3;
+        sum_z += dz * inv_r3;
+    }
+
+    *ax += sum_x;
+    *ay += sum_y;
+    *az += sum_z;
+}
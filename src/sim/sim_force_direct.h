@@ -0,0 +1,141 @@
+/**
+ * @file sim_force_direct.h
+ *
+ * @brief Direct summation gravity solver
+ */
+#ifndef SIM_FORCE_DIRECT_H
+#define SIM_FORCE_DIRECT_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/**
+ * @brief Implementations of the direct summation inner loop
+ */
+typedef uint8_t sim_force_direct_kernel_t8; enum
+{
+    SIM_FORCE_DIRECT_KERNEL_SCALAR,     /* Portable reference, always available */
+    SIM_FORCE_DIRECT_KERNEL_AVX2,       /* 8 lanes, rsqrt with a Newton step, needs AVX2 and FMA */
+    SIM_FORCE_DIRECT_KERNEL_AVX512,     /* 16 lanes, rsqrt14 with a Newton step, needs AVX-512F */
+
+    SIM_FORCE_DIRECT_KERNEL_COUNT
+};
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocate the (initially empty) storage for predicted positions
+ */
+void * sim_force_direct_create
+    (
+        sim_config_type const * config
+    );
+
+/**
+ * @brief Free the predicted position storage
+ */
+void sim_force_direct_free
+    (
+        void * state
+    );
+
+/**
+ * @brief Compute the acceleration of every particle by summing over all pairs
+ */
+void sim_force_direct_compute
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+/**
+ * @brief Compute the acceleration of only the listed particles by summing over all pairs,
+ *        with every source predicted to the prediction time
+ */
+void sim_force_direct_compute_active
+    (
+        sim_type                        * sim,
+        void                            * state,
+        uint32_t const                  * active,
+        uint32_t                          active_count,
+        sim_force_prediction_type const * prediction
+    );
+
+/**
+ * @brief Compute the acceleration of every particle and its time derivative
+ *        (jerk) by summing over all pairs, for the Hermite integrator
+ */
+void sim_force_direct_compute_jerk
+    (
+        sim_type  * sim,
+        float_t   * jerk_x, /* [out] count values */
+        float_t   * jerk_y, /* [out] count values */
+        float_t   * jerk_z  /* [out] count values */
+    );
+
+/**
+ * @brief Compute the acceleration of a single particle by summing over all others
+ */
+void sim_force_direct_target
+    (
+        sim_type const    * sim,
+        uint32_t            index,
+        float_t           * ax, /* [out] */
+        float_t           * ay, /* [out] */
+        float_t           * az  /* [out] */
+    );
+
+/**
+ * @brief Add the (unscaled by G) acceleration at x, y, z due to sources [first, last)
+ */
+void sim_force_direct_accumulate
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax, /* [in/out] */
+        float_t                       * ay, /* [in/out] */
+        float_t                       * az  /* [in/out] */
+    );
+
+/**
+ * @brief Get the kernel used by sim_force_direct_accumulate, the fastest one
+ *        the build and CPU support is picked on first use.
+ */
+sim_force_direct_kernel_t8 sim_force_direct_get_kernel
+    (
+        void
+    );
+
+/**
+ * @brief Force a kernel, e.g. to compare against the scalar reference
+ *
+ * @return FALSE and leave the kernel unchanged if the build or CPU doesn't support it
+ */
+boolean sim_force_direct_set_kernel
+    (
+        sim_force_direct_kernel_t8 kernel
+    );
+
+/**
+ * @brief Get a printable name of a kernel
+ */
+char const * sim_force_direct_kernel_name
+    (
+        sim_force_direct_kernel_t8 kernel
+    );
+
+#endif /* SIM_FORCE_DIRECT_H */
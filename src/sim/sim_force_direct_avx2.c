@@ -0,0 +1,120 @@
+/**
+ * @file sim_force_direct_avx2.c
+ *
+ * @brief AVX2 + FMA direct summation kernel, built with -mavx2 -mfma
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_force_direct_kernel.h"
+#include <immintrin.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define AVX2_LANES  ( 8 )
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Add up the lanes of a register
+ */
+static float_t horizontal_sum
+    (
+        __m256 value
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void sim_force_direct_accumulate_avx2
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax,
+        float_t                       * ay,
+        float_t                       * az
+    )
+{
+    __m256      target_x;
+    __m256      target_y;
+    __m256      target_z;
+    __m256      softening;
+    __m256      half;
+    __m256      three_halves;
+    __m256      dx;
+    __m256      dy;
+    __m256      dz;
+    __m256      distance_sq;
+    __m256      inv_r;
+    __m256      inv_r3;
+    __m256      sum_x;
+    __m256      sum_y;
+    __m256      sum_z;
+    uint32_t    j;
+
+    target_x        = _mm256_set1_ps( x );
+    target_y        = _mm256_set1_ps( y );
+    target_z        = _mm256_set1_ps( z );
+    softening       = _mm256_set1_ps( softening_sq );
+    half            = _mm256_set1_ps( 0.5f );
+    three_halves    = _mm256_set1_ps( 1.5f );
+
+    sum_x = _mm256_setzero_ps();
+    sum_y = _mm256_setzero_ps();
+    sum_z = _mm256_setzero_ps();
+
+    /* The range can start anywhere, so the loads are unaligned */
+    for( j = first; j + AVX2_LANES <= last; j += AVX2_LANES )
+    {
+        dx = _mm256_sub_ps( _mm256_loadu_ps( &sources->position_x[j] ), target_x );
+        dy = _mm256_sub_ps( _mm256_loadu_ps( &sources->position_y[j] ), target_y );
+        dz = _mm256_sub_ps( _mm256_loadu_ps( &sources->position_z[j] ), target_z );
+
+        distance_sq = _mm256_fmadd_ps( dx, dx, softening );
+        distance_sq = _mm256_fmadd_ps( dy, dy, distance_sq );
+        distance_sq = _mm256_fmadd_ps( dz, dz, distance_sq );
+
+        /* rsqrt is good to 12 bits, one Newton step y' = y * ( 1.5 - 0.5 * d * y * y ) brings it to ~23 */
+        inv_r = _mm256_rsqrt_ps( distance_sq );
+        inv_r = _mm256_mul_ps( inv_r, _mm256_fnmadd_ps( _mm256_mul_ps( half, distance_sq ), _mm256_mul_ps( inv_r, inv_r ), three_halves ) );
+
+        inv_r3 = _mm256_mul_ps( _mm256_mul_ps( inv_r, inv_r ), _mm256_mul_ps( inv_r, _mm256_loadu_ps( &sources->mass[j] ) ) );
+
+        sum_x = _mm256_fmadd_ps( dx, inv_r3, sum_x );
+        sum_y = _mm256_fmadd_ps( dy, inv_r3, sum_y );
+        sum_z = _mm256_fmadd_ps( dz, inv_r3, sum_z );
+    }
+
+    *ax += horizontal_sum( sum_x );
+    *ay += horizontal_sum( sum_y );
+    *az += horizontal_sum( sum_z );
+
+    /* Less than one register of sources left */
+    sim_force_direct_accumulate_scalar( sources, x, y, z, j, last, softening_sq, ax, ay, az );
+}
+
+static float_t horizontal_sum
+    (
+        __m256 value
+    )
+{
+    __m128 sum;
+
+    sum = _mm_add_ps( _mm256_castps256_ps128( value ), _mm256_extractf128_ps( value, 1 ) );
+    sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+    sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+
+    return _mm_cvtss_f32( sum );
+}
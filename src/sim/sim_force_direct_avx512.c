@@ -0,0 +1,100 @@
+/**
+ * @file sim_force_direct_avx512.c
+ *
+ * @brief AVX-512F direct summation kernel, built with -mavx512f
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_force_direct_kernel.h"
+#include <immintrin.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define AVX512_LANES    ( 16 )
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void sim_force_direct_accumulate_avx512
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax,
+        float_t                       * ay,
+        float_t                       * az
+    )
+{
+    __m512      target_x;
+    __m512      target_y;
+    __m512      target_z;
+    __m512      softening;
+    __m512      half;
+    __m512      three_halves;
+    __m512      dx;
+    __m512      dy;
+    __m512      dz;
+    __m512      distance_sq;
+    __m512      inv_r;
+    __m512      inv_r3;
+    __m512      sum_x;
+    __m512      sum_y;
+    __m512      sum_z;
+    __mmask16   mask;
+    uint32_t    j;
+
+    if( first >= last )
+    {
+        return;
+    }
+
+    target_x        = _mm512_set1_ps( x );
+    target_y        = _mm512_set1_ps( y );
+    target_z        = _mm512_set1_ps( z );
+    softening       = _mm512_set1_ps( softening_sq );
+    half            = _mm512_set1_ps( 0.5f );
+    three_halves    = _mm512_set1_ps( 1.5f );
+
+    sum_x = _mm512_setzero_ps();
+    sum_y = _mm512_setzero_ps();
+    sum_z = _mm512_setzero_ps();
+
+    /* Full registers, then the remainder with masked loads rather than a scalar tail */
+    for( j = first; j < last; j += AVX512_LANES )
+    {
+        mask = ( last - j >= AVX512_LANES ) ? (__mmask16)0xFFFF : (__mmask16)( ( 1u << ( last - j ) ) - 1u );
+
+        dx = _mm512_sub_ps( _mm512_maskz_loadu_ps( mask, &sources->position_x[j] ), target_x );
+        dy = _mm512_sub_ps( _mm512_maskz_loadu_ps( mask, &sources->position_y[j] ), target_y );
+        dz = _mm512_sub_ps( _mm512_maskz_loadu_ps( mask, &sources->position_z[j] ), target_z );
+
+        distance_sq = _mm512_fmadd_ps( dx, dx, softening );
+        distance_sq = _mm512_fmadd_ps( dy, dy, distance_sq );
+        distance_sq = _mm512_fmadd_ps( dz, dz, distance_sq );
+
+        /* rsqrt14 is good to 14 bits, one Newton step brings it to full single precision */
+        inv_r = _mm512_rsqrt14_ps( distance_sq );
+        inv_r = _mm512_mul_ps( inv_r, _mm512_fnmadd_ps( _mm512_mul_ps( half, distance_sq ), _mm512_mul_ps( inv_r, inv_r ), three_halves ) );
+
+        /* Masked lanes are zeroed rather than relying on zero mass, their distance may be zero */
+        inv_r3 = _mm512_maskz_mul_ps( mask, _mm512_mul_ps( inv_r, inv_r ), _mm512_mul_ps( inv_r, _mm512_maskz_loadu_ps( mask, &sources->mass[j] ) ) );
+
+        sum_x = _mm512_fmadd_ps( dx, inv_r3, sum_x );
+        sum_y = _mm512_fmadd_ps( dy, inv_r3, sum_y );
+        sum_z = _mm512_fmadd_ps( dz, inv_r3, sum_z );
+    }
+
+    *ax += _mm512_reduce_add_ps( sum_x );
+    *ay += _mm512_reduce_add_ps( sum_y );
+    *az += _mm512_reduce_add_ps( sum_z );
+}
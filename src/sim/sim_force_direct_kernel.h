@@ -0,0 +1,91 @@
+/**
+ * @file sim_force_direct_kernel.h
+ *
+ * @brief Instruction set specific implementations of the direct summation
+ *        inner loop, only sim_force_direct.c should call these.
+ *
+ * Each kernel lives in its own translation unit so the makefile can build
+ * it with the matching -m flags while the rest of the program stays
+ * baseline x86. They are only built when SIM_FORCE_SIMD is defined.
+ */
+#ifndef SIM_FORCE_DIRECT_KERNEL_H
+#define SIM_FORCE_DIRECT_KERNEL_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/**
+ * @brief Add the (unscaled by G) acceleration at x, y, z due to sources [first, last)
+ */
+typedef void (*sim_force_direct_kernel_cb)
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax, /* [in/out] */
+        float_t                       * ay, /* [in/out] */
+        float_t                       * az  /* [in/out] */
+    );
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+void sim_force_direct_accumulate_scalar
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax,
+        float_t                       * ay,
+        float_t                       * az
+    );
+
+#ifdef SIM_FORCE_SIMD
+
+void sim_force_direct_accumulate_avx2
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax,
+        float_t                       * ay,
+        float_t                       * az
+    );
+
+void sim_force_direct_accumulate_avx512
+    (
+        sim_force_sources_type const  * sources,
+        float_t                         x,
+        float_t                         y,
+        float_t                         z,
+        uint32_t                        first,
+        uint32_t                        last,
+        float_t                         softening_sq,
+        float_t                       * ax,
+        float_t                       * ay,
+        float_t                       * az
+    );
+
+#endif /* SIM_FORCE_SIMD */
+
+#endif /* SIM_FORCE_DIRECT_KERNEL_H */
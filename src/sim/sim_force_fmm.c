@@ -0,0 +1,1253 @@
+/**
+ * @file sim_force_fmm.c
+ *
+ * @brief Implementation of the fast multipole method gravity solver
+ *
+ * Notation: multi-indices n = ( nx, ny, nz ) with |n| = nx + ny + nz <= order,
+ * y^n = y.x^nx * y.y^ny * y.z^nz and C( n, k ) is the product of the
+ * binomial coefficients of each component.
+ *
+ * Multipole of node A about its centre c:  M_n = sum_j m_j ( x_j - c )^n
+ * Potential outside A:                     phi( x ) = sum_n ( -1 )^|n| M_n b_n( x - c )
+ * Local expansion of node B about c:       phi( c + r ) = sum_n L_n r^n
+ *
+ * where b_n( R ) = D^n( 1 / |R| ) / n! follows the recurrence
+ * |n| R^2 b_n = -( 2|n| - 1 ) sum_i R_i b_{n - e_i} - ( |n| - 1 ) sum_i b_{n - 2e_i}
+ *
+ * The recurrence only depends on the kernel being a function of R^2, so the
+ * Plummer softened kernel 1 / sqrt( R^2 + eps^2 ) is expanded by replacing
+ * R^2 with R^2 + eps^2, which keeps the far field consistent with the near field.
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_force_fmm.h"
+#include "sim_force_direct.h"
+#include "sim_octree.h"
+#include "common_util.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+/* Number of multi-indices with |n| <= SIM_FORCE_FMM_MAX_ORDER */
+#define FMM_MAX_TERMS       ( ( SIM_FORCE_FMM_MAX_ORDER + 1 ) * ( SIM_FORCE_FMM_MAX_ORDER + 2 ) * ( SIM_FORCE_FMM_MAX_ORDER + 3 ) / 6 )
+#define FMM_NO_TERM         ( 0xFFFF )
+#define FMM_AXIS_COUNT      ( 3 )
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+/**
+ * @brief One multi-index and the terms it is built from by recurrence
+ */
+typedef struct fmm_term_struct
+{
+    uint8_t     exponent[FMM_AXIS_COUNT];
+    uint8_t     degree;
+    uint16_t    less_one[FMM_AXIS_COUNT];   /* Index of n - e_i, FMM_NO_TERM if n_i < 1 */
+    uint16_t    less_two[FMM_AXIS_COUNT];   /* Index of n - 2e_i, FMM_NO_TERM if n_i < 2 */
+} fmm_term_type;
+
+/**
+ * @brief out[to] += coefficient * in[from] * power[power]
+ *        Used for both multipole (M2M) and local (L2L) shifts.
+ */
+typedef struct fmm_shift_struct
+{
+    uint16_t    to;
+    uint16_t    from;
+    uint16_t    power;
+    double_t    coefficient;
+} fmm_shift_type;
+
+/**
+ * @brief L_B[local] += coefficient * M_A[multipole] * b[derivative] and
+ *        L_A[local] += reverse_coefficient * M_B[multipole] * b[derivative]
+ *        where b is evaluated at R = c_B - c_A, using b_n( -R ) = ( -1 )^|n| b_n( R )
+ */
+typedef struct fmm_translation_struct
+{
+    uint16_t    local;
+    uint16_t    multipole;
+    uint16_t    derivative;
+    double_t    coefficient;
+    double_t    reverse_coefficient;
+} fmm_translation_type;
+
+/**
+ * @brief Two nodes that interact
+ */
+typedef struct fmm_pair_struct
+{
+    uint32_t    a;
+    uint32_t    b;
+} fmm_pair_type;
+
+/**
+ * @brief Interaction partners of every node in compressed rows,
+ *        node n interacts with partners[first[n], first[n + 1])
+ */
+typedef struct fmm_partner_list_struct
+{
+    uint32_t  * first;
+    uint32_t  * partners;
+    uint32_t    node_capacity;
+    uint32_t    partner_capacity;
+} fmm_partner_list_type;
+
+/**
+ * @brief Solver state, all storage is reused between steps
+ */
+typedef struct fmm_solver_struct
+{
+    sim_octree_type       * tree;
+    float_t                 opening_angle;
+    uint32_t                leaf_capacity;
+    uint32_t                term_count;
+    fmm_term_type           terms[FMM_MAX_TERMS];
+    vector_type           * m2m_shifts;     /* fmm_shift_type */
+    vector_type           * l2l_shifts;     /* fmm_shift_type */
+    vector_type           * m2l_terms;      /* fmm_translation_type */
+    double_t              * multipoles;     /* term_count coefficients per node */
+    double_t              * locals;         /* term_count coefficients per node */
+    uint32_t                expansion_capacity; /* Number of nodes the expansion arrays can hold */
+    vector_type           * m2l_pairs;      /* fmm_pair_type, well separated nodes */
+    vector_type           * p2p_pairs;      /* fmm_pair_type, neighbouring leaves */
+    fmm_partner_list_type   m2l_partners;   /* Only built when the pass runs on several workers */
+    fmm_partner_list_type   p2p_partners;
+    sim_type              * sim;            /* Set for the duration of a force pass, for the worker tasks */
+} fmm_solver_type;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Enumerate the multi-indices and build the translation tables
+ */
+static void build_tables
+    (
+        fmm_solver_type   * solver,
+        uint8_t             order
+    );
+
+/**
+ * @brief Find the index of a multi-index, FMM_NO_TERM if out of range
+ */
+static uint16_t find_term
+    (
+        fmm_solver_type const * solver,
+        sint32_t                x,
+        sint32_t                y,
+        sint32_t                z
+    );
+
+/**
+ * @brief Compute y^n for every term
+ */
+static void compute_powers
+    (
+        fmm_solver_type const * solver,
+        double_t                x,
+        double_t                y,
+        double_t                z,
+        double_t              * powers /* [out] term_count values */
+    );
+
+/**
+ * @brief Compute b_n( R ) of the softened kernel for every term
+ */
+static void compute_derivatives
+    (
+        fmm_solver_type const * solver,
+        double_t                x,
+        double_t                y,
+        double_t                z,
+        double_t                softening_sq,
+        double_t              * derivatives /* [out] term_count values */
+    );
+
+/**
+ * @brief Thread pool task, forms the multipoles of the leaves among nodes [first, last) (P2M)
+ */
+static void leaf_multipoles
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    );
+
+/**
+ * @brief Shift multipoles up the tree (M2M)
+ */
+static void upward_pass
+    (
+        fmm_solver_type * solver
+    );
+
+/**
+ * @brief Dual tree traversal, records every unordered pair of interacting nodes once
+ */
+static void interact
+    (
+        fmm_solver_type   * solver,
+        uint32_t            a,
+        uint32_t            b
+    );
+
+/**
+ * @brief Evaluate the recorded interactions, once per pair on a single
+ *        worker or node by node on several
+ */
+static void evaluate_interactions
+    (
+        fmm_solver_type * solver
+    );
+
+/**
+ * @brief Group the pairs by node
+ */
+static void build_partner_list
+    (
+        fmm_partner_list_type * list,
+        vector_type           * pairs,
+        uint32_t                node_count
+    );
+
+/**
+ * @brief Thread pool task, evaluates every interaction of nodes [first, last)
+ *        on those nodes only
+ */
+static void evaluate_nodes
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    );
+
+/**
+ * @brief Translate the multipole of a into the local expansion of b (M2L),
+ *        and the multipole of b into the local expansion of a if mutual
+ */
+static void multipole_to_local
+    (
+        fmm_solver_type   * solver,
+        uint32_t            a,
+        uint32_t            b,
+        float_t             softening_sq,
+        boolean             mutual
+    );
+
+/**
+ * @brief Sum the (unscaled by G) accelerations of the bodies of leaf a due
+ *        to the bodies of leaf b directly (P2P), and of b due to a if mutual.
+ *        a and b may be the same leaf.
+ */
+static void particle_to_particle
+    (
+        fmm_solver_type const * solver,
+        particle_store_type   * store,
+        uint32_t                a,
+        uint32_t                b,
+        float_t                 softening_sq,
+        boolean                 mutual
+    );
+
+/**
+ * @brief Shift local expansions down the tree (L2L)
+ */
+static void downward_pass
+    (
+        fmm_solver_type * solver
+    );
+
+/**
+ * @brief Thread pool task, evaluates the local expansions of the leaves among
+ *        nodes [first, last) at their bodies (L2P) and applies G
+ */
+static void leaf_accelerations
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void * sim_force_fmm_create
+    (
+        sim_config_type const * config
+    )
+{
+    fmm_solver_type * solver;
+
+    solver = calloc( 1, sizeof( fmm_solver_type ) );
+
+    solver->tree            = sim_octree_create();
+    solver->opening_angle   = config->opening_angle;
+    solver->leaf_capacity   = config->leaf_capacity;
+    solver->m2m_shifts      = vector_init( sizeof( fmm_shift_type ) );
+    solver->l2l_shifts      = vector_init( sizeof( fmm_shift_type ) );
+    solver->m2l_terms       = vector_init( sizeof( fmm_translation_type ) );
+    solver->m2l_pairs       = vector_init( sizeof( fmm_pair_type ) );
+    solver->p2p_pairs       = vector_init( sizeof( fmm_pair_type ) );
+
+    build_tables( solver, MAX( 1, MIN( config->expansion_order, SIM_FORCE_FMM_MAX_ORDER ) ) );
+
+    return solver;
+}
+
+void sim_force_fmm_free
+    (
+        void * state
+    )
+{
+    fmm_solver_type * solver;
+
+    solver = (fmm_solver_type *)state;
+
+    sim_octree_free( solver->tree );
+    vector_deinit( solver->m2m_shifts );
+    vector_deinit( solver->l2l_shifts );
+    vector_deinit( solver->m2l_terms );
+    vector_deinit( solver->m2l_pairs );
+    vector_deinit( solver->p2p_pairs );
+    free( solver->m2l_partners.first );
+    free( solver->m2l_partners.partners );
+    free( solver->p2p_partners.first );
+    free( solver->p2p_partners.partners );
+    free( solver->multipoles );
+    free( solver->locals );
+    free( solver );
+}
+
+void sim_force_fmm_compute
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    fmm_solver_type * solver;
+
+    solver = (fmm_solver_type *)state;
+
+    if( 0 == sim->particles->count )
+    {
+        return;
+    }
+
+    sim_octree_build( solver->tree, sim->particles, solver->leaf_capacity );
+
+    /* Size the expansion storage to the tree */
+    if( solver->tree->node_count > solver->expansion_capacity )
+    {
+        free( solver->multipoles );
+        free( solver->locals );
+
+        solver->expansion_capacity  = solver->tree->node_capacity;
+        solver->multipoles          = malloc( solver->expansion_capacity * solver->term_count * sizeof( double_t ) );
+        solver->locals              = malloc( solver->expansion_capacity * solver->term_count * sizeof( double_t ) );
+    }
+
+    memset( solver->locals, 0, solver->tree->node_count * solver->term_count * sizeof( double_t ) );
+
+    /* Leaf work runs on every worker, the sweeps between levels and the traversal are cheap and stay serial */
+    solver->sim = sim;
+
+    thread_pool_parallel_for( sim->pool, solver->tree->node_count, THREAD_POOL_GRAIN_AUTO, leaf_multipoles, solver );
+    upward_pass( solver );
+
+    vector_empty( solver->m2l_pairs );
+    vector_empty( solver->p2p_pairs );
+    interact( solver, 0, 0 );
+    evaluate_interactions( solver );
+
+    downward_pass( solver );
+    thread_pool_parallel_for( sim->pool, solver->tree->node_count, THREAD_POOL_GRAIN_AUTO, leaf_accelerations, solver );
+
+    solver->sim = NULL;
+}
+
+static void build_tables
+    (
+        fmm_solver_type   * solver,
+        uint8_t             order
+    )
+{
+    double_t                binomial[2 * SIM_FORCE_FMM_MAX_ORDER + 1][2 * SIM_FORCE_FMM_MAX_ORDER + 1];
+    uint32_t                degree;
+    uint32_t                x;
+    uint32_t                y;
+    uint32_t                n;
+    uint32_t                k;
+    uint32_t                axis;
+    fmm_term_type         * term;
+    fmm_term_type const   * from;
+    fmm_term_type const   * to;
+    fmm_shift_type          shift;
+    fmm_translation_type    translation;
+    boolean                 below;
+
+    /* Pascal's triangle */
+    memset( binomial, 0, sizeof( binomial ) );
+    for( n = 0; n <= 2 * SIM_FORCE_FMM_MAX_ORDER; ++n )
+    {
+        binomial[n][0] = 1.0;
+        for( k = 1; k <= n; ++k )
+        {
+            binomial[n][k] = binomial[n - 1][k - 1] + binomial[n - 1][k];
+        }
+    }
+
+    /* Enumerate multi-indices in order of degree, so every recurrence only refers to earlier terms */
+    solver->term_count = 0;
+    for( degree = 0; degree <= order; ++degree )
+    {
+        for( x = degree + 1; x > 0; --x )
+        {
+            for( y = degree - ( x - 1 ) + 1; y > 0; --y )
+            {
+                term = &solver->terms[solver->term_count++];
+
+                term->exponent[0]   = x - 1;
+                term->exponent[1]   = y - 1;
+                term->exponent[2]   = degree - ( x - 1 ) - ( y - 1 );
+                term->degree        = degree;
+            }
+        }
+    }
+
+    for( n = 0; n < solver->term_count; ++n )
+    {
+        term = &solver->terms[n];
+
+        for( axis = 0; axis < FMM_AXIS_COUNT; ++axis )
+        {
+            term->less_one[axis] = find_term
+                (
+                    solver,
+                    term->exponent[0] - ( 0 == axis ? 1 : 0 ),
+                    term->exponent[1] - ( 1 == axis ? 1 : 0 ),
+                    term->exponent[2] - ( 2 == axis ? 1 : 0 )
+                );
+
+            term->less_two[axis] = find_term
+                (
+                    solver,
+                    term->exponent[0] - ( 0 == axis ? 2 : 0 ),
+                    term->exponent[1] - ( 1 == axis ? 2 : 0 ),
+                    term->exponent[2] - ( 2 == axis ? 2 : 0 )
+                );
+        }
+    }
+
+    /*
+     * Shifts between pairs with k <= n componentwise:
+     * M2M  M'_n += C( n, k ) M_k d^( n - k )
+     * L2L  L'_k += C( n, k ) L_n e^( n - k )
+     */
+    for( n = 0; n < solver->term_count; ++n )
+    {
+        for( k = 0; k < solver->term_count; ++k )
+        {
+            to   = &solver->terms[n];
+            from = &solver->terms[k];
+
+            below = TRUE;
+            for( axis = 0; axis < FMM_AXIS_COUNT; ++axis )
+            {
+                below = below && ( from->exponent[axis] <= to->exponent[axis] );
+            }
+
+            if( !below )
+            {
+                continue;
+            }
+
+            shift.power = find_term
+                (
+                    solver,
+                    to->exponent[0] - from->exponent[0],
+                    to->exponent[1] - from->exponent[1],
+                    to->exponent[2] - from->exponent[2]
+                );
+
+            shift.coefficient = binomial[to->exponent[0]][from->exponent[0]] *
+                                binomial[to->exponent[1]][from->exponent[1]] *
+                                binomial[to->exponent[2]][from->exponent[2]];
+
+            shift.to    = n;
+            shift.from  = k;
+            vector_push_back( solver->m2m_shifts, &shift );
+
+            shift.to    = k;
+            shift.from  = n;
+            vector_push_back( solver->l2l_shifts, &shift );
+        }
+    }
+
+    /*
+     * M2L  L_k += ( -1 )^|m| C( m + k, m ) M_m b_( m + k ), truncated at |m| + |k| <= order
+     * The reverse direction flips R, which multiplies by ( -1 )^( |m| + |k| )
+     */
+    for( k = 0; k < solver->term_count; ++k )
+    {
+        for( n = 0; n < solver->term_count; ++n )
+        {
+            to   = &solver->terms[k];
+            from = &solver->terms[n];
+
+            if( to->degree + from->degree > order )
+            {
+                continue;
+            }
+
+            translation.local       = k;
+            translation.multipole   = n;
+            translation.derivative  = find_term
+                (
+                    solver,
+                    to->exponent[0] + from->exponent[0],
+                    to->exponent[1] + from->exponent[1],
+                    to->exponent[2] + from->exponent[2]
+                );
+
+            translation.coefficient = ( ( from->degree % 2 ) ? -1.0 : 1.0 ) *
+                                      binomial[to->exponent[0] + from->exponent[0]][from->exponent[0]] *
+                                      binomial[to->exponent[1] + from->exponent[1]][from->exponent[1]] *
+                                      binomial[to->exponent[2] + from->exponent[2]][from->exponent[2]];
+
+            translation.reverse_coefficient = ( ( ( from->degree + to->degree ) % 2 ) ? -1.0 : 1.0 ) * translation.coefficient;
+
+            vector_push_back( solver->m2l_terms, &translation );
+        }
+    }
+}
+
+static uint16_t find_term
+    (
+        fmm_solver_type const * solver,
+        sint32_t                x,
+        sint32_t                y,
+        sint32_t                z
+    )
+{
+    uint32_t i;
+
+    if( ( x < 0 ) || ( y < 0 ) || ( z < 0 ) )
+    {
+        return FMM_NO_TERM;
+    }
+
+    /* Only used while building tables, a linear search is fine */
+    for( i = 0; i < solver->term_count; ++i )
+    {
+        if( ( solver->terms[i].exponent[0] == x ) &&
+            ( solver->terms[i].exponent[1] == y ) &&
+            ( solver->terms[i].exponent[2] == z ) )
+        {
+            return i;
+        }
+    }
+
+    return FMM_NO_TERM;
+}
+
+static void compute_powers
+    (
+        fmm_solver_type const * solver,
+        double_t                x,
+        double_t                y,
+        double_t                z,
+        double_t              * powers
+    )
+{
+    uint32_t                n;
+    fmm_term_type const   * term;
+
+    powers[0] = 1.0;
+
+    for( n = 1; n < solver->term_count; ++n )
+    {
+        term = &solver->terms[n];
+
+        if( FMM_NO_TERM != term->less_one[0] )
+        {
+            powers[n] = powers[term->less_one[0]] * x;
+        }
+        else if( FMM_NO_TERM != term->less_one[1] )
+        {
+            powers[n] = powers[term->less_one[1]] * y;
+        }
+        else
+        {
+            powers[n] = powers[term->less_one[2]] * z;
+        }
+    }
+}
+
+static void compute_derivatives
+    (
+        fmm_solver_type const * solver,
+        double_t                x,
+        double_t                y,
+        double_t                z,
+        double_t                softening_sq,
+        double_t              * derivatives
+    )
+{
+    uint32_t                n;
+    uint32_t                axis;
+    fmm_term_type const   * term;
+    double_t                axis_distance[FMM_AXIS_COUNT];
+    double_t                distance_sq;
+    double_t                first;
+    double_t                second;
+
+    axis_distance[0] = x;
+    axis_distance[1] = y;
+    axis_distance[2] = z;
+    distance_sq = x * x + y * y + z * z + softening_sq;
+
+    derivatives[0] = 1.0 / sqrt( distance_sq );
+
+    for( n = 1; n < solver->term_count; ++n )
+    {
+        term = &solver->terms[n];
+
+        first  = 0.0;
+        second = 0.0;
+
+        for( axis = 0; axis < FMM_AXIS_COUNT; ++axis )
+        {
+            if( FMM_NO_TERM != term->less_one[axis] )
+            {
+                first += axis_distance[axis] * derivatives[term->less_one[axis]];
+            }
+
+            if( FMM_NO_TERM != term->less_two[axis] )
+            {
+                second += derivatives[term->less_two[axis]];
+            }
+        }
+
+        derivatives[n] = -( ( 2.0 * term->degree - 1.0 ) * first + ( term->degree - 1.0 ) * second ) / ( term->degree * distance_sq );
+    }
+}
+
+static void leaf_multipoles
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    )
+{
+    fmm_solver_type               * solver;
+    particle_store_type           * store;
+    sim_octree_node_type const    * node;
+    double_t                        powers[FMM_MAX_TERMS];
+    double_t                      * multipole;
+    uint32_t                        node_index;
+    uint32_t                        i;
+    uint32_t                        t;
+    uint32_t                        body;
+
+    solver  = (fmm_solver_type *)user_data;
+    store   = solver->sim->particles;
+
+    for( node_index = first; node_index < last; ++node_index )
+    {
+        node = &solver->tree->nodes[node_index];
+
+        if( ( SIM_OCTREE_NO_CHILDREN != node->first_child ) || ( 0 == node->body_count ) )
+        {
+            continue;
+        }
+
+        multipole = &solver->multipoles[node_index * solver->term_count];
+        memset( multipole, 0, solver->term_count * sizeof( double_t ) );
+
+        for( i = node->first_body; i < node->first_body + node->body_count; ++i )
+        {
+            body = solver->tree->body_order[i];
+
+            /* Every body is in exactly one leaf, so this is where its acceleration is cleared */
+            store->acceleration_x[body] = 0.0f;
+            store->acceleration_y[body] = 0.0f;
+            store->acceleration_z[body] = 0.0f;
+
+            compute_powers
+                (
+                    solver,
+                    store->position_x[body] - node->com_x,
+                    store->position_y[body] - node->com_y,
+                    store->position_z[body] - node->com_z,
+                    powers
+                );
+
+            for( t = 0; t < solver->term_count; ++t )
+            {
+                multipole[t] += store->mass[body] * powers[t];
+            }
+        }
+    }
+}
+
+static void upward_pass
+    (
+        fmm_solver_type * solver
+    )
+{
+    sim_octree_node_type const    * node;
+    sim_octree_node_type const    * child;
+    fmm_shift_type const          * shifts;
+    double_t                        powers[FMM_MAX_TERMS];
+    double_t                      * multipole;
+    double_t const                * child_multipole;
+    uint32_t                        node_index;
+    uint32_t                        shift_count;
+    uint32_t                        i;
+    uint32_t                        t;
+
+    shifts      = vector_access( solver->m2m_shifts, 0, fmm_shift_type );
+    shift_count = vector_size( solver->m2m_shifts );
+
+    /* Reverse sweep visits children before their parent */
+    for( node_index = solver->tree->node_count; node_index > 0; --node_index )
+    {
+        node = &solver->tree->nodes[node_index - 1];
+
+        if( ( SIM_OCTREE_NO_CHILDREN == node->first_child ) || ( 0 == node->body_count ) )
+        {
+            continue;
+        }
+
+        multipole = &solver->multipoles[( node_index - 1 ) * solver->term_count];
+        memset( multipole, 0, solver->term_count * sizeof( double_t ) );
+
+        for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+        {
+            child = &solver->tree->nodes[node->first_child + i];
+
+            if( 0 == child->body_count )
+            {
+                continue;
+            }
+
+            child_multipole = &solver->multipoles[( node->first_child + i ) * solver->term_count];
+
+            compute_powers
+                (
+                    solver,
+                    child->com_x - node->com_x,
+                    child->com_y - node->com_y,
+                    child->com_z - node->com_z,
+                    powers
+                );
+
+            for( t = 0; t < shift_count; ++t )
+            {
+                multipole[shifts[t].to] += shifts[t].coefficient * child_multipole[shifts[t].from] * powers[shifts[t].power];
+            }
+        }
+    }
+}
+
+static void interact
+    (
+        fmm_solver_type   * solver,
+        uint32_t            a,
+        uint32_t            b
+    )
+{
+    sim_octree_node_type const    * node_a;
+    sim_octree_node_type const    * node_b;
+    fmm_pair_type                   pair;
+    boolean                         a_is_leaf;
+    boolean                         b_is_leaf;
+    float_t                         dx;
+    float_t                         dy;
+    float_t                         dz;
+    float_t                         reach;
+    uint32_t                        i;
+    uint32_t                        j;
+
+    node_a = &solver->tree->nodes[a];
+    node_b = &solver->tree->nodes[b];
+
+    if( ( 0 == node_a->body_count ) || ( 0 == node_b->body_count ) )
+    {
+        return;
+    }
+
+    a_is_leaf = ( SIM_OCTREE_NO_CHILDREN == node_a->first_child );
+    b_is_leaf = ( SIM_OCTREE_NO_CHILDREN == node_b->first_child );
+
+    pair.a = a;
+    pair.b = b;
+
+    /* A node interacting with itself, split into every unordered pair of children */
+    if( a == b )
+    {
+        if( a_is_leaf )
+        {
+            vector_push_back( solver->p2p_pairs, &pair );
+            return;
+        }
+
+        for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+        {
+            for( j = i; j < SIM_OCTREE_CHILD_COUNT; ++j )
+            {
+                interact( solver, node_a->first_child + i, node_a->first_child + j );
+            }
+        }
+
+        return;
+    }
+
+    dx = node_b->com_x - node_a->com_x;
+    dy = node_b->com_y - node_a->com_y;
+    dz = node_b->com_z - node_a->com_z;
+    reach = node_a->radius + node_b->radius;
+
+    /* Well separated, the expansions converge */
+    if( reach * reach < solver->opening_angle * solver->opening_angle * ( dx * dx + dy * dy + dz * dz ) )
+    {
+        vector_push_back( solver->m2l_pairs, &pair );
+        return;
+    }
+
+    if( a_is_leaf && b_is_leaf )
+    {
+        vector_push_back( solver->p2p_pairs, &pair );
+        return;
+    }
+
+    /* Split the larger node */
+    if( b_is_leaf || ( !a_is_leaf && ( node_a->radius >= node_b->radius ) ) )
+    {
+        for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+        {
+            interact( solver, node_a->first_child + i, b );
+        }
+    }
+    else
+    {
+        for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+        {
+            interact( solver, a, node_b->first_child + i );
+        }
+    }
+}
+
+static void evaluate_interactions
+    (
+        fmm_solver_type * solver
+    )
+{
+    particle_store_type   * store;
+    fmm_pair_type const   * pairs;
+    uint32_t                pair_count;
+    uint32_t                i;
+    float_t                 softening_sq;
+
+    store           = solver->sim->particles;
+    softening_sq    = solver->sim->config.softening * solver->sim->config.softening;
+
+    /* One worker evaluates each pair once for both nodes */
+    if( 1 == thread_pool_worker_count( solver->sim->pool ) )
+    {
+        pairs       = vector_access( solver->m2l_pairs, 0, fmm_pair_type );
+        pair_count  = vector_size( solver->m2l_pairs );
+
+        for( i = 0; i < pair_count; ++i )
+        {
+            multipole_to_local( solver, pairs[i].a, pairs[i].b, softening_sq, TRUE );
+        }
+
+        pairs       = vector_access( solver->p2p_pairs, 0, fmm_pair_type );
+        pair_count  = vector_size( solver->p2p_pairs );
+
+        for( i = 0; i < pair_count; ++i )
+        {
+            particle_to_particle( solver, store, pairs[i].a, pairs[i].b, softening_sq, TRUE );
+        }
+
+        return;
+    }
+
+    /*
+     * Several workers would race applying a pair to both of its nodes, so
+     * each node gathers from all of its partners instead. Every pair is
+     * evaluated twice, but the nodes split freely between workers.
+     */
+    build_partner_list( &solver->m2l_partners, solver->m2l_pairs, solver->tree->node_count );
+    build_partner_list( &solver->p2p_partners, solver->p2p_pairs, solver->tree->node_count );
+
+    thread_pool_parallel_for( solver->sim->pool, solver->tree->node_count, THREAD_POOL_GRAIN_AUTO, evaluate_nodes, solver );
+}
+
+static void build_partner_list
+    (
+        fmm_partner_list_type * list,
+        vector_type           * pairs,
+        uint32_t                node_count
+    )
+{
+    fmm_pair_type const   * pair;
+    uint32_t                pair_count;
+    uint32_t                i;
+
+    pair        = vector_access( pairs, 0, fmm_pair_type );
+    pair_count  = vector_size( pairs );
+
+    if( node_count + 1 > list->node_capacity )
+    {
+        free( list->first );
+        list->node_capacity = node_count + 1;
+        list->first         = malloc( list->node_capacity * sizeof( uint32_t ) );
+    }
+
+    if( 2 * pair_count > list->partner_capacity )
+    {
+        free( list->partners );
+        list->partner_capacity  = 2 * pair_count;
+        list->partners          = malloc( list->partner_capacity * sizeof( uint32_t ) );
+    }
+
+    /* Count partners into first[n + 1], a node paired with itself is listed once */
+    memset( list->first, 0, ( node_count + 1 ) * sizeof( uint32_t ) );
+
+    for( i = 0; i < pair_count; ++i )
+    {
+        list->first[pair[i].a + 1] += 1;
+        if( pair[i].a != pair[i].b )
+        {
+            list->first[pair[i].b + 1] += 1;
+        }
+    }
+
+    for( i = 0; i < node_count; ++i )
+    {
+        list->first[i + 1] += list->first[i];
+    }
+
+    /* Fill using first[n] as the write cursor, which leaves it at the start of node n + 1 */
+    for( i = 0; i < pair_count; ++i )
+    {
+        list->partners[list->first[pair[i].a]++] = pair[i].b;
+        if( pair[i].a != pair[i].b )
+        {
+            list->partners[list->first[pair[i].b]++] = pair[i].a;
+        }
+    }
+
+    for( i = node_count; i > 0; --i )
+    {
+        list->first[i] = list->first[i - 1];
+    }
+    list->first[0] = 0;
+}
+
+static void evaluate_nodes
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    )
+{
+    fmm_solver_type   * solver;
+    particle_store_type * store;
+    uint32_t            node_index;
+    uint32_t            i;
+    float_t             softening_sq;
+
+    solver          = (fmm_solver_type *)user_data;
+    store           = solver->sim->particles;
+    softening_sq    = solver->sim->config.softening * solver->sim->config.softening;
+
+    for( node_index = first; node_index < last; ++node_index )
+    {
+        for( i = solver->m2l_partners.first[node_index]; i < solver->m2l_partners.first[node_index + 1]; ++i )
+        {
+            multipole_to_local( solver, solver->m2l_partners.partners[i], node_index, softening_sq, FALSE );
+        }
+
+        for( i = solver->p2p_partners.first[node_index]; i < solver->p2p_partners.first[node_index + 1]; ++i )
+        {
+            particle_to_particle( solver, store, node_index, solver->p2p_partners.partners[i], softening_sq, FALSE );
+        }
+    }
+}
+
+static void multipole_to_local
+    (
+        fmm_solver_type   * solver,
+        uint32_t            a,
+        uint32_t            b,
+        float_t             softening_sq,
+        boolean             mutual
+    )
+{
+    sim_octree_node_type const    * node_a;
+    sim_octree_node_type const    * node_b;
+    fmm_translation_type const    * translations;
+    double_t                        derivatives[FMM_MAX_TERMS];
+    double_t                      * local_a;
+    double_t                      * local_b;
+    double_t const                * multipole_a;
+    double_t const                * multipole_b;
+    uint32_t                        translation_count;
+    uint32_t                        t;
+
+    node_a      = &solver->tree->nodes[a];
+    node_b      = &solver->tree->nodes[b];
+    local_a     = &solver->locals[a * solver->term_count];
+    local_b     = &solver->locals[b * solver->term_count];
+    multipole_a = &solver->multipoles[a * solver->term_count];
+    multipole_b = &solver->multipoles[b * solver->term_count];
+
+    compute_derivatives
+        (
+            solver,
+            (double_t)node_b->com_x - node_a->com_x,
+            (double_t)node_b->com_y - node_a->com_y,
+            (double_t)node_b->com_z - node_a->com_z,
+            softening_sq,
+            derivatives
+        );
+
+    translations        = vector_access( solver->m2l_terms, 0, fmm_translation_type );
+    translation_count   = vector_size( solver->m2l_terms );
+
+    if( !mutual )
+    {
+        for( t = 0; t < translation_count; ++t )
+        {
+            local_b[translations[t].local] += translations[t].coefficient * multipole_a[translations[t].multipole] * derivatives[translations[t].derivative];
+        }
+
+        return;
+    }
+
+    for( t = 0; t < translation_count; ++t )
+    {
+        local_b[translations[t].local] += translations[t].coefficient * multipole_a[translations[t].multipole] * derivatives[translations[t].derivative];
+        local_a[translations[t].local] += translations[t].reverse_coefficient * multipole_b[translations[t].multipole] * derivatives[translations[t].derivative];
+    }
+}
+
+static void particle_to_particle
+    (
+        fmm_solver_type const * solver,
+        particle_store_type   * store,
+        uint32_t                a,
+        uint32_t                b,
+        float_t                 softening_sq,
+        boolean                 mutual
+    )
+{
+    sim_octree_node_type const    * node_a;
+    sim_octree_node_type const    * node_b;
+    sim_force_sources_type const  * sources;
+    uint32_t                        i;
+    uint32_t                        body;
+    uint32_t                        last_b;
+    float_t                         x;
+    float_t                         y;
+    float_t                         z;
+    float_t                         sum_x;
+    float_t                         sum_y;
+    float_t                         sum_z;
+
+    node_a  = &solver->tree->nodes[a];
+    node_b  = &solver->tree->nodes[b];
+    sources = &solver->tree->sorted;
+    last_b  = node_b->first_body + node_b->body_count;
+
+    /*
+     * The sorted copy keeps each leaf's bodies contiguous, so b's bodies stream
+     * through the SIMD kernel. It only gathers, so a mutual pair runs it both
+     * ways rather than applying Newton's third law.
+     */
+    for( i = node_a->first_body; i < node_a->first_body + node_a->body_count; ++i )
+    {
+        x = sources->position_x[i];
+        y = sources->position_y[i];
+        z = sources->position_z[i];
+
+        sum_x = 0.0f;
+        sum_y = 0.0f;
+        sum_z = 0.0f;
+
+        if( a == b )
+        {
+            sim_force_direct_accumulate( sources, x, y, z, node_b->first_body, i, softening_sq, &sum_x, &sum_y, &sum_z );
+            sim_force_direct_accumulate( sources, x, y, z, i + 1, last_b, softening_sq, &sum_x, &sum_y, &sum_z );
+        }
+        else
+        {
+            sim_force_direct_accumulate( sources, x, y, z, node_b->first_body, last_b, softening_sq, &sum_x, &sum_y, &sum_z );
+        }
+
+        body = solver->tree->body_order[i];
+
+        store->acceleration_x[body] += sum_x;
+        store->acceleration_y[body] += sum_y;
+        store->acceleration_z[body] += sum_z;
+    }
+
+    if( mutual && ( a != b ) )
+    {
+        particle_to_particle( solver, store, b, a, softening_sq, FALSE );
+    }
+}
+
+static void downward_pass
+    (
+        fmm_solver_type * solver
+    )
+{
+    sim_octree_node_type const    * node;
+    sim_octree_node_type const    * child;
+    fmm_shift_type const          * shifts;
+    double_t                        powers[FMM_MAX_TERMS];
+    double_t const                * local;
+    double_t                      * child_local;
+    uint32_t                        node_index;
+    uint32_t                        shift_count;
+    uint32_t                        i;
+    uint32_t                        t;
+
+    shifts      = vector_access( solver->l2l_shifts, 0, fmm_shift_type );
+    shift_count = vector_size( solver->l2l_shifts );
+
+    /* Forward sweep visits parents before their children */
+    for( node_index = 0; node_index < solver->tree->node_count; ++node_index )
+    {
+        node = &solver->tree->nodes[node_index];
+
+        if( ( SIM_OCTREE_NO_CHILDREN == node->first_child ) || ( 0 == node->body_count ) )
+        {
+            continue;
+        }
+
+        local = &solver->locals[node_index * solver->term_count];
+
+        for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+        {
+            child = &solver->tree->nodes[node->first_child + i];
+
+            if( 0 == child->body_count )
+            {
+                continue;
+            }
+
+            child_local = &solver->locals[( node->first_child + i ) * solver->term_count];
+
+            compute_powers
+                (
+                    solver,
+                    child->com_x - node->com_x,
+                    child->com_y - node->com_y,
+                    child->com_z - node->com_z,
+                    powers
+                );
+
+            for( t = 0; t < shift_count; ++t )
+            {
+                child_local[shifts[t].to] += shifts[t].coefficient * local[shifts[t].from] * powers[shifts[t].power];
+            }
+        }
+    }
+}
+
+static void leaf_accelerations
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    )
+{
+    fmm_solver_type               * solver;
+    particle_store_type           * store;
+    sim_octree_node_type const    * node;
+    fmm_term_type const           * term;
+    double_t                        powers[FMM_MAX_TERMS];
+    double_t const                * local;
+    double_t                        gradient[FMM_AXIS_COUNT];
+    uint32_t                        node_index;
+    uint32_t                        i;
+    uint32_t                        t;
+    uint32_t                        axis;
+    uint32_t                        body;
+    float_t                         g;
+
+    solver  = (fmm_solver_type *)user_data;
+    store   = solver->sim->particles;
+    g       = solver->sim->config.gravitational_constant;
+
+    for( node_index = first; node_index < last; ++node_index )
+    {
+        node = &solver->tree->nodes[node_index];
+
+        if( ( SIM_OCTREE_NO_CHILDREN != node->first_child ) || ( 0 == node->body_count ) )
+        {
+            continue;
+        }
+
+        local = &solver->locals[node_index * solver->term_count];
+
+        /* The far field acceleration is the gradient of sum_n L_n r^n */
+        for( i = node->first_body; i < node->first_body + node->body_count; ++i )
+        {
+            body = solver->tree->body_order[i];
+
+            compute_powers
+                (
+                    solver,
+                    store->position_x[body] - node->com_x,
+                    store->position_y[body] - node->com_y,
+                    store->position_z[body] - node->com_z,
+                    powers
+                );
+
+            gradient[0] = 0.0;
+            gradient[1] = 0.0;
+            gradient[2] = 0.0;
+
+            for( t = 1; t < solver->term_count; ++t )
+            {
+                term = &solver->terms[t];
+
+                for( axis = 0; axis < FMM_AXIS_COUNT; ++axis )
+                {
+                    if( FMM_NO_TERM != term->less_one[axis] )
+                    {
+                        gradient[axis] += term->exponent[axis] * local[t] * powers[term->less_one[axis]];
+                    }
+                }
+            }
+
+            store->acceleration_x[body] = g * ( store->acceleration_x[body] + (float_t)gradient[0] );
+            store->acceleration_y[body] = g * ( store->acceleration_y[body] + (float_t)gradient[1] );
+            store->acceleration_z[body] = g * ( store->acceleration_z[body] + (float_t)gradient[2] );
+        }
+    }
+}
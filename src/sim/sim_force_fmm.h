@@ -0,0 +1,56 @@
+/**
+ * @file sim_force_fmm.h
+ *
+ * @brief Fast multipole method gravity solver
+ *
+ * Cartesian Taylor expansions of configurable order are built about each
+ * octree node's centre of mass, and a dual tree traversal decides for every
+ * pair of nodes whether to interact them by multipole to local translation
+ * or by direct summation. The expansions are of the same Plummer softened
+ * kernel as the direct sum, so the two agree at any opening angle.
+ */
+#ifndef SIM_FORCE_FMM_H
+#define SIM_FORCE_FMM_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define SIM_FORCE_FMM_MAX_ORDER     ( 8 )
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocate the tree, expansion storage and translation tables for the configured order
+ */
+void * sim_force_fmm_create
+    (
+        sim_config_type const * config
+    );
+
+/**
+ * @brief Free the solver state
+ */
+void sim_force_fmm_free
+    (
+        void * state
+    );
+
+/**
+ * @brief Build the octree and expansions and compute the acceleration of every particle
+ */
+void sim_force_fmm_compute
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+#endif /* SIM_FORCE_FMM_H */
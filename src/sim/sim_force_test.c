@@ -0,0 +1,238 @@
+/**
+ * @file sim_force_test.c
+ *
+ * @brief Tests of the force solvers
+ */
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_force_test.h"
+#include "sim_force_direct.h"
+#include "common_util.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define KERNEL_SOURCE_COUNT     ( 1003 )    /* Not a multiple of any vector width, so every kernel has a tail */
+#define KERNEL_TARGET_COUNT     ( 64 )
+#define KERNEL_SOFTENING_SQ     ( 1.0e-4f )
+
+/*
+ * Each SIMD kernel sums in a different order and uses rsqrt plus a Newton
+ * step, so they only agree to a few ulps per term. An error is measured
+ * against the sum of the term magnitudes, which bounds what reordering can
+ * do even when the terms cancel.
+ */
+#define KERNEL_TOLERANCE        ( 1.0e-5 )
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/**
+ * @brief Source ranges the kernels are compared over, [first, last)
+ */
+typedef struct kernel_range_struct
+{
+    uint32_t    first;
+    uint32_t    last;
+} kernel_range_type;
+
+/**********************************************************************
+                                VARIABLES
+**********************************************************************/
+
+static kernel_range_type const kernel_ranges[] =
+{
+    { 0, KERNEL_SOURCE_COUNT },         /* Everything */
+    { 0, 0 },                           /* Empty */
+    { 5, 6 },                           /* A single source */
+    { 3, 10 },                          /* Shorter than a vector, unaligned */
+    { 7, 7 + 17 },                      /* One vector and change, unaligned */
+    { 16, 16 + 32 },                    /* Whole vectors, aligned */
+    { 1, KERNEL_SOURCE_COUNT - 1 }      /* Unaligned at both ends */
+};
+
+/**********************************************************************
+                            PROTOTYPES
+**********************************************************************/
+
+static boolean kernel_test
+    (
+        void
+    );
+
+static float_t random_float
+    (
+        float_t     low,
+        float_t     high
+    );
+
+/**********************************************************************
+                            FUNCTIONS
+**********************************************************************/
+
+boolean sim_force_tests_run
+    (
+        void
+    )
+{
+    boolean passed;
+
+    passed = kernel_test();
+
+    return passed;
+}
+
+/**
+ * @brief Every SIMD direct summation kernel the build and CPU support must
+ *        match the scalar kernel over ranges with and without tails
+ */
+static boolean kernel_test
+    (
+        void
+    )
+{
+    sim_force_sources_type      sources;
+    sim_force_direct_kernel_t8  original;
+    sim_force_direct_kernel_t8  kernel;
+    kernel_range_type const   * range;
+    float_t                     target[KERNEL_TARGET_COUNT][3];
+    float_t                     expected[3];
+    float_t                     actual[3];
+    double_t                    magnitude;
+    double_t                    error;
+    double_t                    worst;
+    double_t                    dx;
+    double_t                    dy;
+    double_t                    dz;
+    uint32_t                    r;
+    uint32_t                    t;
+    uint32_t                    i;
+    boolean                     passed;
+
+    printf( "Direct kernel test start:\n" );
+
+    sources.position_x  = malloc( KERNEL_SOURCE_COUNT * sizeof( float_t ) );
+    sources.position_y  = malloc( KERNEL_SOURCE_COUNT * sizeof( float_t ) );
+    sources.position_z  = malloc( KERNEL_SOURCE_COUNT * sizeof( float_t ) );
+    sources.mass        = malloc( KERNEL_SOURCE_COUNT * sizeof( float_t ) );
+
+    srand( 1 );
+    for( i = 0; i < KERNEL_SOURCE_COUNT; ++i )
+    {
+        sources.position_x[i]   = random_float( -1.0f, 1.0f );
+        sources.position_y[i]   = random_float( -1.0f, 1.0f );
+        sources.position_z[i]   = random_float( -1.0f, 1.0f );
+        sources.mass[i]         = random_float( 0.1f, 1.0f );
+    }
+
+    /* Targets inside the cloud, where the terms cancel, and outside it */
+    for( t = 0; t < KERNEL_TARGET_COUNT; ++t )
+    {
+        target[t][0] = random_float( -2.0f, 2.0f );
+        target[t][1] = random_float( -2.0f, 2.0f );
+        target[t][2] = random_float( -2.0f, 2.0f );
+    }
+
+    /* One target on top of a source, where only the softening keeps the term finite */
+    target[0][0] = sources.position_x[5];
+    target[0][1] = sources.position_y[5];
+    target[0][2] = sources.position_z[5];
+
+    original    = sim_force_direct_get_kernel();
+    passed      = TRUE;
+
+    for( kernel = 0; kernel < SIM_FORCE_DIRECT_KERNEL_COUNT; ++kernel )
+    {
+        if( SIM_FORCE_DIRECT_KERNEL_SCALAR == kernel )
+        {
+            continue;
+        }
+
+        if( !sim_force_direct_set_kernel( kernel ) )
+        {
+            printf( "%s: not supported by this build or CPU, skipped\n", sim_force_direct_kernel_name( kernel ) );
+            continue;
+        }
+
+        worst = 0.0;
+        for( r = 0; r < sizeof( kernel_ranges ) / sizeof( kernel_ranges[0] ); ++r )
+        {
+            range = &kernel_ranges[r];
+
+            for( t = 0; t < KERNEL_TARGET_COUNT; ++t )
+            {
+                expected[0] = expected[1] = expected[2] = 0.0f;
+                actual[0]   = actual[1]   = actual[2]   = 0.0f;
+
+                sim_force_direct_set_kernel( SIM_FORCE_DIRECT_KERNEL_SCALAR );
+                sim_force_direct_accumulate( &sources, target[t][0], target[t][1], target[t][2], range->first, range->last,
+                                             KERNEL_SOFTENING_SQ, &expected[0], &expected[1], &expected[2] );
+
+                sim_force_direct_set_kernel( kernel );
+                sim_force_direct_accumulate( &sources, target[t][0], target[t][1], target[t][2], range->first, range->last,
+                                             KERNEL_SOFTENING_SQ, &actual[0], &actual[1], &actual[2] );
+
+                magnitude = 0.0;
+                for( i = range->first; i < range->last; ++i )
+                {
+                    dx = (double_t)sources.position_x[i] - target[t][0];
+                    dy = (double_t)sources.position_y[i] - target[t][1];
+                    dz = (double_t)sources.position_z[i] - target[t][2];
+
+                    magnitude += sources.mass[i] / ( dx * dx + dy * dy + dz * dz + KERNEL_SOFTENING_SQ );
+                }
+
+                dx      = (double_t)actual[0] - expected[0];
+                dy      = (double_t)actual[1] - expected[1];
+                dz      = (double_t)actual[2] - expected[2];
+                error   = sqrt( dx * dx + dy * dy + dz * dz );
+
+                /* An empty range must add exactly nothing */
+                if( ( magnitude > 0.0 ) ? ( error > KERNEL_TOLERANCE * magnitude ) : ( error > 0.0 ) )
+                {
+                    printf( "%s: sources [%d, %d) target %d off by %g, tolerance %g\n", sim_force_direct_kernel_name( kernel ),
+                            range->first, range->last, t, error, KERNEL_TOLERANCE * magnitude );
+                    passed = FALSE;
+                }
+
+                if( magnitude > 0.0 )
+                {
+                    worst = MAX( worst, error / magnitude );
+                }
+            }
+        }
+
+        printf( "%s: worst relative error %g\n", sim_force_direct_kernel_name( kernel ), worst );
+    }
+
+    sim_force_direct_set_kernel( original );
+
+    free( sources.position_x );
+    free( sources.position_y );
+    free( sources.position_z );
+    free( sources.mass );
+
+    printf( "%s\n", passed ? "PASS" : "FAIL" );
+
+    return passed;
+}
+
+/**
+ * @brief Get a uniform random number in [low, high]
+ */
+static float_t random_float
+    (
+        float_t     low,
+        float_t     high
+    )
+{
+    return low + ( high - low ) * (float_t)rand() / (float_t)RAND_MAX;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file sim_force_test.h
+ *
+ * @brief Interface to the force solver test suite
+ */
+#ifndef SIM_FORCE_TEST_H
+#define SIM_FORCE_TEST_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Runs the force solver tests
+ *
+ * @return TRUE if they all passed
+ */
+boolean sim_force_tests_run
+    (
+        void
+    );
+
+#endif /* SIM_FORCE_TEST_H */
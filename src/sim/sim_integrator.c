@@ -0,0 +1,861 @@
+/**
+ * @file sim_integrator.c
+ *
+ * @brief Implementation of the particle time integrators
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_integrator.h"
+#include "sim_force.h"
+#include "sim_force_direct.h"
+#include "common_util.h"
+#include "vector.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+/* Yoshida 4th order weights, w1 = 1 / ( 2 - 2^( 1 / 3 ) ) and w0 = 1 - 2 w1 */
+#define YOSHIDA_W1      ( 1.3512071919596578 )
+#define YOSHIDA_W0      ( -1.7024143839193153 )
+
+#define AXIS_COUNT      ( 3 )
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+typedef void * (*sim_integrator_create_cb)
+    (
+        void
+    );
+
+typedef void (*sim_integrator_free_cb)
+    (
+        void * state
+    );
+
+typedef void (*sim_integrator_step_cb)
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+typedef struct sim_integrator_struct
+{
+    sim_integrator_create_cb    create;     /* Optional, state is NULL if not provided */
+    sim_integrator_free_cb      free;       /* Optional */
+    sim_integrator_step_cb      step;
+} sim_integrator_type;
+
+/**
+ * @brief Start of step copies and jerks kept by the Hermite integrator
+ */
+typedef struct hermite_state_struct
+{
+    float_t   * position[AXIS_COUNT];
+    float_t   * velocity[AXIS_COUNT];
+    float_t   * acceleration[AXIS_COUNT];
+    float_t   * jerk[AXIS_COUNT];           /* Matches the accelerations in the particle store */
+    float_t   * new_jerk[AXIS_COUNT];
+    uint32_t    capacity;
+    uint32_t    jerk_count;                 /* Number of bodies jerk is valid for, 0 if stale */
+} hermite_state_type;
+
+/**
+ * @brief Rung bookkeeping of the block step integrator
+ *
+ * Every body sits on a rung, and the bodies of each rung are listed in
+ * members so the active set of a substep is gathered without looking at
+ * the inactive bodies. Only the active bodies drift, so every body keeps
+ * the time its position was last brought up to.
+ */
+typedef struct block_state_struct
+{
+    uint8_t       * rung;                                       /* Per body */
+    uint32_t      * slot;                                       /* Per body, its index in members[rung] */
+    float_t       * sync_time;                                  /* Per body, time since the start of the step its position is at */
+    uint32_t      * active;                                     /* Bodies due a kick this substep */
+    uint32_t        capacity;
+    uint32_t        body_count;                                 /* Number of bodies the rungs are valid for, 0 if stale */
+    vector_type   * members[SIM_INTEGRATOR_MAX_BLOCK_LEVELS];   /* uint32_t body indices */
+} block_state_type;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+static void euler_step
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+static void leapfrog_step
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+static void yoshida4_step
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+static void * hermite4_create
+    (
+        void
+    );
+
+static void hermite4_free
+    (
+        void * state
+    );
+
+static void hermite4_step
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+static void * block_create
+    (
+        void
+    );
+
+static void block_free
+    (
+        void * state
+    );
+
+static void block_step
+    (
+        sim_type  * sim,
+        void      * state
+    );
+
+/**
+ * @brief The finest rung whose step a body's acceleration allows,
+ *        clamped to [0, level_count)
+ */
+static uint8_t block_desired_rung
+    (
+        sim_type const    * sim,
+        uint32_t            index,
+        uint8_t             level_count
+    );
+
+/**
+ * @brief Move a body to a rung
+ */
+static void block_set_rung
+    (
+        block_state_type  * block,
+        uint32_t            index,
+        uint8_t             rung
+    );
+
+/**
+ * @brief Give every body its desired rung
+ */
+static void block_assign_all
+    (
+        sim_type          * sim,
+        block_state_type  * block,
+        uint8_t             level_count
+    );
+
+/**
+ * @brief v += a * dt for the listed bodies, each with half its rung's step
+ */
+static void block_half_kick
+    (
+        sim_type          * sim,
+        block_state_type  * block,
+        uint32_t const    * indices,
+        uint32_t            count
+    );
+
+/**
+ * @brief Drift the listed bodies from their sync time to time
+ */
+static void block_drift
+    (
+        sim_type          * sim,
+        block_state_type  * block,
+        uint32_t const    * indices,
+        uint32_t            count,
+        float_t             time
+    );
+
+/**
+ * @brief v += a * dt
+ */
+static void kick
+    (
+        particle_store_type   * store,
+        float_t                 dt
+    );
+
+/**
+ * @brief x += v * dt
+ */
+static void drift
+    (
+        particle_store_type   * store,
+        float_t                 dt
+    );
+
+/**
+ * @brief Make sure the Hermite arrays can hold count bodies
+ */
+static void hermite4_reserve
+    (
+        hermite_state_type    * hermite,
+        uint32_t                count
+    );
+
+/**********************************************************************
+                                MEMORY CONSTANTS
+**********************************************************************/
+
+/* Indexed by sim_integrator_t8 */
+static sim_integrator_type const integrators[SIM_INTEGRATOR_COUNT] =
+{
+    { NULL,             NULL,           euler_step },
+    { NULL,             NULL,           leapfrog_step },
+    { NULL,             NULL,           yoshida4_step },
+    { hermite4_create,  hermite4_free,  hermite4_step },
+    { block_create,     block_free,     block_step }
+};
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void sim_integrator_init
+    (
+        sim_type * sim
+    )
+{
+    sim_integrator_type const * integrator;
+
+    ASSERT( sim->config.integrator < SIM_INTEGRATOR_COUNT );
+    ASSERT( ( SIM_INTEGRATOR_BLOCK_LEAPFROG != sim->config.integrator ) || sim_force_supports_block_steps( sim->config.force_solver ) );
+
+    integrator = &integrators[sim->config.integrator];
+    sim->integrator_state = ( NULL != integrator->create ) ? integrator->create() : NULL;
+}
+
+void sim_integrator_deinit
+    (
+        sim_type * sim
+    )
+{
+    sim_integrator_type const * integrator;
+
+    integrator = &integrators[sim->config.integrator];
+    if( NULL != integrator->free )
+    {
+        integrator->free( sim->integrator_state );
+    }
+
+    sim->integrator_state = NULL;
+}
+
+void sim_integrator_step
+    (
+        sim_type * sim
+    )
+{
+    if( 0 == sim->particles->count )
+    {
+        return;
+    }
+
+    integrators[sim->config.integrator].step( sim, sim->integrator_state );
+}
+
+static void euler_step
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    if( !sim->accelerations_valid )
+    {
+        sim_force_compute( sim );
+    }
+
+    kick( sim->particles, sim->config.time_step );
+    drift( sim->particles, sim->config.time_step );
+
+    /* Accelerations for the next step come from the new positions */
+    sim_force_compute( sim );
+}
+
+static void leapfrog_step
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    float_t dt;
+
+    dt = sim->config.time_step;
+
+    if( !sim->accelerations_valid )
+    {
+        sim_force_compute( sim );
+    }
+
+    /* The closing half kick leaves the accelerations at the new positions for the next opening half kick */
+    kick( sim->particles, 0.5f * dt );
+    drift( sim->particles, dt );
+    sim_force_compute( sim );
+    kick( sim->particles, 0.5f * dt );
+}
+
+static void yoshida4_step
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    float_t dt;
+
+    dt = sim->config.time_step;
+
+    if( !sim->accelerations_valid )
+    {
+        sim_force_compute( sim );
+    }
+
+    /* Leapfrog steps of w1, w0, w1 dt with the touching half kicks merged */
+    kick( sim->particles, (float_t)( 0.5 * YOSHIDA_W1 ) * dt );
+    drift( sim->particles, (float_t)YOSHIDA_W1 * dt );
+    sim_force_compute( sim );
+
+    kick( sim->particles, (float_t)( 0.5 * ( YOSHIDA_W1 + YOSHIDA_W0 ) ) * dt );
+    drift( sim->particles, (float_t)YOSHIDA_W0 * dt );
+    sim_force_compute( sim );
+
+    kick( sim->particles, (float_t)( 0.5 * ( YOSHIDA_W0 + YOSHIDA_W1 ) ) * dt );
+    drift( sim->particles, (float_t)YOSHIDA_W1 * dt );
+    sim_force_compute( sim );
+
+    kick( sim->particles, (float_t)( 0.5 * YOSHIDA_W1 ) * dt );
+}
+
+static void * hermite4_create
+    (
+        void
+    )
+{
+    return calloc( 1, sizeof( hermite_state_type ) );
+}
+
+static void hermite4_free
+    (
+        void * state
+    )
+{
+    hermite_state_type    * hermite;
+    uint32_t                axis;
+
+    hermite = (hermite_state_type *)state;
+
+    for( axis = 0; axis < AXIS_COUNT; ++axis )
+    {
+        free( hermite->position[axis] );
+        free( hermite->velocity[axis] );
+        free( hermite->acceleration[axis] );
+        free( hermite->jerk[axis] );
+        free( hermite->new_jerk[axis] );
+    }
+
+    free( hermite );
+}
+
+static void hermite4_step
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    hermite_state_type    * hermite;
+    particle_store_type   * store;
+    float_t               * position[AXIS_COUNT];
+    float_t               * velocity[AXIS_COUNT];
+    float_t               * acceleration[AXIS_COUNT];
+    float_t               * swap;
+    float_t                 dt;
+    float_t                 dt2;
+    float_t                 dt3;
+    uint32_t                axis;
+    uint32_t                i;
+    uint32_t                len;
+
+    hermite = (hermite_state_type *)state;
+    store   = sim->particles;
+    len     = store->count;
+    dt      = sim->config.time_step;
+    dt2     = dt * dt;
+    dt3     = dt2 * dt;
+
+    hermite4_reserve( hermite, len );
+
+    position[0]     = store->position_x;
+    position[1]     = store->position_y;
+    position[2]     = store->position_z;
+    velocity[0]     = store->velocity_x;
+    velocity[1]     = store->velocity_y;
+    velocity[2]     = store->velocity_z;
+    acceleration[0] = store->acceleration_x;
+    acceleration[1] = store->acceleration_y;
+    acceleration[2] = store->acceleration_z;
+
+    if( !sim->accelerations_valid || ( hermite->jerk_count != len ) )
+    {
+        sim_force_direct_compute_jerk( sim, hermite->jerk[0], hermite->jerk[1], hermite->jerk[2] );
+    }
+
+    for( axis = 0; axis < AXIS_COUNT; ++axis )
+    {
+        memcpy( hermite->position[axis], position[axis], len * sizeof( float_t ) );
+        memcpy( hermite->velocity[axis], velocity[axis], len * sizeof( float_t ) );
+        memcpy( hermite->acceleration[axis], acceleration[axis], len * sizeof( float_t ) );
+
+        /* Predict with the Taylor series to jerk */
+        for( i = 0; i < len; ++i )
+        {
+            position[axis][i] += velocity[axis][i] * dt + acceleration[axis][i] * ( dt2 / 2.0f ) + hermite->jerk[axis][i] * ( dt3 / 6.0f );
+            velocity[axis][i] += acceleration[axis][i] * dt + hermite->jerk[axis][i] * ( dt2 / 2.0f );
+        }
+    }
+
+    /* Evaluate at the predicted state */
+    sim_force_direct_compute_jerk( sim, hermite->new_jerk[0], hermite->new_jerk[1], hermite->new_jerk[2] );
+
+    /* Correct, velocity first as the position correction uses it */
+    for( axis = 0; axis < AXIS_COUNT; ++axis )
+    {
+        for( i = 0; i < len; ++i )
+        {
+            velocity[axis][i] = hermite->velocity[axis][i]
+                              + ( hermite->acceleration[axis][i] + acceleration[axis][i] ) * ( dt / 2.0f )
+                              + ( hermite->jerk[axis][i] - hermite->new_jerk[axis][i] ) * ( dt2 / 12.0f );
+
+            position[axis][i] = hermite->position[axis][i]
+                              + ( hermite->velocity[axis][i] + velocity[axis][i] ) * ( dt / 2.0f )
+                              + ( hermite->acceleration[axis][i] - acceleration[axis][i] ) * ( dt2 / 12.0f );
+        }
+
+        swap                        = hermite->jerk[axis];
+        hermite->jerk[axis]         = hermite->new_jerk[axis];
+        hermite->new_jerk[axis]     = swap;
+    }
+
+    /* The predicted accelerations and jerks start the next step */
+    hermite->jerk_count         = len;
+    sim->accelerations_valid    = TRUE;
+}
+
+static void * block_create
+    (
+        void
+    )
+{
+    block_state_type  * block;
+    uint32_t            r;
+
+    block = calloc( 1, sizeof( block_state_type ) );
+
+    for( r = 0; r < SIM_INTEGRATOR_MAX_BLOCK_LEVELS; ++r )
+    {
+        block->members[r] = vector_init( sizeof( uint32_t ) );
+    }
+
+    return block;
+}
+
+static void block_free
+    (
+        void * state
+    )
+{
+    block_state_type  * block;
+    uint32_t            r;
+
+    block = (block_state_type *)state;
+
+    for( r = 0; r < SIM_INTEGRATOR_MAX_BLOCK_LEVELS; ++r )
+    {
+        vector_deinit( block->members[r] );
+    }
+
+    free( block->rung );
+    free( block->slot );
+    free( block->sync_time );
+    free( block->active );
+    free( block );
+}
+
+static void block_step
+    (
+        sim_type  * sim,
+        void      * state
+    )
+{
+    block_state_type          * block;
+    particle_store_type       * store;
+    sim_force_prediction_type   prediction;
+    uint32_t                    substep_count;
+    uint32_t                    substep;
+    uint32_t                    active_count;
+    uint32_t                    i;
+    uint8_t                     level_count;
+    uint8_t                     sync_level;
+    uint8_t                     first_active;
+    uint8_t                     r;
+    float_t                     dt_min;
+
+    block       = (block_state_type *)state;
+    store       = sim->particles;
+    level_count = (uint8_t)MIN( MAX( 1, sim->config.block_levels ), SIM_INTEGRATOR_MAX_BLOCK_LEVELS );
+
+    substep_count   = (uint32_t)1 << ( level_count - 1 );
+    dt_min          = sim->config.time_step / (float_t)substep_count;
+
+    if( !sim->accelerations_valid )
+    {
+        sim_force_compute( sim );
+    }
+
+    /* Every body is synchronised at the start of the step, so any rung is allowed */
+    block_assign_all( sim, block, level_count );
+    block_half_kick( sim, block, NULL, store->count );
+
+    for( i = 0; i < store->count; ++i )
+    {
+        block->sync_time[i] = 0.0f;
+    }
+
+    sim_force_begin_block_step( sim );
+
+    prediction.sync_time = block->sync_time;
+
+    for( substep = 1; substep <= substep_count; ++substep )
+    {
+        /*
+         * Rung r ends a step every 2^( level_count - 1 - r ) substeps. The
+         * trailing zeros of the substep count how many of the coarser rungs
+         * end here as well.
+         */
+        sync_level = 0;
+        while( ( sync_level < level_count - 1 ) && ( 0 == ( substep & ( (uint32_t)1 << sync_level ) ) ) )
+        {
+            sync_level += 1;
+        }
+
+        first_active = (uint8_t)( level_count - 1 - sync_level );
+
+        active_count = 0;
+        for( r = first_active; r < level_count; ++r )
+        {
+            for( i = 0; i < vector_size( block->members[r] ); ++i )
+            {
+                block->active[active_count++] = *vector_access( block->members[r], i, uint32_t );
+            }
+        }
+
+        if( 0 == active_count )
+        {
+            continue;
+        }
+
+        /* Only the bodies due a kick are brought up to now, the force pass predicts the rest */
+        prediction.time = dt_min * (float_t)substep;
+        block_drift( sim, block, block->active, active_count, prediction.time );
+
+        /* The last substep ends every rung, leaving the whole system synchronised */
+        if( substep == substep_count )
+        {
+            sim_force_compute( sim );
+        }
+        else
+        {
+            sim_force_compute_active( sim, block->active, active_count, &prediction );
+        }
+
+        block_half_kick( sim, block, block->active, active_count );
+
+        if( substep == substep_count )
+        {
+            break;
+        }
+
+        /* A body may only move to a rung whose steps line up with this substep */
+        for( i = 0; i < active_count; ++i )
+        {
+            block_set_rung( block, block->active[i], MAX( first_active, block_desired_rung( sim, block->active[i], level_count ) ) );
+        }
+
+        block_half_kick( sim, block, block->active, active_count );
+        sim_force_update_active( sim, block->active, active_count, &prediction );
+    }
+}
+
+static uint8_t block_desired_rung
+    (
+        sim_type const    * sim,
+        uint32_t            index,
+        uint8_t             level_count
+    )
+{
+    particle_store_type const * store;
+    float_t                     magnitude;
+    float_t                     desired;
+    float_t                     dt;
+    uint8_t                     rung;
+
+    store       = sim->particles;
+    magnitude   = (float_t)sqrt( store->acceleration_x[index] * store->acceleration_x[index]
+                               + store->acceleration_y[index] * store->acceleration_y[index]
+                               + store->acceleration_z[index] * store->acceleration_z[index] );
+
+    if( magnitude <= 0.0f )
+    {
+        return 0;
+    }
+
+    desired = sim->config.time_step_accuracy * (float_t)sqrt( sim->config.softening / magnitude );
+    dt      = sim->config.time_step;
+    rung    = 0;
+
+    while( ( dt > desired ) && ( rung < level_count - 1 ) )
+    {
+        dt   *= 0.5f;
+        rung += 1;
+    }
+
+    return rung;
+}
+
+static void block_set_rung
+    (
+        block_state_type  * block,
+        uint32_t            index,
+        uint8_t             rung
+    )
+{
+    vector_type   * members;
+    uint32_t        last;
+
+    if( rung == block->rung[index] )
+    {
+        return;
+    }
+
+    /* Swap remove from the old rung, the last member takes over the slot */
+    members = block->members[block->rung[index]];
+    vector_pop_back( members, &last );
+
+    if( last != index )
+    {
+        *vector_access( members, block->slot[index], uint32_t ) = last;
+        block->slot[last] = block->slot[index];
+    }
+
+    block->rung[index] = rung;
+    block->slot[index] = vector_size( block->members[rung] );
+    vector_push_back( block->members[rung], &index );
+}
+
+static void block_assign_all
+    (
+        sim_type          * sim,
+        block_state_type  * block,
+        uint8_t             level_count
+    )
+{
+    uint32_t    count;
+    uint32_t    i;
+    uint32_t    r;
+
+    count = sim->particles->count;
+
+    if( count > block->capacity )
+    {
+        free( block->rung );
+        free( block->slot );
+        free( block->sync_time );
+        free( block->active );
+
+        block->capacity     = count;
+        block->rung         = malloc( count * sizeof( uint8_t ) );
+        block->slot         = malloc( count * sizeof( uint32_t ) );
+        block->sync_time    = malloc( count * sizeof( float_t ) );
+        block->active       = malloc( count * sizeof( uint32_t ) );
+
+        block->body_count = 0;
+    }
+
+    /* Bodies were added or removed, the old indices mean nothing */
+    if( count != block->body_count )
+    {
+        for( r = 0; r < SIM_INTEGRATOR_MAX_BLOCK_LEVELS; ++r )
+        {
+            vector_empty( block->members[r] );
+        }
+
+        for( i = 0; i < count; ++i )
+        {
+            block->rung[i] = 0;
+            block->slot[i] = i;
+            vector_push_back( block->members[0], &i );
+        }
+
+        block->body_count = count;
+    }
+
+    for( i = 0; i < count; ++i )
+    {
+        block_set_rung( block, i, block_desired_rung( sim, i, level_count ) );
+    }
+}
+
+static void block_half_kick
+    (
+        sim_type          * sim,
+        block_state_type  * block,
+        uint32_t const    * indices,
+        uint32_t            count
+    )
+{
+    particle_store_type   * store;
+    float_t                 half_dt[SIM_INTEGRATOR_MAX_BLOCK_LEVELS];
+    float_t                 dt;
+    uint32_t                index;
+    uint32_t                i;
+    uint32_t                r;
+
+    store   = sim->particles;
+    dt      = 0.5f * sim->config.time_step;
+
+    for( r = 0; r < SIM_INTEGRATOR_MAX_BLOCK_LEVELS; ++r )
+    {
+        half_dt[r] = dt;
+        dt *= 0.5f;
+    }
+
+    for( i = 0; i < count; ++i )
+    {
+        index = ( NULL != indices ) ? indices[i] : i;
+        dt    = half_dt[block->rung[index]];
+
+        store->velocity_x[index] += store->acceleration_x[index] * dt;
+        store->velocity_y[index] += store->acceleration_y[index] * dt;
+        store->velocity_z[index] += store->acceleration_z[index] * dt;
+    }
+}
+
+static void block_drift
+    (
+        sim_type          * sim,
+        block_state_type  * block,
+        uint32_t const    * indices,
+        uint32_t            count,
+        float_t             time
+    )
+{
+    particle_store_type   * store;
+    float_t                 dt;
+    uint32_t                index;
+    uint32_t                i;
+
+    store = sim->particles;
+
+    for( i = 0; i < count; ++i )
+    {
+        index   = indices[i];
+        dt      = time - block->sync_time[index];
+
+        store->position_x[index] += store->velocity_x[index] * dt;
+        store->position_y[index] += store->velocity_y[index] * dt;
+        store->position_z[index] += store->velocity_z[index] * dt;
+
+        block->sync_time[index] = time;
+    }
+}
+
+static void kick
+    (
+        particle_store_type   * store,
+        float_t                 dt
+    )
+{
+    uint32_t i;
+
+    for( i = 0; i < store->count; ++i )
+    {
+        store->velocity_x[i] += store->acceleration_x[i] * dt;
+        store->velocity_y[i] += store->acceleration_y[i] * dt;
+        store->velocity_z[i] += store->acceleration_z[i] * dt;
+    }
+}
+
+static void drift
+    (
+        particle_store_type   * store,
+        float_t                 dt
+    )
+{
+    uint32_t i;
+
+    for( i = 0; i < store->count; ++i )
+    {
+        store->position_x[i] += store->velocity_x[i] * dt;
+        store->position_y[i] += store->velocity_y[i] * dt;
+        store->position_z[i] += store->velocity_z[i] * dt;
+    }
+}
+
+static void hermite4_reserve
+    (
+        hermite_state_type    * hermite,
+        uint32_t                count
+    )
+{
+    uint32_t axis;
+
+    if( count <= hermite->capacity )
+    {
+        return;
+    }
+
+    hermite->capacity   = count;
+    hermite->jerk_count = 0;
+
+    for( axis = 0; axis < AXIS_COUNT; ++axis )
+    {
+        free( hermite->position[axis] );
+        free( hermite->velocity[axis] );
+        free( hermite->acceleration[axis] );
+        free( hermite->jerk[axis] );
+        free( hermite->new_jerk[axis] );
+
+        hermite->position[axis]     = malloc( count * sizeof( float_t ) );
+        hermite->velocity[axis]     = malloc( count * sizeof( float_t ) );
+        hermite->acceleration[axis] = malloc( count * sizeof( float_t ) );
+        hermite->jerk[axis]         = malloc( count * sizeof( float_t ) );
+        hermite->new_jerk[axis]     = malloc( count * sizeof( float_t ) );
+    }
+}
@@ -0,0 +1,53 @@
+/**
+ * @file sim_integrator.h
+ *
+ * @brief Time integration of the particle state
+ */
+#ifndef SIM_INTEGRATOR_H
+#define SIM_INTEGRATOR_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define SIM_INTEGRATOR_MAX_BLOCK_LEVELS     ( 16 )  /* Finest block step is time_step / 2^15 */
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Set up the state of the integrator selected in the sim config
+ */
+void sim_integrator_init
+    (
+        sim_type * sim
+    );
+
+/**
+ * @brief Free the state of the integrator
+ */
+void sim_integrator_deinit
+    (
+        sim_type * sim
+    );
+
+/**
+ * @brief Advance every particle by one time step of the sim config
+ *        with the integrator selected in the sim config.
+ *
+ * Every scheme leaves positions and velocities synchronised at the end
+ * of the step, so the energy can be measured between any two steps.
+ */
+void sim_integrator_step
+    (
+        sim_type * sim
+    );
+
+#endif /* SIM_INTEGRATOR_H */
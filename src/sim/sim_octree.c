@@ -0,0 +1,447 @@
+/**
+ * @file sim_octree.c
+ *
+ * @brief Implementation of the particle octree
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_octree.h"
+#include "common_util.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define SIM_OCTREE_DEFAULT_NODE_COUNT   ( 1024 )
+#define SIM_OCTREE_GROWTH_FACTOR        ( 2 )
+#define SIM_OCTREE_ROOT_PADDING         ( 1.001f ) /* Keeps bodies on the bounding box edge strictly inside the root */
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Make sure the per body arrays can hold count bodies
+ */
+static void reserve_bodies
+    (
+        sim_octree_type   * tree,
+        uint32_t            count
+    );
+
+/**
+ * @brief Append count nodes to the node array
+ *
+ * @return The index of the first new node
+ */
+static uint32_t allocate_nodes
+    (
+        sim_octree_type   * tree,
+        uint32_t            count
+    );
+
+/**
+ * @brief Size the root node to enclose every body
+ */
+static void build_root
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store
+    );
+
+/**
+ * @brief Split a node into octants until every leaf is small enough
+ */
+static void build_node
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store,
+        uint32_t                    node_index,
+        uint32_t                    depth,
+        uint32_t                    leaf_capacity
+    );
+
+/**
+ * @brief Compute the mass, centre of mass and radius of every node, bottom up
+ */
+static void compute_mass_distribution
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store
+    );
+
+/**
+ * @brief Copy the positions and masses into body_order
+ */
+static void sort_bodies
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+sim_octree_type * sim_octree_create
+    (
+        void
+    )
+{
+    sim_octree_type * tree;
+
+    tree = calloc( 1, sizeof( sim_octree_type ) );
+
+    tree->node_capacity = SIM_OCTREE_DEFAULT_NODE_COUNT;
+    tree->nodes         = malloc( tree->node_capacity * sizeof( sim_octree_node_type ) );
+
+    return tree;
+}
+
+void sim_octree_free
+    (
+        sim_octree_type * tree
+    )
+{
+    free( tree->nodes );
+    free( tree->body_order );
+    free( tree->body_scratch );
+    free( tree->body_octant );
+    free( tree->sorted.position_x );
+    free( tree->sorted.position_y );
+    free( tree->sorted.position_z );
+    free( tree->sorted.mass );
+    free( tree );
+}
+
+void sim_octree_build
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store,
+        uint32_t                    leaf_capacity
+    )
+{
+    ASSERT( store->count > 0 );
+
+    reserve_bodies( tree, store->count );
+    build_root( tree, store );
+    build_node( tree, store, 0, 0, MAX( leaf_capacity, 1 ) );
+
+    compute_mass_distribution( tree, store );
+    sort_bodies( tree, store );
+}
+
+static void reserve_bodies
+    (
+        sim_octree_type   * tree,
+        uint32_t            count
+    )
+{
+    if( count <= tree->body_capacity )
+    {
+        return;
+    }
+
+    free( tree->body_order );
+    free( tree->body_scratch );
+    free( tree->body_octant );
+    free( tree->sorted.position_x );
+    free( tree->sorted.position_y );
+    free( tree->sorted.position_z );
+    free( tree->sorted.mass );
+
+    tree->body_capacity         = count;
+    tree->body_order            = malloc( count * sizeof( uint32_t ) );
+    tree->body_scratch          = malloc( count * sizeof( uint32_t ) );
+    tree->body_octant           = malloc( count * sizeof( uint8_t ) );
+    tree->sorted.position_x     = malloc( count * sizeof( float_t ) );
+    tree->sorted.position_y     = malloc( count * sizeof( float_t ) );
+    tree->sorted.position_z     = malloc( count * sizeof( float_t ) );
+    tree->sorted.mass           = malloc( count * sizeof( float_t ) );
+}
+
+static uint32_t allocate_nodes
+    (
+        sim_octree_type   * tree,
+        uint32_t            count
+    )
+{
+    uint32_t first;
+
+    while( tree->node_count + count > tree->node_capacity )
+    {
+        tree->node_capacity *= SIM_OCTREE_GROWTH_FACTOR;
+        tree->nodes = realloc( tree->nodes, tree->node_capacity * sizeof( sim_octree_node_type ) );
+        ASSERT( NULL != tree->nodes );
+    }
+
+    first = tree->node_count;
+    tree->node_count += count;
+
+    return first;
+}
+
+static void build_root
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store
+    )
+{
+    uint32_t                i;
+    float_t                 min_x;
+    float_t                 min_y;
+    float_t                 min_z;
+    float_t                 max_x;
+    float_t                 max_y;
+    float_t                 max_z;
+    sim_octree_node_type  * root;
+
+    min_x = max_x = store->position_x[0];
+    min_y = max_y = store->position_y[0];
+    min_z = max_z = store->position_z[0];
+
+    for( i = 0; i < store->count; ++i )
+    {
+        min_x = MIN( min_x, store->position_x[i] );
+        min_y = MIN( min_y, store->position_y[i] );
+        min_z = MIN( min_z, store->position_z[i] );
+        max_x = MAX( max_x, store->position_x[i] );
+        max_y = MAX( max_y, store->position_y[i] );
+        max_z = MAX( max_z, store->position_z[i] );
+
+        tree->body_order[i] = i;
+    }
+
+    tree->node_count = 0;
+    root = &tree->nodes[allocate_nodes( tree, 1 )];
+
+    root->centre_x      = 0.5f * ( min_x + max_x );
+    root->centre_y      = 0.5f * ( min_y + max_y );
+    root->centre_z      = 0.5f * ( min_z + max_z );
+    root->half_size     = 0.5f * SIM_OCTREE_ROOT_PADDING * MAX( MAX( max_x - min_x, max_y - min_y ), max_z - min_z );
+    root->first_child   = SIM_OCTREE_NO_CHILDREN;
+    root->first_body    = 0;
+    root->body_count    = store->count;
+}
+
+static void build_node
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store,
+        uint32_t                    node_index,
+        uint32_t                    depth,
+        uint32_t                    leaf_capacity
+    )
+{
+    sim_octree_node_type    node;
+    sim_octree_node_type  * child;
+    uint32_t                counts[SIM_OCTREE_CHILD_COUNT];
+    uint32_t                offsets[SIM_OCTREE_CHILD_COUNT];
+    uint32_t                first_child;
+    uint32_t                i;
+    uint32_t                body;
+    uint8_t                 octant;
+    float_t                 quarter_size;
+
+    /* Work on a copy, allocating children may move the node array */
+    node = tree->nodes[node_index];
+
+    if( ( node.body_count <= leaf_capacity ) || ( depth >= SIM_OCTREE_MAX_DEPTH ) )
+    {
+        return;
+    }
+
+    /* Counting sort the node's bodies by octant, bit 0 = +x, bit 1 = +y, bit 2 = +z */
+    memset( counts, 0, sizeof( counts ) );
+
+    for( i = node.first_body; i < node.first_body + node.body_count; ++i )
+    {
+        body = tree->body_order[i];
+        octant = ( store->position_x[body] >= node.centre_x ? 1 : 0 ) |
+                 ( store->position_y[body] >= node.centre_y ? 2 : 0 ) |
+                 ( store->position_z[body] >= node.centre_z ? 4 : 0 );
+
+        tree->body_octant[i] = octant;
+        counts[octant] += 1;
+    }
+
+    offsets[0] = node.first_body;
+    for( i = 1; i < SIM_OCTREE_CHILD_COUNT; ++i )
+    {
+        offsets[i] = offsets[i - 1] + counts[i - 1];
+    }
+
+    for( i = node.first_body; i < node.first_body + node.body_count; ++i )
+    {
+        tree->body_scratch[offsets[tree->body_octant[i]]++] = tree->body_order[i];
+    }
+
+    memcpy( &tree->body_order[node.first_body], &tree->body_scratch[node.first_body], node.body_count * sizeof( uint32_t ) );
+
+    /* Create the children */
+    first_child = allocate_nodes( tree, SIM_OCTREE_CHILD_COUNT );
+    tree->nodes[node_index].first_child = first_child;
+
+    quarter_size = 0.5f * node.half_size;
+    body = node.first_body;
+
+    for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+    {
+        child = &tree->nodes[first_child + i];
+
+        child->centre_x     = node.centre_x + ( ( i & 1 ) ? quarter_size : -quarter_size );
+        child->centre_y     = node.centre_y + ( ( i & 2 ) ? quarter_size : -quarter_size );
+        child->centre_z     = node.centre_z + ( ( i & 4 ) ? quarter_size : -quarter_size );
+        child->half_size    = quarter_size;
+        child->first_child  = SIM_OCTREE_NO_CHILDREN;
+        child->first_body   = body;
+        child->body_count   = counts[i];
+
+        body += counts[i];
+    }
+
+    for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+    {
+        if( counts[i] > 0 )
+        {
+            build_node( tree, store, first_child + i, depth + 1, leaf_capacity );
+        }
+    }
+}
+
+static void compute_mass_distribution
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store
+    )
+{
+    uint32_t                n;
+    uint32_t                i;
+    uint32_t                body;
+    sim_octree_node_type  * node;
+    sim_octree_node_type  * child;
+    double_t                mass;
+    double_t                moment_x;
+    double_t                moment_y;
+    double_t                moment_z;
+    float_t                 dx;
+    float_t                 dy;
+    float_t                 dz;
+    float_t                 radius_sq;
+
+    /* Children are always allocated after their parent, so a reverse sweep is bottom up */
+    for( n = tree->node_count; n > 0; --n )
+    {
+        node = &tree->nodes[n - 1];
+
+        mass     = 0.0;
+        moment_x = 0.0;
+        moment_y = 0.0;
+        moment_z = 0.0;
+
+        if( SIM_OCTREE_NO_CHILDREN == node->first_child )
+        {
+            for( i = node->first_body; i < node->first_body + node->body_count; ++i )
+            {
+                body = tree->body_order[i];
+
+                mass     += store->mass[body];
+                moment_x += store->mass[body] * store->position_x[body];
+                moment_y += store->mass[body] * store->position_y[body];
+                moment_z += store->mass[body] * store->position_z[body];
+            }
+        }
+        else
+        {
+            for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+            {
+                child = &tree->nodes[node->first_child + i];
+
+                mass     += child->mass;
+                moment_x += child->mass * child->com_x;
+                moment_y += child->mass * child->com_y;
+                moment_z += child->mass * child->com_z;
+            }
+        }
+
+        node->mass = (float_t)mass;
+
+        if( mass > 0.0 )
+        {
+            node->com_x = (float_t)( moment_x / mass );
+            node->com_y = (float_t)( moment_y / mass );
+            node->com_z = (float_t)( moment_z / mass );
+        }
+        else
+        {
+            node->com_x = node->centre_x;
+            node->com_y = node->centre_y;
+            node->com_z = node->centre_z;
+        }
+
+        /* Radius is exact for leaves, and a bound built from the children otherwise */
+        node->radius = 0.0f;
+
+        if( SIM_OCTREE_NO_CHILDREN == node->first_child )
+        {
+            radius_sq = 0.0f;
+
+            for( i = node->first_body; i < node->first_body + node->body_count; ++i )
+            {
+                body = tree->body_order[i];
+
+                dx = store->position_x[body] - node->com_x;
+                dy = store->position_y[body] - node->com_y;
+                dz = store->position_z[body] - node->com_z;
+
+                radius_sq = MAX( radius_sq, dx * dx + dy * dy + dz * dz );
+            }
+
+            node->radius = (float_t)sqrt( radius_sq );
+        }
+        else
+        {
+            for( i = 0; i < SIM_OCTREE_CHILD_COUNT; ++i )
+            {
+                child = &tree->nodes[node->first_child + i];
+
+                if( 0 == child->body_count )
+                {
+                    continue;
+                }
+
+                dx = child->com_x - node->com_x;
+                dy = child->com_y - node->com_y;
+                dz = child->com_z - node->com_z;
+
+                node->radius = MAX( node->radius, (float_t)sqrt( dx * dx + dy * dy + dz * dz ) + child->radius );
+            }
+        }
+    }
+}
+
+static void sort_bodies
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store
+    )
+{
+    uint32_t i;
+    uint32_t body;
+
+    for( i = 0; i < store->count; ++i )
+    {
+        body = tree->body_order[i];
+
+        tree->sorted.position_x[i]  = store->position_x[body];
+        tree->sorted.position_y[i]  = store->position_y[body];
+        tree->sorted.position_z[i]  = store->position_z[body];
+        tree->sorted.mass[i]        = store->mass[body];
+    }
+}
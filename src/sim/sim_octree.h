@@ -0,0 +1,102 @@
+/**
+ * @file sim_octree.h
+ *
+ * @brief Octree over the particle store, shared by the tree based force solvers
+ *
+ * The tree is rebuilt from scratch every force pass into a flat node
+ * array that is reused between passes, nodes refer to each other by index.
+ * Children are always stored after their parent, so a forward sweep over
+ * the nodes is top down and a reverse sweep is bottom up.
+ */
+#ifndef SIM_OCTREE_H
+#define SIM_OCTREE_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define SIM_OCTREE_CHILD_COUNT      ( 8 )
+#define SIM_OCTREE_MAX_DEPTH        ( 32 )  /* Stops coincident bodies splitting forever */
+#define SIM_OCTREE_NO_CHILDREN      ( 0 )   /* Node 0 is the root, so it is never another node's child */
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/**
+ * @brief One cube of the octree
+ */
+typedef struct sim_octree_node_struct
+{
+    float_t     centre_x;
+    float_t     centre_y;
+    float_t     centre_z;
+    float_t     half_size;
+    float_t     com_x;          /* Centre of mass */
+    float_t     com_y;
+    float_t     com_z;
+    float_t     com_velocity_x; /* Mass weighted mean velocity, not set by the build, for solvers that move the tree */
+    float_t     com_velocity_y;
+    float_t     com_velocity_z;
+    float_t     mass;
+    float_t     radius;         /* Bounds the distance from the centre of mass to any body in the node */
+    uint32_t    first_child;    /* Index of 8 consecutive child nodes, SIM_OCTREE_NO_CHILDREN for a leaf */
+    uint32_t    first_body;     /* Bodies of the node are body_order[first_body, first_body + body_count) */
+    uint32_t    body_count;
+} sim_octree_node_type;
+
+/**
+ * @brief Tree storage
+ */
+typedef struct sim_octree_struct
+{
+    sim_octree_node_type  * nodes;
+    uint32_t                node_count;
+    uint32_t                node_capacity;
+    uint32_t              * body_order;     /* Particle indices, sorted so every node's bodies are contiguous */
+    sim_force_sources_type  sorted;         /* Positions and masses copied in body_order, for the direct kernels */
+    uint32_t              * body_scratch;
+    uint8_t               * body_octant;
+    uint32_t                body_capacity;
+} sim_octree_type;
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocate an empty tree
+ */
+sim_octree_type * sim_octree_create
+    (
+        void
+    );
+
+/**
+ * @brief Free a tree
+ */
+void sim_octree_free
+    (
+        sim_octree_type * tree
+    );
+
+/**
+ * @brief Rebuild the tree over the current positions, including the
+ *        mass, centre of mass and radius of every node and the sorted copy of the bodies.
+ *
+ * @note The store must not be empty.
+ */
+void sim_octree_build
+    (
+        sim_octree_type           * tree,
+        particle_store_type const * store,
+        uint32_t                    leaf_capacity /* Nodes with this many bodies or less are not split */
+    );
+
+#endif /* SIM_OCTREE_H */
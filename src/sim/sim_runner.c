@@ -0,0 +1,250 @@
+/**
+ * @file sim_runner.c
+ *
+ * @brief Implementation of the simulation runner thread
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+/* Needed for the monotonic clock and nanosleep, must come before any system header */
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 199309L
+#endif
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#include "sim_runner.h"
+#include "sim.h"
+#include "common_util.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+struct sim_runner_struct
+{
+    sim_type              * sim;
+    triple_buffer_type    * snapshots;      /* sim_snapshot_type */
+    pthread_t               thread;
+    double_t                step_interval;  /* s, 0 when unpaced */
+    uint32_t                stop;           /* Only accessed atomically */
+};
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Entry point of the runner thread
+ */
+static void * runner_main
+    (
+        void * argument
+    );
+
+/**
+ * @brief Copy the simulation state into the next snapshot and publish it
+ */
+static void publish_snapshot
+    (
+        sim_runner_type * runner
+    );
+
+/**
+ * @brief Seconds from an arbitrary fixed point
+ */
+static double_t monotonic_time
+    (
+        void
+    );
+
+/**
+ * @brief Sleep the calling thread
+ */
+static void sleep_seconds
+    (
+        double_t seconds
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+sim_runner_type * sim_runner_create
+    (
+        sim_type  * sim,
+        double_t    steps_per_second
+    )
+{
+    sim_runner_type   * runner;
+    sim_snapshot_type * snapshot;
+    uint32_t            count;
+    uint32_t            i;
+    int                 status;
+
+    runner = calloc( 1, sizeof( sim_runner_type ) );
+
+    runner->sim             = sim;
+    runner->snapshots       = triple_buffer_create( sizeof( sim_snapshot_type ) );
+    runner->step_interval   = ( steps_per_second > 0.0 ) ? 1.0 / steps_per_second : 0.0;
+
+    /* Bodies can't be added or removed while the runner owns the sim, so the snapshot size is fixed */
+    count = sim_particle_count( sim );
+    for( i = 0; i < TRIPLE_BUFFER_ITEM_COUNT; ++i )
+    {
+        snapshot = (sim_snapshot_type *)triple_buffer_item( runner->snapshots, i );
+
+        snapshot->count         = count;
+        snapshot->position_x    = malloc( MAX( 1, count ) * sizeof( float_t ) );
+        snapshot->position_y    = malloc( MAX( 1, count ) * sizeof( float_t ) );
+        snapshot->position_z    = malloc( MAX( 1, count ) * sizeof( float_t ) );
+    }
+
+    /* Readers have the starting state straight away */
+    publish_snapshot( runner );
+
+    status = pthread_create( &runner->thread, NULL, runner_main, runner );
+    ASSERT( 0 == status );
+
+    return runner;
+}
+
+void sim_runner_free
+    (
+        sim_runner_type * runner
+    )
+{
+    sim_snapshot_type * snapshot;
+    uint32_t            i;
+
+    __atomic_store_n( &runner->stop, TRUE, __ATOMIC_RELEASE );
+    pthread_join( runner->thread, NULL );
+
+    for( i = 0; i < TRIPLE_BUFFER_ITEM_COUNT; ++i )
+    {
+        snapshot = (sim_snapshot_type *)triple_buffer_item( runner->snapshots, i );
+
+        free( snapshot->position_x );
+        free( snapshot->position_y );
+        free( snapshot->position_z );
+    }
+
+    triple_buffer_free( runner->snapshots );
+    free( runner );
+}
+
+triple_buffer_type * sim_runner_snapshots
+    (
+        sim_runner_type * runner
+    )
+{
+    return runner->snapshots;
+}
+
+static void * runner_main
+    (
+        void * argument
+    )
+{
+    sim_runner_type   * runner;
+    double_t            deadline;
+    double_t            now;
+
+    runner      = (sim_runner_type *)argument;
+    deadline    = monotonic_time();
+
+    while( !__atomic_load_n( &runner->stop, __ATOMIC_ACQUIRE ) )
+    {
+        sim_step( runner->sim );
+        publish_snapshot( runner );
+
+        if( runner->step_interval > 0.0 )
+        {
+            /* Keep to the rate on average, but don't race to catch up after a slow step */
+            deadline   += runner->step_interval;
+            now         = monotonic_time();
+
+            if( deadline > now )
+            {
+                sleep_seconds( deadline - now );
+            }
+            else
+            {
+                deadline = now;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void publish_snapshot
+    (
+        sim_runner_type * runner
+    )
+{
+    sim_snapshot_type     * snapshot;
+    particle_store_type   * store;
+
+    snapshot    = (sim_snapshot_type *)triple_buffer_write_item( runner->snapshots );
+    store       = runner->sim->particles;
+
+    ASSERT( store->count == snapshot->count );
+
+    snapshot->time          = runner->sim->time;
+    snapshot->step_count    = runner->sim->step_count;
+
+    memcpy( snapshot->position_x, store->position_x, store->count * sizeof( float_t ) );
+    memcpy( snapshot->position_y, store->position_y, store->count * sizeof( float_t ) );
+    memcpy( snapshot->position_z, store->position_z, store->count * sizeof( float_t ) );
+
+    triple_buffer_publish( runner->snapshots );
+}
+
+static double_t monotonic_time
+    (
+        void
+    )
+{
+#if defined( _WIN32 )
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &counter );
+
+    return (double_t)counter.QuadPart / (double_t)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return (double_t)now.tv_sec + (double_t)now.tv_nsec * 1e-9;
+#endif
+}
+
+static void sleep_seconds
+    (
+        double_t seconds
+    )
+{
+#if defined( _WIN32 )
+    Sleep( (DWORD)( seconds * 1000.0 ) );
+#else
+    struct timespec duration;
+
+    duration.tv_sec     = (time_t)seconds;
+    duration.tv_nsec    = (long)( ( seconds - (double_t)duration.tv_sec ) * 1e9 );
+
+    nanosleep( &duration, NULL );
+#endif
+}
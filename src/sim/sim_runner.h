@@ -0,0 +1,80 @@
+/**
+ * @file sim_runner.h
+ *
+ * @brief Steps a simulation on its own thread and publishes snapshots of it
+ *
+ * The runner thread owns the simulation from sim_runner_create until
+ * sim_runner_free, nothing else may touch it in between. Every completed
+ * step is copied into a triple buffer of sim_snapshot_type, so a reader
+ * such as the renderer always finds the latest state without waiting for
+ * a step, and a slow step never holds up the reader.
+ */
+#ifndef SIM_RUNNER_H
+#define SIM_RUNNER_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+#include "triple_buffer.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define SIM_RUNNER_UNPACED      ( 0.0 )     /* Step as fast as possible */
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/**
+ * @brief The state of the simulation after a step
+ */
+typedef struct sim_snapshot_struct
+{
+    double_t    time;
+    uint32_t    step_count;
+    uint32_t    count;
+    float_t   * position_x;     /* In dense index order, which is handle order while no body has been removed */
+    float_t   * position_y;
+    float_t   * position_z;
+} sim_snapshot_type;
+
+/* Runner type, should only be accessed with interface functions below */
+typedef struct sim_runner_struct sim_runner_type;
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Publish the current state of a simulation and start stepping it
+ *        on a new thread
+ */
+sim_runner_type * sim_runner_create
+    (
+        sim_type  * sim,
+        double_t    steps_per_second    /* Cap on the step rate, SIM_RUNNER_UNPACED for none */
+    );
+
+/**
+ * @brief Stop the runner thread after its current step and delete the runner,
+ *        the simulation belongs to the caller again
+ */
+void sim_runner_free
+    (
+        sim_runner_type * runner
+    );
+
+/**
+ * @brief Get the triple buffer of sim_snapshot_type the runner publishes to,
+ *        for one reader thread
+ */
+triple_buffer_type * sim_runner_snapshots
+    (
+        sim_runner_type * runner
+    );
+
+#endif /* SIM_RUNNER_H */
@@ -0,0 +1,77 @@
+/**
+ * @file sim_setup.c
+ *
+ * @brief Implementation of the initial condition generators
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_setup.h"
+#include "sim.h"
+#include <stdlib.h>
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Get a uniformly distributed random number in [-1, 1]
+ */
+static float_t random_unit
+    (
+        void
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+void sim_setup_uniform_sphere
+    (
+        sim_type            * sim,
+        uint32_t              count,
+        sim_vec3_type const * centre,
+        float_t               radius,
+        float_t               total_mass,
+        uint32_t              seed
+    )
+{
+    uint32_t        i;
+    sim_vec3_type   position;
+    sim_vec3_type   velocity;
+    sim_vec3_type   offset;
+
+    srand( seed );
+    sim_reserve( sim, sim_particle_count( sim ) + count );
+
+    velocity.x = 0.0f;
+    velocity.y = 0.0f;
+    velocity.z = 0.0f;
+
+    for( i = 0; i < count; ++i )
+    {
+        /* Rejection sample the unit ball */
+        do
+        {
+            offset.x = random_unit();
+            offset.y = random_unit();
+            offset.z = random_unit();
+        } while( offset.x * offset.x + offset.y * offset.y + offset.z * offset.z > 1.0f );
+
+        position.x = centre->x + offset.x * radius;
+        position.y = centre->y + offset.y * radius;
+        position.z = centre->z + offset.z * radius;
+
+        sim_add_particle( sim, &position, &velocity, total_mass / count );
+    }
+}
+
+static float_t random_unit
+    (
+        void
+    )
+{
+    return 2.0f * ( (float_t)rand() / (float_t)RAND_MAX ) - 1.0f;
+}
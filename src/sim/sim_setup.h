@@ -0,0 +1,36 @@
+/**
+ * @file sim_setup.h
+ *
+ * @brief Initial condition generators for the simulation
+ */
+#ifndef SIM_SETUP_H
+#define SIM_SETUP_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "sim_types.h"
+
+/**********************************************************************
+                              PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Add count bodies of equal mass, uniformly distributed inside a
+ *        sphere and at rest (a cold collapse).
+ *
+ * @note The generator is seeded, so the same arguments always produce
+ *       the same initial state.
+ */
+void sim_setup_uniform_sphere
+    (
+        sim_type            * sim,
+        uint32_t              count,
+        sim_vec3_type const * centre,
+        float_t               radius,
+        float_t               total_mass,
+        uint32_t              seed
+    );
+
+#endif /* SIM_SETUP_H */
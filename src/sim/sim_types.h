@@ -0,0 +1,129 @@
+/**
+ * @file sim_types.h
+ *
+ * @brief Type defs for the headless gravity simulation
+ *
+ * @note Nothing in the sim unit may depend on openGL or GLFW, so it
+ *       can be built and run on machines without a display.
+ */
+#ifndef SIM_TYPES_H
+#define SIM_TYPES_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+#include "particle_store.h"
+#include "thread_pool.h"
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/**
+ * @brief A point or direction in simulation space
+ */
+typedef struct sim_vec3_struct
+{
+    float_t x;
+    float_t y;
+    float_t z;
+} sim_vec3_type;
+
+/**
+ * @brief Algorithms available to compute gravitational accelerations
+ */
+typedef uint8_t sim_force_solver_t8; enum
+{
+    SIM_FORCE_SOLVER_DIRECT,        /* Exact all pairs summation, O(N^2) */
+    SIM_FORCE_SOLVER_BARNES_HUT,    /* Octree approximation, O(N log N), accuracy set by opening_angle */
+    SIM_FORCE_SOLVER_FMM,           /* Fast multipole method, O(N), accuracy set by opening_angle and expansion_order */
+
+    SIM_FORCE_SOLVER_COUNT
+};
+
+/**
+ * @brief Schemes available to advance the particles in time
+ */
+typedef uint8_t sim_integrator_t8; enum
+{
+    SIM_INTEGRATOR_EULER,           /* Semi-implicit Euler, 1st order symplectic, one force pass per step */
+    SIM_INTEGRATOR_LEAPFROG,        /* Kick-drift-kick leapfrog, 2nd order symplectic, one force pass per step */
+    SIM_INTEGRATOR_YOSHIDA4,        /* Yoshida's triple leapfrog composition, 4th order symplectic, three force passes per step */
+    SIM_INTEGRATOR_HERMITE4,        /* Predictor-corrector on acceleration and jerk, 4th order, one direct summation pass per step */
+    SIM_INTEGRATOR_BLOCK_LEAPFROG,  /* Leapfrog with individual power of two block steps, only bodies due a kick drift and get a force pass. Direct or Barnes-Hut only */
+
+    SIM_INTEGRATOR_COUNT
+};
+
+/**
+ * @brief Parameters that control a simulation run
+ */
+typedef struct sim_config_struct
+{
+    float_t                 gravitational_constant;
+    float_t                 softening;          /* Plummer softening length, keeps close encounters finite */
+    float_t                 time_step;          /* Simulation time advanced by each call to sim_step */
+    sim_force_solver_t8     force_solver;
+    sim_integrator_t8       integrator;         /* Hermite always uses direct summation, it needs the pairwise jerk */
+    uint8_t                 block_levels;       /* Block steps, number of rungs. Rung r steps by time_step / 2^r */
+    float_t                 time_step_accuracy; /* Block steps, eta in dt = eta * sqrt( softening / |a| ) */
+    float_t                 opening_angle;      /* Tree solver theta. Barnes-Hut uses a node whole when size / distance < theta,
+                                                   FMM interacts two nodes by expansion when ( radius + radius ) / distance < theta */
+    uint32_t                leaf_capacity;      /* Tree solvers stop splitting nodes with this many bodies or less */
+    uint8_t                 expansion_order;    /* FMM multipole and local expansion order, higher is more accurate and slower */
+    uint32_t                worker_count;       /* Threads used by the force pass including the caller, THREAD_POOL_WORKERS_AUTO for one per core */
+    boolean                 pin_workers;        /* Pin each force worker to its own core */
+} sim_config_type;
+
+/**
+ * @brief Accuracy of the configured force solver relative to direct summation
+ */
+typedef struct sim_force_error_struct
+{
+    double_t    rms_relative_error;
+    double_t    max_relative_error;
+    uint32_t    sample_count;       /* Number of bodies the error was measured over */
+} sim_force_error_type;
+
+/**
+ * @brief Positions and masses of a run of bodies, the sources the direct summation kernels read
+ */
+typedef struct sim_force_sources_struct
+{
+    float_t   * position_x;
+    float_t   * position_y;
+    float_t   * position_z;
+    float_t   * mass;
+} sim_force_sources_type;
+
+/**
+ * @brief Where the bodies are part way through a block step
+ *
+ * Only the bodies due a kick are drifted, so each stored position is at its
+ * own body's sync time. The other bodies are predicted to the force time as
+ * x + v * ( time - sync_time ).
+ */
+typedef struct sim_force_prediction_struct
+{
+    float_t const * sync_time;  /* Per body, the time its stored position and velocity are at */
+    float_t         time;       /* Time the forces are evaluated at, on the same clock as sync_time */
+} sim_force_prediction_type;
+
+/**
+ * @brief A simulation instance, should only be accessed with the interface in sim.h
+ */
+typedef struct sim_struct
+{
+    sim_config_type       config;
+    particle_store_type * particles;
+    void                * force_state;  /* Private state of the configured force solver */
+    void                * integrator_state; /* Private state of the configured integrator */
+    thread_pool_type    * pool;         /* Workers for the force pass */
+    double_t              time;
+    uint32_t              step_count;
+    boolean               accelerations_valid; /* FALSE when particles changed since the last force pass */
+} sim_type;
+
+#endif /* SIM_TYPES_H */
@@ -0,0 +1,33 @@
+/**
+ * @file test_main.c
+ *
+ * @brief Entry point to the test build, runs the test suites of the units
+ *        with no openGL dependencies.
+ *
+ * Usage: make test HEADLESS=1
+ */
+
+#include    "vector_test.h"
+#include    "thread_pool_test.h"
+#include    "sim_force_test.h"
+#include    <stdio.h>
+
+int main
+    (
+        void
+    )
+{
+    uint32_t failures;
+
+    failures = 0;
+
+    /* Prints its results to be checked by eye */
+    vector_tests_run();
+
+    failures += thread_pool_tests_run() ? 0 : 1;
+    failures += sim_force_tests_run() ? 0 : 1;
+
+    printf( "%d test suite(s) failed\n", failures );
+
+    return ( 0 == failures ) ? 0 : 1;
+}
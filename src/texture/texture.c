@@ -33,6 +33,7 @@ texture_type* texture_init
     texture->slot = slot;
     texture->shader = shader;
     texture->uniform_name = uniform_name;
+    texture->uniform = shader_get_uniform( shader, uniform_name );
 
     /* use soil to load the image data */
     image = SOIL_load_image( image_filename, &width, &height, 0, SOIL_LOAD_RGBA);
@@ -70,7 +71,7 @@ void texture_use
 {
     glActiveTexture( texture->slot );
     glBindTexture( GL_TEXTURE_2D,  texture->texture_id );
-    shader_set_uniform_uint32( texture->shader, texture->uniform_name, texture->slot - GL_TEXTURE0 );
+    shader_set_uniform_uint32_handle( texture->uniform, texture->slot - GL_TEXTURE0 );
 }
 
 void texture_clear
@@ -25,6 +25,7 @@ typedef struct texture_struct
     GLuint          slot;
     shader_type   * shader;
     sint8_t const * uniform_name;
+    shader_uniform_type uniform;    /* Resolved from uniform_name when the texture is made */
 } texture_type;
 
 /**********************************************************************
@@ -0,0 +1,477 @@
+/**
+ * @file thread_pool.c
+ *
+ * @brief Implementation of the work stealing thread pool
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+/* Needed for the affinity calls, must come before any system header */
+#ifdef __linux__
+    #define _GNU_SOURCE
+#endif
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+#include "thread_pool.h"
+#include "common_util.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define THREAD_POOL_TASKS_PER_WORKER    ( 8 )   /* Auto grain target, spare tasks are what thieves take */
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+/**
+ * @brief One contiguous slice of a parallel loop
+ */
+typedef struct task_struct
+{
+    thread_pool_task_cb     task_cb;
+    void                  * user_data;
+    uint32_t                first;
+    uint32_t                last;
+} task_type;
+
+/**
+ * @brief A worker and its deque, tasks[top, bottom) are pending
+ */
+typedef struct worker_struct
+{
+    thread_pool_type      * pool;
+    pthread_t               thread;
+    pthread_mutex_t         lock;
+    task_type             * tasks;
+    uint32_t                task_capacity;
+    uint32_t                top;            /* Thieves take from here */
+    uint32_t                bottom;         /* The owner pops from here */
+    uint32_t                index;
+} worker_type;
+
+struct thread_pool_struct
+{
+    worker_type           * workers;
+    uint32_t                worker_count;
+    boolean                 pin_workers;
+    boolean                 issuer_pinned;  /* issuer is on core 0, only touched by the issuing thread */
+    pthread_t               issuer;
+    pthread_mutex_t         lock;           /* Protects everything below */
+    pthread_cond_t          work_ready;
+    pthread_cond_t          work_done;
+    uint32_t                generation;     /* Bumped for every parallel loop */
+    uint32_t                pending_tasks;
+    boolean                 shutdown;
+};
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Entry point of the worker threads
+ */
+static void * worker_main
+    (
+        void * argument
+    );
+
+/**
+ * @brief Run tasks, own first then stolen, until none are left
+ */
+static void run_tasks
+    (
+        worker_type * worker
+    );
+
+/**
+ * @brief Take a task from the back of the worker's own deque
+ */
+static boolean pop_task
+    (
+        worker_type * worker,
+        task_type   * task /* [out] */
+    );
+
+/**
+ * @brief Take a task from the front of another worker's deque
+ */
+static boolean steal_task
+    (
+        worker_type * victim,
+        task_type   * task /* [out] */
+    );
+
+/**
+ * @brief Pin the calling thread to a core
+ */
+static void pin_to_core
+    (
+        uint32_t core
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+thread_pool_type * thread_pool_create
+    (
+        uint32_t    worker_count,
+        boolean     pin_workers
+    )
+{
+    thread_pool_type  * pool;
+    uint32_t            i;
+    int                 status;
+
+    pool = calloc( 1, sizeof( thread_pool_type ) );
+
+    pool->worker_count  = ( THREAD_POOL_WORKERS_AUTO == worker_count ) ? thread_pool_core_count() : worker_count;
+    pool->pin_workers   = pin_workers;
+    pool->workers       = calloc( pool->worker_count, sizeof( worker_type ) );
+
+    pthread_mutex_init( &pool->lock, NULL );
+    pthread_cond_init( &pool->work_ready, NULL );
+    pthread_cond_init( &pool->work_done, NULL );
+
+    for( i = 0; i < pool->worker_count; ++i )
+    {
+        pool->workers[i].pool   = pool;
+        pool->workers[i].index  = i;
+        pthread_mutex_init( &pool->workers[i].lock, NULL );
+    }
+
+    /* Worker 0 is whichever thread issues the work */
+    for( i = 1; i < pool->worker_count; ++i )
+    {
+        status = pthread_create( &pool->workers[i].thread, NULL, worker_main, &pool->workers[i] );
+        ASSERT( 0 == status );
+    }
+
+    return pool;
+}
+
+void thread_pool_free
+    (
+        thread_pool_type * pool
+    )
+{
+    uint32_t i;
+
+    pthread_mutex_lock( &pool->lock );
+    pool->shutdown = TRUE;
+    pthread_cond_broadcast( &pool->work_ready );
+    pthread_mutex_unlock( &pool->lock );
+
+    for( i = 1; i < pool->worker_count; ++i )
+    {
+        pthread_join( pool->workers[i].thread, NULL );
+    }
+
+    for( i = 0; i < pool->worker_count; ++i )
+    {
+        pthread_mutex_destroy( &pool->workers[i].lock );
+        free( pool->workers[i].tasks );
+    }
+
+    pthread_cond_destroy( &pool->work_done );
+    pthread_cond_destroy( &pool->work_ready );
+    pthread_mutex_destroy( &pool->lock );
+
+    free( pool->workers );
+    free( pool );
+}
+
+uint32_t thread_pool_worker_count
+    (
+        thread_pool_type const * pool
+    )
+{
+    return pool->worker_count;
+}
+
+void thread_pool_parallel_for
+    (
+        thread_pool_type    * pool,
+        uint32_t              count,
+        uint32_t              grain,
+        thread_pool_task_cb   task_cb,
+        void                * user_data
+    )
+{
+    worker_type   * worker;
+    uint32_t        task_count;
+    uint32_t        first_task;
+    uint32_t        last_task;
+    uint32_t        i;
+    uint32_t        t;
+    task_type     * task;
+
+    if( 0 == count )
+    {
+        return;
+    }
+
+    if( THREAD_POOL_GRAIN_AUTO == grain )
+    {
+        grain = MAX( 1, count / ( pool->worker_count * THREAD_POOL_TASKS_PER_WORKER ) );
+    }
+
+    task_count = ( count + grain - 1 ) / grain;
+
+    /* Not worth waking anyone */
+    if( ( 1 == pool->worker_count ) || ( 1 == task_count ) )
+    {
+        task_cb( user_data, 0, count, 0 );
+        return;
+    }
+
+    /*
+     * Worker 0 is whichever thread issues the work, which need not be the one
+     * that created the pool, so it is pinned here the first time it shows up
+     */
+    if( pool->pin_workers && ( !pool->issuer_pinned || !pthread_equal( pool->issuer, pthread_self() ) ) )
+    {
+        pin_to_core( 0 );
+        pool->issuer        = pthread_self();
+        pool->issuer_pinned = TRUE;
+    }
+
+    /*
+     * Count the tasks before any of them is visible. A worker still in run_tasks
+     * from the last loop can steal one as soon as it is pushed, and its decrement
+     * must not land on the old count of 0.
+     */
+    pthread_mutex_lock( &pool->lock );
+    pool->pending_tasks = task_count;
+    pthread_mutex_unlock( &pool->lock );
+
+    /*
+     * Every worker gets a contiguous block of tasks so neighbouring items stay
+     * on one core. Blocks are pushed in reverse, the owner pops them in
+     * ascending order while thieves take from the far end.
+     */
+    for( i = 0; i < pool->worker_count; ++i )
+    {
+        worker      = &pool->workers[i];
+        first_task  = (uint32_t)( (double_t)task_count * i / pool->worker_count );
+        last_task   = (uint32_t)( (double_t)task_count * ( i + 1 ) / pool->worker_count );
+
+        pthread_mutex_lock( &worker->lock );
+
+        if( last_task - first_task > worker->task_capacity )
+        {
+            free( worker->tasks );
+            worker->task_capacity   = last_task - first_task;
+            worker->tasks           = malloc( worker->task_capacity * sizeof( task_type ) );
+        }
+
+        worker->top     = 0;
+        worker->bottom  = 0;
+
+        for( t = last_task; t > first_task; --t )
+        {
+            task = &worker->tasks[worker->bottom++];
+
+            task->task_cb   = task_cb;
+            task->user_data = user_data;
+            task->first     = ( t - 1 ) * grain;
+            task->last      = MIN( count, t * grain );
+        }
+
+        pthread_mutex_unlock( &worker->lock );
+    }
+
+    pthread_mutex_lock( &pool->lock );
+    pool->generation += 1;
+    pthread_cond_broadcast( &pool->work_ready );
+    pthread_mutex_unlock( &pool->lock );
+
+    run_tasks( &pool->workers[0] );
+
+    pthread_mutex_lock( &pool->lock );
+    while( pool->pending_tasks > 0 )
+    {
+        pthread_cond_wait( &pool->work_done, &pool->lock );
+    }
+    pthread_mutex_unlock( &pool->lock );
+}
+
+uint32_t thread_pool_core_count
+    (
+        void
+    )
+{
+#if defined( _WIN32 )
+    SYSTEM_INFO info;
+
+    GetSystemInfo( &info );
+    return MAX( 1, info.dwNumberOfProcessors );
+#elif defined( _SC_NPROCESSORS_ONLN )
+    long count;
+
+    count = sysconf( _SC_NPROCESSORS_ONLN );
+    return ( count > 0 ) ? (uint32_t)count : 1;
+#else
+    return 1;
+#endif
+}
+
+static void * worker_main
+    (
+        void * argument
+    )
+{
+    worker_type       * worker;
+    thread_pool_type  * pool;
+    uint32_t            seen_generation;
+
+    worker  = (worker_type *)argument;
+    pool    = worker->pool;
+
+    if( pool->pin_workers )
+    {
+        pin_to_core( worker->index );
+    }
+
+    seen_generation = 0;
+
+    for( ;; )
+    {
+        pthread_mutex_lock( &pool->lock );
+        while( !pool->shutdown && ( seen_generation == pool->generation ) )
+        {
+            pthread_cond_wait( &pool->work_ready, &pool->lock );
+        }
+
+        seen_generation = pool->generation;
+
+        if( pool->shutdown )
+        {
+            pthread_mutex_unlock( &pool->lock );
+            break;
+        }
+        pthread_mutex_unlock( &pool->lock );
+
+        run_tasks( worker );
+    }
+
+    return NULL;
+}
+
+static void run_tasks
+    (
+        worker_type * worker
+    )
+{
+    thread_pool_type  * pool;
+    task_type           task;
+    uint32_t            i;
+    boolean             found;
+
+    pool = worker->pool;
+
+    for( ;; )
+    {
+        found = pop_task( worker, &task );
+
+        /* Own deque is empty, go round the others starting with the next worker */
+        for( i = 1; !found && ( i < pool->worker_count ); ++i )
+        {
+            found = steal_task( &pool->workers[( worker->index + i ) % pool->worker_count], &task );
+        }
+
+        if( !found )
+        {
+            return;
+        }
+
+        task.task_cb( task.user_data, task.first, task.last, worker->index );
+
+        pthread_mutex_lock( &pool->lock );
+        pool->pending_tasks -= 1;
+        if( 0 == pool->pending_tasks )
+        {
+            pthread_cond_signal( &pool->work_done );
+        }
+        pthread_mutex_unlock( &pool->lock );
+    }
+}
+
+static boolean pop_task
+    (
+        worker_type * worker,
+        task_type   * task
+    )
+{
+    boolean found;
+
+    pthread_mutex_lock( &worker->lock );
+
+    found = ( worker->bottom > worker->top );
+    if( found )
+    {
+        *task = worker->tasks[--worker->bottom];
+    }
+
+    pthread_mutex_unlock( &worker->lock );
+
+    return found;
+}
+
+static boolean steal_task
+    (
+        worker_type * victim,
+        task_type   * task
+    )
+{
+    boolean found;
+
+    pthread_mutex_lock( &victim->lock );
+
+    found = ( victim->bottom > victim->top );
+    if( found )
+    {
+        *task = victim->tasks[victim->top++];
+    }
+
+    pthread_mutex_unlock( &victim->lock );
+
+    return found;
+}
+
+static void pin_to_core
+    (
+        uint32_t core
+    )
+{
+    uint32_t core_count;
+
+    core_count = thread_pool_core_count();
+
+#if defined( _WIN32 )
+    SetThreadAffinityMask( GetCurrentThread(), (DWORD_PTR)1 << ( core % core_count ) );
+#elif defined( __linux__ )
+    {
+        cpu_set_t cpus;
+
+        CPU_ZERO( &cpus );
+        CPU_SET( core % core_count, &cpus );
+        pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus );
+    }
+#else
+    (void)core_count;
+#endif
+}
@@ -0,0 +1,99 @@
+/**
+ * @file thread_pool.h
+ *
+ * @brief Work stealing thread pool for data parallel loops
+ *
+ * Each worker owns a deque of tasks. A worker pops from the back of its own
+ * deque, and when that runs dry steals from the front of the others, so an
+ * unevenly loaded loop still keeps every core busy. The thread that calls
+ * thread_pool_parallel_for takes part as worker 0.
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define THREAD_POOL_WORKERS_AUTO    ( 0 )   /* One worker per online core */
+#define THREAD_POOL_GRAIN_AUTO      ( 0 )   /* A few tasks per worker, enough to balance */
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/**
+ * @brief Process items [first, last) of a parallel loop
+ */
+typedef void (*thread_pool_task_cb)
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index    /* In [0, thread_pool_worker_count), for per worker scratch */
+    );
+
+/* Pool type, should only be accessed with interface functions below */
+typedef struct thread_pool_struct thread_pool_type;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocates a pool and starts its worker threads
+ */
+thread_pool_type * thread_pool_create
+    (
+        uint32_t    worker_count,   /* Including the calling thread, THREAD_POOL_WORKERS_AUTO for one per core */
+        boolean     pin_workers     /* Pin worker i to core i, keeps caches warm on big nodes. Worker 0 is
+                                       the thread issuing each loop, it is pinned when it first issues one */
+    );
+
+/**
+ * @brief Stops the worker threads and deletes a pool
+ */
+void thread_pool_free
+    (
+        thread_pool_type * pool
+    );
+
+/**
+ * @brief Gets the number of workers, including the calling thread
+ */
+uint32_t thread_pool_worker_count
+    (
+        thread_pool_type const * pool
+    );
+
+/**
+ * @brief Split [0, count) into tasks of grain items, run them on every
+ *        worker and return once all of them are done.
+ *
+ * @note Only one thread may issue work to a pool at a time, and a task
+ *       may not issue more work to its own pool.
+ */
+void thread_pool_parallel_for
+    (
+        thread_pool_type    * pool,
+        uint32_t              count,
+        uint32_t              grain,
+        thread_pool_task_cb   task_cb,
+        void                * user_data
+    );
+
+/**
+ * @brief Gets the number of online cores
+ */
+uint32_t thread_pool_core_count
+    (
+        void
+    );
+
+#endif /* THREAD_POOL_H */
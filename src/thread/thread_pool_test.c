@@ -0,0 +1,118 @@
+/**
+ * @file thread_pool_test.c
+ *
+ * @brief Tests of the work stealing thread pool
+ */
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "thread_pool_test.h"
+#include "thread_pool.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define STRESS_WORKER_COUNT     ( 4 )
+#define STRESS_ITEM_COUNT       ( 64 )
+#define STRESS_LOOP_COUNT       ( 200000 )  /* The lost wakeup this guards against took ~20k loops to hit */
+
+/**********************************************************************
+                            PROTOTYPES
+**********************************************************************/
+
+static boolean back_to_back_test
+    (
+        void
+    );
+
+static void count_items
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    );
+
+/**********************************************************************
+                            FUNCTIONS
+**********************************************************************/
+
+boolean thread_pool_tests_run
+    (
+        void
+    )
+{
+    boolean passed;
+
+    passed = back_to_back_test();
+
+    return passed;
+}
+
+/**
+ * @brief Issue many small loops back to back, so workers from one loop are
+ *        still looking for tasks when the next one is pushed. Every item
+ *        must be visited exactly once per loop, and the test must not hang.
+ */
+static boolean back_to_back_test
+    (
+        void
+    )
+{
+    thread_pool_type  * pool;
+    uint32_t            visits[STRESS_ITEM_COUNT];
+    uint32_t            i;
+    boolean             passed;
+
+    printf( "Back to back parallel_for test start:\n" );
+
+    memset( visits, 0, sizeof( visits ) );
+    pool = thread_pool_create( STRESS_WORKER_COUNT, FALSE );
+
+    for( i = 0; i < STRESS_LOOP_COUNT; ++i )
+    {
+        thread_pool_parallel_for( pool, STRESS_ITEM_COUNT, 1, count_items, visits );
+    }
+
+    thread_pool_free( pool );
+
+    passed = TRUE;
+    for( i = 0; i < STRESS_ITEM_COUNT; ++i )
+    {
+        if( STRESS_LOOP_COUNT != visits[i] )
+        {
+            printf( "item %d visited %d times\n", i, visits[i] );
+            passed = FALSE;
+        }
+    }
+
+    printf( "%s\n", passed ? "PASS" : "FAIL" );
+
+    return passed;
+}
+
+static void count_items
+    (
+        void      * user_data,
+        uint32_t    first,
+        uint32_t    last,
+        uint32_t    worker_index
+    )
+{
+    uint32_t  * visits;
+    uint32_t    i;
+
+    (void)worker_index;
+    visits = (uint32_t *)user_data;
+
+    /* Each item belongs to one task, so no two threads write the same count */
+    for( i = first; i < last; ++i )
+    {
+        visits[i] += 1;
+    }
+}
@@ -0,0 +1,29 @@
+/**
+ * @file thread_pool_test.h
+ *
+ * @brief Interface to the thread pool test suite
+ */
+#ifndef THREAD_POOL_TEST_H
+#define THREAD_POOL_TEST_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Runs the thread pool tests
+ *
+ * @return TRUE if they all passed
+ */
+boolean thread_pool_tests_run
+    (
+        void
+    );
+
+#endif /* THREAD_POOL_TEST_H */
@@ -0,0 +1,139 @@
+/**
+ * @file triple_buffer.c
+ *
+ * @brief Implementation of the lock-free triple buffer
+ */
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "triple_buffer.h"
+#include "common_util.h"
+#include <stdlib.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define SHARED_INDEX_MASK   ( 0x03 )
+#define SHARED_FRESH        ( 0x04 )    /* The shared item was published and the reader hasn't taken it yet */
+
+/**********************************************************************
+                               TYPES
+**********************************************************************/
+
+/*
+ * Each side owns one item, the third is shared. Publishing and reading both
+ * swap their own item with the shared one in a single atomic exchange.
+ */
+struct triple_buffer_struct
+{
+    uint8_t           * items;
+    uint32_t            item_size;
+    uint32_t            shared;         /* Index of the shared item, and SHARED_FRESH. Only accessed atomically */
+    uint32_t            write_index;    /* Owned by the writer */
+    uint32_t            read_index;     /* Owned by the reader */
+    boolean             has_read;       /* Owned by the reader, read_index holds a published item */
+};
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Swap in a new value for the shared index, with full ordering so
+ *        the item contents are visible to whoever takes it next
+ */
+static uint32_t exchange_shared
+    (
+        triple_buffer_type    * buffer,
+        uint32_t                value
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+triple_buffer_type * triple_buffer_create
+    (
+        uint32_t item_size
+    )
+{
+    triple_buffer_type * buffer;
+
+    buffer = calloc( 1, sizeof( triple_buffer_type ) );
+
+    buffer->items       = calloc( TRIPLE_BUFFER_ITEM_COUNT, item_size );
+    buffer->item_size   = item_size;
+    buffer->write_index = 0;
+    buffer->shared      = 1;
+    buffer->read_index  = 2;
+
+    return buffer;
+}
+
+void triple_buffer_free
+    (
+        triple_buffer_type * buffer
+    )
+{
+    free( buffer->items );
+    free( buffer );
+}
+
+void * triple_buffer_item
+    (
+        triple_buffer_type    * buffer,
+        uint32_t                index
+    )
+{
+    ASSERT( index < TRIPLE_BUFFER_ITEM_COUNT );
+
+    return &buffer->items[index * buffer->item_size];
+}
+
+void * triple_buffer_write_item
+    (
+        triple_buffer_type * buffer
+    )
+{
+    return &buffer->items[buffer->write_index * buffer->item_size];
+}
+
+void triple_buffer_publish
+    (
+        triple_buffer_type * buffer
+    )
+{
+    /* Whatever was shared, fresh or skipped, becomes the next item to fill */
+    buffer->write_index = exchange_shared( buffer, buffer->write_index | SHARED_FRESH ) & SHARED_INDEX_MASK;
+}
+
+void const * triple_buffer_read
+    (
+        triple_buffer_type * buffer
+    )
+{
+    uint32_t shared;
+
+    /* Only the writer sets the flag, so checking first saves an exchange when nothing new was published */
+    shared = __atomic_load_n( &buffer->shared, __ATOMIC_ACQUIRE );
+
+    if( 0 != ( shared & SHARED_FRESH ) )
+    {
+        buffer->read_index  = exchange_shared( buffer, buffer->read_index ) & SHARED_INDEX_MASK;
+        buffer->has_read    = TRUE;
+    }
+
+    return buffer->has_read ? &buffer->items[buffer->read_index * buffer->item_size] : NULL;
+}
+
+static uint32_t exchange_shared
+    (
+        triple_buffer_type    * buffer,
+        uint32_t                value
+    )
+{
+    return __atomic_exchange_n( &buffer->shared, value, __ATOMIC_ACQ_REL );
+}
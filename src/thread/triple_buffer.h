@@ -0,0 +1,90 @@
+/**
+ * @file triple_buffer.h
+ *
+ * @brief Lock-free single producer, single consumer triple buffer
+ *
+ * The writer fills a back item and publishes it, the reader takes the most
+ * recently published item. Neither side ever waits on the other: the writer
+ * always has a free item to fill and the reader always has a complete item
+ * to look at, items published while the reader is busy are just skipped.
+ */
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define TRIPLE_BUFFER_ITEM_COUNT    ( 3 )
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/* Triple buffer type, should only be accessed with interface functions below */
+typedef struct triple_buffer_struct triple_buffer_type;
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocates a triple buffer of zeroed items
+ */
+triple_buffer_type * triple_buffer_create
+    (
+        uint32_t item_size
+    );
+
+/**
+ * @brief Deletes a triple buffer
+ */
+void triple_buffer_free
+    (
+        triple_buffer_type * buffer
+    );
+
+/**
+ * @brief Access any item, only for setting up or tearing down items while
+ *        neither side is running
+ */
+void * triple_buffer_item
+    (
+        triple_buffer_type    * buffer,
+        uint32_t                index   /* In [0, TRIPLE_BUFFER_ITEM_COUNT) */
+    );
+
+/**
+ * @brief Writer side, the item to fill before the next publish
+ */
+void * triple_buffer_write_item
+    (
+        triple_buffer_type * buffer
+    );
+
+/**
+ * @brief Writer side, hand the filled item over to the reader
+ */
+void triple_buffer_publish
+    (
+        triple_buffer_type * buffer
+    );
+
+/**
+ * @brief Reader side, the most recently published item. It stays valid
+ *        and unchanged until the next call.
+ *
+ * @return NULL if nothing has been published yet
+ */
+void const * triple_buffer_read
+    (
+        triple_buffer_type * buffer
+    );
+
+#endif /* TRIPLE_BUFFER_H */
@@ -0,0 +1,192 @@
+/**
+ * @file deque.c
+ *
+ * @brief Generic double ended queue implementation
+ */
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "deque.h"
+#include "common_util.h"
+#include <string.h>
+#include <stdlib.h>
+
+/**********************************************************************
+                            LITERAL CONSTANTS
+**********************************************************************/
+
+#define DEQUE_DEFAULT_SIZE      16  /* Must be a power of 2 */
+#define DEQUE_GROWTH_FACTOR     2
+
+/**********************************************************************
+                            PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Reallocates the internal buffer to new_size, moving element 0 to slot 0
+ */
+static void resize
+    (
+        deque_type    * deque,
+        uint32_t        new_size
+    );
+
+/**
+ * @brief Gets the memory of a slot of the ring buffer
+ */
+static uint8_t * slot
+    (
+        deque_type const  * deque,
+        uint32_t            slot_index  /* Wrapped to the ring */
+    );
+
+/**********************************************************************
+                             FUNCTIONS
+**********************************************************************/
+
+deque_type * deque_init
+    (
+        uint16_t  item_size
+    )
+{
+    deque_type * deque;
+
+    deque = (deque_type *)calloc( 1, sizeof( deque_type ) );
+
+    deque->item_size = item_size;
+
+    resize( deque, DEQUE_DEFAULT_SIZE );
+
+    return deque;
+}
+
+void deque_deinit
+    (
+        deque_type      * deque
+    )
+{
+    free( deque->list_items );
+    free( deque );
+}
+
+uint32_t deque_size
+    (
+        deque_type const * deque
+    )
+{
+    return deque->item_count;
+}
+
+void deque_push_back
+    (
+        deque_type      * deque,
+        void      const * item
+    )
+{
+    if( deque->item_count >= deque->list_max )
+    {
+        resize( deque, deque->list_max * DEQUE_GROWTH_FACTOR );
+    }
+
+    memcpy( slot( deque, deque->head + deque->item_count ), item, deque->item_size );
+    deque->item_count += 1;
+}
+
+void deque_push_front
+    (
+        deque_type      * deque,
+        void      const * item
+    )
+{
+    if( deque->item_count >= deque->list_max )
+    {
+        resize( deque, deque->list_max * DEQUE_GROWTH_FACTOR );
+    }
+
+    /* Unsigned wrap of head - 1 is masked back into the ring */
+    deque->head = ( deque->head - 1 ) & ( deque->list_max - 1 );
+    memcpy( slot( deque, deque->head ), item, deque->item_size );
+    deque->item_count += 1;
+}
+
+void deque_pop_front
+    (
+        deque_type      * deque,
+        void            * item
+    )
+{
+    ASSERT( deque->item_count > 0 );
+
+    memcpy( item, slot( deque, deque->head ), deque->item_size );
+    deque->head = ( deque->head + 1 ) & ( deque->list_max - 1 );
+    deque->item_count -= 1;
+}
+
+void deque_pop_back
+    (
+        deque_type      * deque,
+        void            * item
+    )
+{
+    ASSERT( deque->item_count > 0 );
+
+    deque->item_count -= 1;
+    memcpy( item, slot( deque, deque->head + deque->item_count ), deque->item_size );
+}
+
+void * deque_access_untyped
+    (
+        deque_type const  * deque,
+        uint32_t            index
+    )
+{
+    return (void *)slot( deque, deque->head + index );
+}
+
+void deque_empty
+    (
+        deque_type      * deque
+    )
+{
+    deque->item_count = 0;
+    deque->head = 0;
+    resize( deque, DEQUE_DEFAULT_SIZE );
+}
+
+static void resize
+    (
+        deque_type    * deque,
+        uint32_t        new_size
+    )
+{
+    uint8_t   * new_array;
+    uint32_t    first_run;
+
+    ASSERT( new_size >= deque->item_count );
+
+    new_array = (uint8_t *)malloc( (size_t)new_size * deque->item_size );
+
+    /* The elements may wrap past the end of the old buffer, copy them as two runs */
+    if( deque->item_count > 0 )
+    {
+        first_run = MIN( deque->item_count, deque->list_max - deque->head );
+        memcpy( new_array, slot( deque, deque->head ), (size_t)first_run * deque->item_size );
+        memcpy( new_array + (size_t)first_run * deque->item_size, deque->list_items, (size_t)( deque->item_count - first_run ) * deque->item_size );
+    }
+
+    free( deque->list_items );
+
+    deque->list_items   = new_array;
+    deque->list_max     = new_size;
+    deque->head         = 0;
+}
+
+static uint8_t * slot
+    (
+        deque_type const  * deque,
+        uint32_t            slot_index
+    )
+{
+    return &deque->list_items[(size_t)( slot_index & ( deque->list_max - 1 ) ) * deque->item_size];
+}
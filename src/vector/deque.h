@@ -0,0 +1,133 @@
+/**
+ * @file deque.h
+ *
+ * @brief Generic double ended queue interface
+ *
+ * Same element interface as vector.h, but stored as a ring buffer so
+ * pushing and popping at either end are amortized O(1). Elements are
+ * not contiguous, use a vector for anything that is handed to openGL
+ * or memcpy'd as a block.
+ */
+#ifndef DEQUE_H
+#define DEQUE_H
+
+/**********************************************************************
+                            GENERAL INCLUDES
+**********************************************************************/
+
+#include "common_types.h"
+
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+/* Deque type, should only be accessed with interface functions below */
+typedef struct deque_struct
+{
+    uint8_t       * list_items;
+    uint32_t        head;       /* Slot of element 0 */
+    uint32_t        item_count;
+    uint32_t        list_max;   /* Always a power of 2, so slots wrap with a mask */
+    uint16_t        item_size;
+} deque_type;
+
+/**********************************************************************
+                                MACROS
+**********************************************************************/
+
+/**
+ * @brief Access a pointer to an element of a deque
+ *
+ * @param type
+ *            The type of elements stored in the deque
+ *
+ * @return
+ *            An element of type type*
+ */
+#define deque_access( deque, index, type ) ( ( type* )deque_access_untyped( deque, index ) )
+
+/**********************************************************************
+                             PROTOTYPES
+**********************************************************************/
+
+/**
+ * @brief Allocates and returns a new deque
+ */
+deque_type * deque_init
+    (
+        uint16_t  item_size
+    );
+
+/**
+ * @brief Deletes an existing deque
+ */
+void deque_deinit
+    (
+        deque_type      * deque
+    );
+
+/**
+ * @brief Gets the size of a deque
+ */
+uint32_t deque_size
+    (
+        deque_type const * deque
+    );
+
+/**
+ * @brief Appends an element to the end of a deque
+ */
+void deque_push_back
+    (
+        deque_type      * deque,
+        void      const * item
+    );
+
+/**
+ * @brief Appends an element to the front of a deque
+ */
+void deque_push_front
+    (
+        deque_type      * deque,
+        void      const * item
+    );
+
+/**
+ * @brief Pops an element off the front of a deque
+ */
+void deque_pop_front
+    (
+        deque_type      * deque,
+        void            * item /* [out] The popped element */
+    );
+
+/**
+ * @brief Pops an element off the back of a deque
+ */
+void deque_pop_back
+    (
+        deque_type      * deque,
+        void            * item /* [out] The popped element */
+    );
+
+/**
+ * @brief Access an element from the deque, 0 is the front
+ *
+ * @return A pointer to the internal memory that holds the element
+ * (Any deque push may reallocate this memory, so the pointer should be fetched every use)
+ */
+void * deque_access_untyped
+    (
+        deque_type const  * deque,
+        uint32_t            index
+    );
+
+/**
+ * @brief Clears the deque
+ */
+void deque_empty
+    (
+        deque_type      * deque
+    );
+
+#endif /* DEQUE_H */
@@ -24,7 +24,7 @@
 **********************************************************************/
 
 /**
- * @brief Reallocates the internal buffer to new_size
+ * @brief Reallocates the internal buffer to new_size, new slots are not zeroed
  */
 static void resize
     (
@@ -33,7 +33,17 @@ static void resize
     );
 
 /**
- * @brief Shifts the elements of the array, either deleting
+ * @brief Makes room for at least min_count items, growing geometrically
+ *        so repeated appends stay amortized O(1)
+ */
+static void grow
+    (
+        vector_type   * vector,
+        uint32_t        min_count
+    );
+
+/**
+ * @brief Shifts the elements of the array in place, either deleting
  * them from the front or opening up new slots at the front
  */
 static void shift_items
@@ -63,11 +73,36 @@ vector_type * vector_init
     return vector;
 }
 
+vector_type * vector_init_arena
+    (
+        uint16_t          item_size,
+        arena_type      * arena
+    )
+{
+    vector_type * vector;
+
+    vector = (vector_type *)arena_alloc( arena, sizeof( vector_type ) );
+    memset( vector, 0, sizeof( vector_type ) );
+
+    vector->item_size = item_size;
+    vector->arena = arena;
+
+    resize( vector, VECTOR_DEFAULT_SIZE );
+
+    return vector;
+}
+
 void vector_deinit
     (
         vector_type     * vector
     )
 {
+    /* Arena memory goes back when the arena is reset */
+    if( NULL != vector->arena )
+    {
+        return;
+    }
+
     if( NULL != vector->list_items )
     {
         free( vector->list_items );
@@ -94,7 +129,7 @@ void vector_push_back
 
     if( vector->item_count >= vector->list_max )
     {
-        resize( vector, vector->list_max * VECTOR_GROWTH_FACTOR );
+        grow( vector, vector->item_count + 1 );
     }
 
     new_item_buffer = vector_access_untyped( vector, vector->item_count );
@@ -122,17 +157,34 @@ void vector_push_back_many
         uint32_t          count
     )
 {
-    uint8_t     * items_local;
-    uint32_t      i;
+    grow( vector, vector->item_count + count );
 
-    items_local = (uint8_t *)items;
+    memcpy( vector_access_untyped( vector, vector->item_count ), items, (size_t)vector->item_size * count );
+    vector->item_count += count;
+}
 
-    for( i = 0; i < count; ++i )
+void vector_reserve
+    (
+        vector_type     * vector,
+        uint32_t          capacity
+    )
+{
+    if( capacity > vector->list_max )
     {
-        vector_push_back( vector, items_local + vector->item_size * i );
+        resize( vector, capacity );
     }
 }
 
+void vector_resize_uninitialized
+    (
+        vector_type     * vector,
+        uint32_t          count
+    )
+{
+    grow( vector, count );
+    vector->item_count = count;
+}
+
 void vector_pop_front
     (
         vector_type     * vector,
@@ -184,29 +236,35 @@ static void resize
         uint32_t        new_size
     )
 {
-    uint32_t    old_elements_to_copy_count;
-    void      * new_array;
-
-    if ( 0 == new_size )
+    if( NULL != vector->arena )
     {
-        new_array = NULL;
+        vector->list_items = arena_realloc( vector->arena, vector->list_items, (size_t)vector->list_max * vector->item_size, (size_t)new_size * vector->item_size );
+    }
+    else if ( 0 == new_size )
+    {
+        free( vector->list_items );
+        vector->list_items = NULL;
     }
     else
     {
-        new_array = calloc( new_size, vector->item_size );
+        /* Every slot past item_count is written before it is read, so there's no need to zero them */
+        vector->list_items = realloc( vector->list_items, (size_t)new_size * vector->item_size );
     }
 
-    old_elements_to_copy_count = MIN( vector->item_count, new_size );
-    memcpy( new_array, vector->list_items, vector->item_size * old_elements_to_copy_count );
+    vector->list_max = new_size;
+    vector->item_count = MIN( vector->item_count, new_size );
+}
 
-    if( NULL != vector->list_items )
+static void grow
+    (
+        vector_type   * vector,
+        uint32_t        min_count
+    )
+{
+    if( min_count > vector->list_max )
     {
-        free( vector->list_items );
+        resize( vector, MAX( vector->list_max * VECTOR_GROWTH_FACTOR, min_count ) );
     }
-
-    vector->list_max = new_size;
-    vector->item_count = old_elements_to_copy_count;
-    vector->list_items = new_array;
 }
 
 static void shift_items
@@ -216,47 +274,51 @@ static void shift_items
         boolean         direction /* TRUE for forward */
     )
 {
-    uint8_t * new_list_items;
-    uint32_t new_size;
     uint32_t memory_offset;
 
-    /* Calculate the minimum new size */
-    if( direction )
-    {
-        new_size = vector->item_count + amount_of_shift;
-    }
-    else if( amount_of_shift < vector->item_count )
+    if( !direction && ( amount_of_shift >= vector->item_count ) )
     {
-        new_size = vector->item_count - amount_of_shift;
-    }
-    else
-    {
-        /* The request is to shift the entire array off the front, empty and return */
-        new_size = VECTOR_DEFAULT_SIZE;
+        /* The request is to shift the entire array off the front */
         vector->item_count = 0;
-        resize( vector, new_size );
         return;
     }
 
-    vector->list_max = new_size;
+    /* Grow geometrically like push_back, so only the move is paid per call */
+    if( direction )
+    {
+        grow( vector, vector->item_count + amount_of_shift );
+    }
 
-    /* Copy the elements over and re-assign the array */
-    new_list_items = calloc( vector->list_max, vector->item_size );
-    memory_offset =  amount_of_shift * vector->item_size;
+    memory_offset = amount_of_shift * vector->item_size;
 
     if( direction )
     {
-        memcpy( new_list_items + memory_offset, vector->list_items, vector->item_size * vector->item_count );
+        memmove( vector->list_items + memory_offset, vector->list_items, vector->item_size * vector->item_count );
+        vector->item_count += amount_of_shift;
     }
     else
     {
-        memcpy( new_list_items, vector->list_items + memory_offset, ( vector->item_count - amount_of_shift ) * vector->item_size );
+        vector->item_count -= amount_of_shift;
+        memmove( vector->list_items, vector->list_items + memory_offset, vector->item_size * vector->item_count );
     }
+}
 
-    vector->item_count = new_size;
+void * vector_grow_buffer
+    (
+        void            * items,
+        uint32_t        * list_max,
+        uint32_t          min_count,
+        size_t            item_size
+    )
+{
+    uint32_t new_size;
 
-    free( vector->list_items );
-    vector->list_items = new_list_items;
+    new_size = MAX( *list_max * VECTOR_GROWTH_FACTOR, VECTOR_DEFAULT_SIZE );
+    new_size = MAX( new_size, min_count );
+
+    *list_max = new_size;
+
+    return realloc( items, (size_t)new_size * item_size );
 }
 
 void vector_empty
@@ -274,21 +336,72 @@ void vector_remove
         void      const * target
     )
 {
-    uint32_t len;
-    uint32_t i;
+    uint32_t    kept;
+    uint32_t    i;
+    uint8_t   * item;
 
-    len = vector_size( vector );
-    for( i = 0; i < len; ++i )
+    /* Compact the kept items down in one pass, each item moves at most once */
+    kept = 0;
+    for( i = 0; i < vector->item_count; ++i )
     {
-        uint8_t * item;
+        item = (uint8_t *)vector_access_untyped( vector, i );
+
+        if( 0 != memcmp( item, target, vector->item_size ) )
+        {
+            if( kept != i )
+            {
+                memcpy( vector_access_untyped( vector, kept ), item, vector->item_size );
+            }
 
+            kept += 1;
+        }
+    }
+
+    vector->item_count = kept;
+}
+
+void vector_remove_if
+    (
+        vector_type           * vector,
+        vector_predicate_type   predicate,
+        void                  * context
+    )
+{
+    uint32_t    kept;
+    uint32_t    i;
+    uint8_t   * item;
+
+    kept = 0;
+    for( i = 0; i < vector->item_count; ++i )
+    {
         item = (uint8_t *)vector_access_untyped( vector, i );
 
-        if( 0 == memcmp( item, target, vector->item_size ) )
+        if( !predicate( item, context ) )
         {
-            len -= 1;
-            vector->item_count -= 1;
-            memcpy( item, item + vector->item_size, vector->item_size * ( len - i ) );
+            if( kept != i )
+            {
+                memcpy( vector_access_untyped( vector, kept ), item, vector->item_size );
+            }
+
+            kept += 1;
         }
     }
+
+    vector->item_count = kept;
+}
+
+void vector_swap_remove
+    (
+        vector_type     * vector,
+        uint32_t          index
+    )
+{
+    ASSERT( index < vector->item_count );
+
+    vector->item_count -= 1;
+
+    if( index != vector->item_count )
+    {
+        memcpy( vector_access_untyped( vector, index ), vector_access_untyped( vector, vector->item_count ), vector->item_size );
+    }
 }
\ No newline at end of file
@@ -11,11 +11,26 @@
 **********************************************************************/
 
 #include "common_types.h"
+#include "common_util.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
 
 /**********************************************************************
                                 TYPES
 **********************************************************************/
 
+/**
+ * @brief Test for vector_remove_if
+ *
+ * @return TRUE to remove the item
+ */
+typedef boolean (*vector_predicate_type)
+    (
+        void      const * item,
+        void            * context
+    );
+
 /* Vector type, should only be accessed with interface functions below */
 typedef struct vector_struct
 {
@@ -23,6 +38,7 @@ typedef struct vector_struct
     uint32_t        item_count;
     uint32_t        list_max;
     uint16_t        item_size;
+    arena_type    * arena;      /* Memory comes from here if set, otherwise from the heap */
 } vector_type;
 
 /**********************************************************************
@@ -40,6 +56,92 @@ typedef struct vector_struct
  */
 #define vector_access( vector, index, type ) ( ( type* )vector_access_untyped( vector, index ) )
 
+/**
+ * @brief Declare a vector specialized to one element type, for hot loops
+ *        where vector_access's call and runtime item size multiply cost too much
+ *
+ * VECTOR_DEFINE( vec3, vec3_type ) declares vec3_vector_type and inline
+ * functions vec3_vector_init, _deinit, _size, _at, _push_back, _pop_back,
+ * _reserve, _empty, _remove_at and _swap_remove_at. Accesses compile to plain pointer
+ * arithmetic, items can also be read directly through the items array.
+ * The vector is held by value, call _init before use and _deinit after.
+ *
+ * @param name
+ *            Prefix of the generated type and functions
+ * @param type
+ *            The type of elements stored in the vector
+ */
+#define VECTOR_DEFINE( name, type )                                                             \
+    typedef struct name##_vector_struct                                                         \
+    {                                                                                           \
+        type          * items;                                                                  \
+        uint32_t        item_count;                                                             \
+        uint32_t        list_max;                                                               \
+    } name##_vector_type;                                                                       \
+                                                                                                \
+    static INLINE void name##_vector_init( name##_vector_type * vector )                        \
+    {                                                                                           \
+        vector->items       = NULL;                                                             \
+        vector->item_count  = 0;                                                                \
+        vector->list_max    = 0;                                                                \
+    }                                                                                           \
+                                                                                                \
+    static INLINE void name##_vector_deinit( name##_vector_type * vector )                      \
+    {                                                                                           \
+        free( vector->items );                                                                  \
+        name##_vector_init( vector );                                                           \
+    }                                                                                           \
+                                                                                                \
+    static INLINE uint32_t name##_vector_size( name##_vector_type const * vector )              \
+    {                                                                                           \
+        return vector->item_count;                                                              \
+    }                                                                                           \
+                                                                                                \
+    static INLINE type * name##_vector_at( name##_vector_type const * vector, uint32_t index )  \
+    {                                                                                           \
+        return &vector->items[index];                                                           \
+    }                                                                                           \
+                                                                                                \
+    static INLINE void name##_vector_reserve( name##_vector_type * vector, uint32_t capacity )  \
+    {                                                                                           \
+        if( capacity > vector->list_max )                                                       \
+        {                                                                                       \
+            vector->items = (type *)vector_grow_buffer( vector->items, &vector->list_max,       \
+                                                        capacity, sizeof( type ) );             \
+        }                                                                                       \
+    }                                                                                           \
+                                                                                                \
+    static INLINE void name##_vector_push_back( name##_vector_type * vector, type const * item ) \
+    {                                                                                           \
+        name##_vector_reserve( vector, vector->item_count + 1 );                                \
+        vector->items[vector->item_count++] = *item;                                            \
+    }                                                                                           \
+                                                                                                \
+    static INLINE void name##_vector_pop_back( name##_vector_type * vector, type * item )       \
+    {                                                                                           \
+        ASSERT( vector->item_count > 0 );                                                       \
+        *item = vector->items[--vector->item_count];                                            \
+    }                                                                                           \
+                                                                                                \
+    static INLINE void name##_vector_empty( name##_vector_type * vector )                       \
+    {                                                                                           \
+        vector->item_count = 0;                                                                 \
+    }                                                                                           \
+                                                                                                \
+    static INLINE void name##_vector_remove_at( name##_vector_type * vector, uint32_t index )   \
+    {                                                                                           \
+        ASSERT( index < vector->item_count );                                                   \
+        vector->item_count -= 1;                                                                \
+        memmove( &vector->items[index], &vector->items[index + 1],                              \
+                 ( vector->item_count - index ) * sizeof( type ) );                             \
+    }                                                                                           \
+                                                                                                \
+    static INLINE void name##_vector_swap_remove_at( name##_vector_type * vector, uint32_t index ) \
+    {                                                                                           \
+        ASSERT( index < vector->item_count );                                                   \
+        vector->items[index] = vector->items[--vector->item_count];                             \
+    }
+
 /**********************************************************************
                              PROTOTYPES
 **********************************************************************/
@@ -52,6 +154,18 @@ vector_type * vector_init
         uint16_t  item_size
     );
 
+/**
+ * @brief Allocates and returns a new vector that lives in an arena
+ *
+ * The vector and its items are released with the arena, deinit is optional.
+ * For transient vectors, e.g. while loading a file or during one frame.
+ */
+vector_type * vector_init_arena
+    (
+        uint16_t          item_size,
+        arena_type      * arena
+    );
+
 /**
  * @brief Deletes an existing vector
  */
@@ -79,6 +193,8 @@ void vector_push_back
 
 /**
  * @brief Appends an element to the front of a vector
+ *
+ * Moves every element, use a deque (deque.h) for queues
  */
 void vector_push_front
     (
@@ -87,7 +203,7 @@ void vector_push_front
     );
 
 /**
- * @brief Append several items onto a vector
+ * @brief Append several items onto a vector, with at most one reallocation
  */
 void vector_push_back_many
     (
@@ -96,8 +212,30 @@ void vector_push_back_many
         uint32_t          count
     );
 
+/**
+ * @brief Allocates room for capacity items, so the vector won't reallocate
+ *        until it grows past that. Never shrinks the vector.
+ */
+void vector_reserve
+    (
+        vector_type     * vector,
+        uint32_t          capacity
+    );
+
+/**
+ * @brief Sets the number of items in the vector, items past the old size
+ *        are left uninitialized for the caller to fill in place
+ */
+void vector_resize_uninitialized
+    (
+        vector_type     * vector,
+        uint32_t          count
+    );
+
 /**
  * @brief Pops an element off the front of a vector
+ *
+ * Moves every element, use a deque (deque.h) for queues
  */
 void vector_pop_front
     (
@@ -134,8 +272,23 @@ void vector_empty
         vector_type     * vector
     );
 
-/*
- * @brief Removes all elements that equal target from the vector
+/**
+ * @brief Grows the buffer of a VECTOR_DEFINE vector to hold at least min_count
+ *        items, geometrically so repeated appends stay amortized O(1)
+ *
+ * @return The reallocated buffer, list_max is updated to its capacity
+ */
+void * vector_grow_buffer
+    (
+        void            * items,
+        uint32_t        * list_max,     /* [in/out] */
+        uint32_t          min_count,
+        size_t            item_size
+    );
+
+/**
+ * @brief Removes all elements that equal target from the vector, keeping
+ *        the order of the rest. One pass over the vector.
  */
 void vector_remove
     (
@@ -143,4 +296,25 @@ void vector_remove
         void      const * target
     );
 
+/**
+ * @brief Removes all elements predicate returns TRUE for, keeping the order
+ *        of the rest. One pass over the vector.
+ */
+void vector_remove_if
+    (
+        vector_type           * vector,
+        vector_predicate_type   predicate,
+        void                  * context     /* Passed to every predicate call */
+    );
+
+/**
+ * @brief Removes an element in O(1) by moving the last element into its
+ *        place, for vectors whose order doesn't matter
+ */
+void vector_swap_remove
+    (
+        vector_type     * vector,
+        uint32_t          index
+    );
+
 #endif /* VECTOR_H */
@@ -8,9 +8,16 @@
 **********************************************************************/
 
 #include "vector.h"
+#include "deque.h"
 
 #include <stdio.h>
 
+/**********************************************************************
+                                TYPES
+**********************************************************************/
+
+VECTOR_DEFINE( uint32, uint32_t )
+
 /**********************************************************************
                             PROTOTYPES
 **********************************************************************/
@@ -40,11 +47,36 @@ static void pop_front_test
         void
     );
 
+static void push_back_many_test
+    (
+        void
+    );
+
 static void remove_test
     (
         void
     );
 
+static void remove_if_test
+    (
+        void
+    );
+
+static void deque_test
+    (
+        void
+    );
+
+static void typed_vector_test
+    (
+        void
+    );
+
+static void arena_vector_test
+    (
+        void
+    );
+
 /**********************************************************************
                             FUNCTIONS
 **********************************************************************/
@@ -58,7 +90,12 @@ void vector_tests_run
     push_front_test();
     pop_front_test();
     pop_back_test();
+    push_back_many_test();
     remove_test();
+    remove_if_test();
+    deque_test();
+    typed_vector_test();
+    arena_vector_test();
 }
 
 static void push_back_test
@@ -159,6 +196,40 @@ static void pop_front_test
     vector_deinit( vector );
 }
 
+static void push_back_many_test
+    (
+        void
+    )
+{
+    vector_type   * vector;
+    uint32_t        items[15];
+    uint32_t        i;
+
+    printf( "Push back many test start:\n" );
+
+    vector = vector_init( sizeof( uint32_t ) );
+
+    for( i = 0; i < 15; ++i )
+    {
+        items[i] = i;
+    }
+
+    /* Both pushes outgrow the vector, the second after a reserve */
+    vector_push_back_many( vector, items, 15 );
+    vector_reserve( vector, 40 );
+    vector_push_back_many( vector, items, 15 );
+
+    /* Fill the tail in place */
+    vector_resize_uninitialized( vector, 35 );
+    for( i = 30; i < 35; ++i )
+    {
+        *vector_access( vector, i, uint32_t ) = 100 + i;
+    }
+
+    print_vector( vector );
+    vector_deinit( vector );
+}
+
 static void remove_test
     (
         void
@@ -190,6 +261,169 @@ static void remove_test
     vector_deinit( vector );
 }
 
+static boolean is_multiple_of_3
+    (
+        void const * item,
+        void       * context
+    )
+{
+    (void)context;
+    return 0 == *(uint32_t const *)item % 3;
+}
+
+static void remove_if_test
+    (
+        void
+    )
+{
+    vector_type   * vector;
+    uint32_t        i;
+    uint32_t        item;
+
+    printf( "Remove if test start:\n" );
+
+    vector = vector_init( sizeof( uint32_t ) );
+
+    for( i = 0; i < 20; ++i )
+    {
+        vector_push_back( vector, &i );
+    }
+
+    /* Runs of neighbouring matches must all go */
+    item = 7;
+    vector_push_back( vector, &item );
+    vector_push_back( vector, &item );
+    vector_remove( vector, &item );
+
+    vector_remove_if( vector, is_multiple_of_3, NULL );
+
+    print_vector( vector );
+
+    /* First and last */
+    vector_swap_remove( vector, 0 );
+    vector_swap_remove( vector, vector_size( vector ) - 1 );
+
+    print_vector( vector );
+
+    vector_deinit( vector );
+}
+
+static void deque_test
+    (
+        void
+    )
+{
+    deque_type    * deque;
+    uint32_t        i;
+    uint32_t        item;
+
+    printf( "Deque test start:\n" );
+
+    deque = deque_init( sizeof( uint32_t ) );
+
+    /* Used as a queue the front walks around the ring without growing it */
+    for( i = 0; i < 100; ++i )
+    {
+        deque_push_back( deque, &i );
+        deque_pop_front( deque, &item );
+    }
+
+    /* Pushing at both ends grows it with the elements wrapped past the end of the buffer */
+    for( i = 0; i < 20; ++i )
+    {
+        deque_push_front( deque, &i );
+        deque_push_back( deque, &i );
+    }
+
+    deque_pop_front( deque, &item );
+    printf( "Popped front: %d\n", item );
+    deque_pop_back( deque, &item );
+    printf( "Popped back: %d\n", item );
+
+    printf( "Start len: %d\n", deque_size( deque ) );
+
+    for( i = 0; i < deque_size( deque ); ++i )
+    {
+        printf( "%d: %d\n", i, *deque_access( deque, i, uint32_t ) );
+    }
+
+    deque_deinit( deque );
+}
+
+static void typed_vector_test
+    (
+        void
+    )
+{
+    uint32_vector_type  vector;
+    uint32_t            i;
+    uint32_t            item;
+
+    printf( "Typed vector test start:\n" );
+
+    uint32_vector_init( &vector );
+
+    for( i = 0; i < 20; ++i )
+    {
+        uint32_vector_push_back( &vector, &i );
+    }
+
+    /* Drop the odd items from the back down */
+    for( i = 19; i <= 19; i -= 2 )
+    {
+        uint32_vector_remove_at( &vector, i );
+    }
+
+    uint32_vector_pop_back( &vector, &item );
+    printf( "Popped: %d\n", item );
+
+    printf( "Start len: %d\n", uint32_vector_size( &vector ) );
+
+    for( i = 0; i < uint32_vector_size( &vector ); ++i )
+    {
+        printf( "%d: %d\n", i, *uint32_vector_at( &vector, i ) );
+    }
+
+    uint32_vector_deinit( &vector );
+}
+
+static void arena_vector_test
+    (
+        void
+    )
+{
+    arena_type        * arena;
+    arena_mark_type     mark;
+    vector_type       * vector;
+    vector_type       * scratch;
+    uint32_t            i;
+
+    printf( "Arena vector test start:\n" );
+
+    /* Small blocks, so the vectors outgrow them */
+    arena = arena_create( 64 );
+    vector = vector_init_arena( sizeof( uint32_t ), arena );
+
+    for( i = 0; i < 20; ++i )
+    {
+        vector_push_back( vector, &i );
+    }
+
+    mark = arena_mark( arena );
+
+    /* Scratch work after the mark, released without touching the vector */
+    for( i = 0; i < 3; ++i )
+    {
+        scratch = vector_init_arena( sizeof( uint32_t ), arena );
+        vector_push_back_many( scratch, vector_access( vector, 0, uint32_t ), 20 );
+        arena_reset_to_mark( arena, &mark );
+    }
+
+    print_vector( vector );
+
+    arena_free( arena );
+}
+
 static void print_vector( vector_type* vector )
 {
     uint32_t i;